@@ -1,5 +1,8 @@
 #include "AppGlobals.h"
-#include "VolumeWatcher.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSettings>
+#include <QStandardPaths>
 
 // This is just an example of how to use inline namespaces.
 // To use it:
@@ -12,8 +15,44 @@ const QColor AppGlobals::Colors::TextColor(0, 0, 0);
 // int maxItems = AppGlobals::MaxItems;
 const int AppGlobals::MaxItems = 100;
 
-// Global application-wide variable that holds /media or /media/$USER
-const QString AppGlobals::mediaPath = VolumeWatcher::getMediaPath();
+// Global application-wide variables that hold /media or /media/$USER and the name of the root disk;
+// determining them runs external commands, hence they are probed in the background at startup and remembered.
+// The icon provider reads them on the thread of the file system model while the probes set them on the GUI thread
+static QString probedMediaPath;
+static QString probedRootDiskName;
+static QMutex probedValuesMutex;
+
+QString AppGlobals::startupCachePath() {
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/Filer/startup.ini";
+}
+
+QString AppGlobals::mediaPath() {
+    QMutexLocker locker(&probedValuesMutex);
+    if (probedMediaPath.isEmpty()) {
+        probedMediaPath = QSettings(startupCachePath(), QSettings::IniFormat).value("mediaPath", "/media").toString();
+    }
+    return probedMediaPath;
+}
+
+void AppGlobals::setMediaPath(const QString& path) {
+    QMutexLocker locker(&probedValuesMutex);
+    probedMediaPath = path;
+    QSettings(startupCachePath(), QSettings::IniFormat).setValue("mediaPath", path);
+}
+
+QString AppGlobals::rootDiskName() {
+    QMutexLocker locker(&probedValuesMutex);
+    if (probedRootDiskName.isEmpty()) {
+        probedRootDiskName = QSettings(startupCachePath(), QSettings::IniFormat).value("rootDiskName", hardDiskName).toString();
+    }
+    return probedRootDiskName;
+}
+
+void AppGlobals::setRootDiskName(const QString& name) {
+    QMutexLocker locker(&probedValuesMutex);
+    probedRootDiskName = name;
+    QSettings(startupCachePath(), QSettings::IniFormat).setValue("rootDiskName", name);
+}
 
 // NOTE: VolumeWatcher can read the name of the start volume from the volume label
 const QString AppGlobals::hardDiskName = "Hard Disk";
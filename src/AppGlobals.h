@@ -2,6 +2,7 @@
 #define GLOBALS_H
 
 #include <QColor>
+#include <QString>
 
 class AppGlobals {
 public:
@@ -13,9 +14,28 @@ public:
 
     static const int MaxItems;
 
-    static const QString mediaPath;
+    /**
+     * @brief Returns /media or /media/$USER.
+     * @note Until the probe at startup has finished, the value found by the previous run is returned,
+     * so that this never waits for an external command. Safe to call from any thread.
+     */
+    static QString mediaPath();
+    static void setMediaPath(const QString& path);
+
     static const QString hardDiskName;
 
+    /**
+     * @brief Returns the name under which the root disk is shown.
+     * @note Like mediaPath(), the name found by the previous run until the probe at startup has finished.
+     */
+    static QString rootDiskName();
+    static void setRootDiskName(const QString& name);
+
+    /**
+     * @brief Returns the file in which results of slow probes are kept for the next start.
+     */
+    static QString startupCachePath();
+
     static const QString desktopPicturePath;
 };
 
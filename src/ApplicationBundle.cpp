@@ -39,6 +39,8 @@
 #include "SqshArchiveReader.h"
 
 #include <DesktopFile.h>
+#include "Trace.h"
+#include "Vfs.h"
 
 ApplicationBundle::ApplicationBundle(const QString& path)
         : m_path(path),
@@ -49,17 +51,20 @@ ApplicationBundle::ApplicationBundle(const QString& path)
           m_executable(),
           m_arguments()
 {
+    FILER_TRACE_SCOPE("application-bundle-probe");
+    Vfs* vfs = Vfs::instance();
     QFileInfo fileInfo(path);
-    if (!fileInfo.exists()) {
+    Vfs::Status status = vfs->status(path);
+    if (!status.exists) {
         return;
     }
 
     // Check if the path is an application bundle or AppDir
-    if (fileInfo.isDir()) {
+    if (status.isDirectory) {
         QDir dir(path);
         // qDebug() << "Checking if" << path << "is an application bundle or AppDir";
-        if (dir.exists("Resources")
-            && QFileInfo(dir.filePath(fileInfo.completeBaseName())).isExecutable()) {
+        if (vfs->exists(dir.filePath("Resources"))
+            && vfs->status(dir.filePath(fileInfo.completeBaseName())).isExecutable) {
             m_type = Type::AppBundle;
             // qDebug() << path << "is an application bundle";
             m_name = QFileInfo(dir.path()).completeBaseName();
@@ -70,22 +75,19 @@ ApplicationBundle::ApplicationBundle(const QString& path)
             QStringList filters;
             filters << m_name + ".png" << m_name + ".jpg" << m_name + ".svg" << m_name + ".svgz"
                     << m_name + ".ico" << m_name + ".icns";
-            resourcesDir.setNameFilters(filters);
-            if (resourcesDir.exists()) {
-                QStringList icons = resourcesDir.entryList();
-                qDebug() << icons;
-                if (icons.size() > 0) {
-                    m_icon = resourcesDir.filePath(icons.at(0));
-                }
+            QStringList icons = vfs->entries(resourcesDir.path(), filters);
+            qDebug() << icons;
+            if (icons.size() > 0) {
+                m_icon = resourcesDir.filePath(icons.at(0));
             }
             m_executable = dir.filePath(fileInfo.completeBaseName());
-        } else if (QFileInfo(dir.filePath("AppRun")).isExecutable()) {
+        } else if (vfs->status(dir.filePath("AppRun")).isExecutable) {
             m_type = Type::AppDir;
             // qDebug() << path << "is an AppDir";
             m_name = QFileInfo(dir.path()).completeBaseName();
             // qDebug() << "Name:" << m_name;
             // Check if the AppDir contains a .DirIcon file
-            if (dir.exists(".DirIcon")) {
+            if (vfs->exists(dir.filePath(".DirIcon"))) {
                 m_icon = dir.filePath(".DirIcon");
             }
             m_executable = dir.filePath("AppRun");
@@ -172,8 +174,7 @@ QIcon ApplicationBundle::icon() const
             // Get the default icon if the icon file does not exist
             return QIcon::fromTheme("application-x-executable");
         }
-        QFile file(m_icon);
-        if (file.exists()) {
+        if (Vfs::instance()->exists(m_icon)) {
             return QIcon(m_icon);
         } else {
             // Get the default icon if the icon file does not exist
@@ -264,11 +265,8 @@ QString ApplicationBundle::typeName() const {
 bool ApplicationBundle::launch(QStringList arguments) const
 {
     qDebug() << "Launching" << m_path << "with arguments" << arguments;
-    QProcess *process = new QProcess();
-    process->setProgram("launch");
-    process->setArguments(QStringList() << m_executable << arguments);
-    process->start();
-    if(!process->waitForStarted()) {
+    // Detached, so that the process is reaped without a QProcess object being kept around
+    if (!QProcess::startDetached("launch", QStringList() << m_executable << arguments)) {
         qDebug() << "Error starting process";
         return false;
     }
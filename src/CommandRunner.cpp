@@ -0,0 +1,57 @@
+#include "CommandRunner.h"
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QProcess>
+#include <QDebug>
+#include <thread>
+
+CancellationToken CommandRunner::run(const QString& program, const QStringList& arguments, int timeout,
+                                     QObject* context, const std::function<void(const CommandResult&)>& done) {
+    CancellationToken token;
+    QPointer<QObject> guard(context);
+    bool hasContext = (context != nullptr);
+    qDebug() << "CommandRunner:" << program << arguments;
+
+    std::thread([program, arguments, timeout, token, guard, hasContext, done]() {
+        CommandResult result = execute(program, arguments, timeout, token);
+        TaskRuntime::onGuiThread([token, guard, hasContext, done, result]() {
+            if (!token.isCanceled() && (!hasContext || guard)) {
+                done(result);
+            }
+        });
+    }).detach();
+    return token;
+}
+
+CommandResult CommandRunner::execute(const QString& program, const QStringList& arguments, int timeout,
+                                     const CancellationToken& token) {
+    CommandResult result;
+    QProcess process;
+    process.start(program, arguments);
+    if (!process.waitForStarted()) {
+        result.errorString = process.errorString();
+        qWarning() << "CommandRunner: could not start" << program << ":" << result.errorString;
+        return result;
+    }
+    result.started = true;
+
+    QElapsedTimer timer;
+    timer.start();
+    while (!process.waitForFinished(PollInterval) && process.state() != QProcess::NotRunning) {
+        bool canceled = token.isCanceled();
+        if (canceled || (timeout != NoTimeout && timer.elapsed() >= timeout)) {
+            result.timedOut = !canceled;
+            qWarning() << "CommandRunner: killing" << program << (canceled ? "(canceled)" : "(timed out)");
+            process.kill();
+            process.waitForFinished(KillGracePeriod);
+            break;
+        }
+    }
+
+    result.crashed = (process.exitStatus() == QProcess::CrashExit);
+    result.exitCode = process.exitCode();
+    result.standardOutput = process.readAllStandardOutput();
+    result.standardError = process.readAllStandardError();
+    qDebug() << "CommandRunner:" << program << "exited with" << result.exitCode << "after" << timer.elapsed() << "ms";
+    return result;
+}
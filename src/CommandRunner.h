@@ -0,0 +1,58 @@
+#ifndef COMMANDRUNNER_H
+#define COMMANDRUNNER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <functional>
+#include "TaskRuntime.h"
+
+/**
+ * @file CommandRunner.h
+ * @struct CommandResult
+ * @brief The outcome of an external command run by CommandRunner.
+ */
+struct CommandResult {
+    bool started = false; /**< False if the program could not be started at all. */
+    bool timedOut = false; /**< True if the command was killed because it took too long. */
+    bool crashed = false;
+    int exitCode = -1;
+    QByteArray standardOutput;
+    QByteArray standardError;
+    QString errorString; /**< Why the command could not be started, if it could not. */
+
+    bool succeeded() const { return started && !timedOut && !crashed && exitCode == 0; }
+};
+
+/**
+ * @class CommandRunner
+ * @brief Runs external commands off the GUI thread and reports their results on the GUI thread.
+ *
+ * Each command gets a short-lived thread of its own that starts the process, waits for it and
+ * reaps it, since commands like umount mostly wait and would otherwise hold up a worker of the
+ * TaskRuntime for seconds. A command that runs longer than its timeout is killed.
+ */
+class CommandRunner {
+public:
+    static constexpr int NoTimeout = -1;
+
+    /**
+     * @brief Runs a command and passes its result to done() on the GUI thread.
+     * @param timeout Milliseconds after which the command is killed, or NoTimeout, e.g., for commands
+     * that ask for a password.
+     * @param context done() is not called if this object is destroyed in the meantime. May be nullptr.
+     * @return The token that kills the command; done() is not called then.
+     */
+    static CancellationToken run(const QString& program, const QStringList& arguments, int timeout,
+                                 QObject* context, const std::function<void(const CommandResult&)>& done);
+
+private:
+    static CommandResult execute(const QString& program, const QStringList& arguments, int timeout,
+                                 const CancellationToken& token);
+
+    static constexpr int PollInterval = 100; /**< Milliseconds between checks for cancellation. */
+    static constexpr int KillGracePeriod = 1000; /**< Milliseconds to wait for a killed command to be reaped. */
+};
+
+#endif // COMMANDRUNNER_H
@@ -42,6 +42,8 @@
 #include "AppGlobals.h"
 #include "TrashHandler.h"
 #include "Mountpoints.h"
+#include "Trace.h"
+#include "Vfs.h"
 
 CustomFileIconProvider::CustomFileIconProvider()
         : iconCreator(new CombinedIconCreator) // "Initialize the pointer in the constructor"
@@ -67,6 +69,11 @@ CustomFileIconProvider::~CustomFileIconProvider()
 QIcon CustomFileIconProvider::icon(const QFileInfo &info) const
 {
     qDebug() << "CustomFileIconProvider::icon: " << info.absoluteFilePath();
+    FILER_TRACE_SCOPE("icon");
+
+    // QFileSystemModel asks for icons on its gatherer thread right after it has read info from the
+    // file system, which does not go through the Vfs; account for that read here
+    Vfs::instance()->account(Vfs::Stat);
 
     // Check if the item is an application bundle and return the icon
     ApplicationBundle *bundle = new ApplicationBundle(info.absoluteFilePath());
@@ -79,20 +86,20 @@ QIcon CustomFileIconProvider::icon(const QFileInfo &info) const
         return (bundle->icon());
     }
 
-    // How many directories deep is AppGlobals::mediaPath?
-    int mediaPathDepth = AppGlobals::mediaPath.count("/");
+    // How many directories deep is AppGlobals::mediaPath()?
+    int mediaPathDepth = AppGlobals::mediaPath().count("/");
 
     // Resolve symlinks
     QString absoluteFilePathWithSymLinksResolved = info.absoluteFilePath();
     if (info.isSymLink()) {
-        absoluteFilePathWithSymLinksResolved = info.symLinkTarget();
+        absoluteFilePathWithSymLinksResolved = Vfs::instance()->symLinkTarget(info.absoluteFilePath());
     }
 
     // How many directories deep is the current file?
     int fileDepth = absoluteFilePathWithSymLinksResolved.count("/");
 
-    // Is the current file in a subdirectory of AppGlobals::mediaPath but not in a sub-subdirectory?
-    bool isMediaPath = (absoluteFilePathWithSymLinksResolved.startsWith(AppGlobals::mediaPath) && (fileDepth == mediaPathDepth + 1));
+    // Is the current file in a subdirectory of AppGlobals::mediaPath() but not in a sub-subdirectory?
+    bool isMediaPath = (absoluteFilePathWithSymLinksResolved.startsWith(AppGlobals::mediaPath()) && (fileDepth == mediaPathDepth + 1));
 
     // Is the current file (symlinks unresolved) in ~/Desktop or a subdirectory of /media?
     // Only then we want to show the drive icons. Otherwise, we get hard disk icons inside the hard disk
@@ -101,7 +108,7 @@ QIcon CustomFileIconProvider::icon(const QFileInfo &info) const
     bool isOnDesktopOrInMedia = ((parentDirPath == QDir::homePath() + "/Desktop") || info.absoluteFilePath().startsWith("/media"));
 
     // If it is a directory and the symlink target is a mount point, then we want to show the drive icon
-    if (isOnDesktopOrInMedia && info.isDir() && isMediaPath || isOnDesktopOrInMedia && info.isDir() && Mountpoints::isMountpoint(absoluteFilePathWithSymLinksResolved)) {
+    if (isOnDesktopOrInMedia && info.isDir() && isMediaPath || isOnDesktopOrInMedia && info.isDir() && Mountpoints::isMountpoint(absoluteFilePathWithSymLinksResolved, false)) {
         // Using Qt, get the device node of the mount point
         // and then use the device node to get the icon
         // qDebug() << "Mount point: " << info.absoluteFilePath();
@@ -133,7 +140,7 @@ QIcon CustomFileIconProvider::icon(const QFileInfo &info) const
         // Resolve symlinks
         QString absoluteFilePathWithSymLinksResolved = info.absoluteFilePath();
         if (info.isSymLink()) {
-            absoluteFilePathWithSymLinksResolved = info.symLinkTarget();
+            absoluteFilePathWithSymLinksResolved = Vfs::instance()->symLinkTarget(info.absoluteFilePath());
         }
         if (absoluteFilePathWithSymLinksResolved == TrashHandler::getTrashPath()) {
             // Check if there are files inside the Trash using QDir::isEmpty()
@@ -144,7 +151,10 @@ QIcon CustomFileIconProvider::icon(const QFileInfo &info) const
             }
         }
         // If it is lacking permissions, then we want to show the locked folder icon; TODO: Use emblem instead?
-        if (!QFileInfo(info.absoluteFilePath()).isReadable() || !QFileInfo(info.absoluteFilePath()).isExecutable()) {
+        // The permissions are probed afresh rather than taken from info; the Vfs may delay the probe
+        Vfs::instance()->account(Vfs::Stat);
+        QFileInfo access(info.absoluteFilePath());
+        if (!access.isReadable() || !access.isExecutable()) {
             // Try to get folder-locked icon from the current theme,
             // fall back to other icons if it is not available
             if (QIcon::hasThemeIcon("folder-locked")) {
@@ -160,6 +170,7 @@ QIcon CustomFileIconProvider::icon(const QFileInfo &info) const
     }
 
     // If we have no read permissions, show the lock icon; TODO: Use emblem instead?
+    Vfs::instance()->account(Vfs::Stat);
     if (!QFileInfo(info.absoluteFilePath()).isReadable()) {
         // Try to get lock icon from the current theme,
         // fall back to other icons if it is not available
@@ -232,7 +243,7 @@ QIcon CustomFileIconProvider::icon(const QFileInfo &info) const
     // Handle .DirIcon (AppDir) and volumelcon.icns (Mac)
     QStringList candidates = {info.absoluteFilePath() + "/.DirIcon", info.absoluteFilePath() + "/volumelcon.icns"};
     for (const QString &candidate: candidates) {
-        if (QFileInfo(candidate).exists()) {
+        if (Vfs::instance()->exists(candidate)) {
             // Read the contents of the file and turn it into an icon
             QFile file(candidate);
             return (QIcon(file.readAll()));
@@ -262,10 +273,7 @@ QIcon CustomFileIconProvider::icon(const QFileInfo &info) const
 
     if (m_model != nullptr) {
         // Retrieve the "open-with" attribute from the stored attributes in the model.
-        // Get the model from the proxy model, because the proxy model has the stored attributes
-        // and the original model does not.
-        CustomFileSystemModel *model = qobject_cast<CustomFileSystemModel *>(m_model->sourceModel());
-        QString openWith = QString(model->openWith(
+        QString openWith = QString(m_model->openWith(
                 filePath)); // NOTE: We would like to do this with the index, but we don't have a valid index at this point for unknown reasons
         // qDebug() << "openWith: " << openWith;
         if (!openWith.isEmpty()) {
@@ -347,7 +355,7 @@ QIcon CustomFileIconProvider::icon(const QFileInfo &info) const
     return (QIcon::fromTheme("unknown"));
 }
 
-void CustomFileIconProvider::setModel(QAbstractProxyModel* model)
+void CustomFileIconProvider::setModel(const CustomFileSystemModel* model)
 {
     // Since we need to access the QAbstractItemModel from the icon provider so that we can call openWith() on it,
     // we need to make it accessible to the icon provider
@@ -63,13 +63,13 @@ public:
     QString currentThemeName; /**< The name of the current theme. */
 
     /**
-     * @brief Sets the QAbstractProxyModel associated with the icon provider.
-     * @param model The QAbstractProxyModel to set.
+     * @brief Sets the model whose stored "open-with" attributes the icon provider uses.
+     * @param model The CustomFileSystemModel to set.
      */
-    void setModel(QAbstractProxyModel* model);
+    void setModel(const CustomFileSystemModel* model);
 
 private:
-    const QAbstractProxyModel* m_model; /**< Pointer to the QAbstractProxyModel associated with the icon provider. */
+    const CustomFileSystemModel* m_model; /**< Pointer to the CustomFileSystemModel associated with the icon provider. */
     CombinedIconCreator* iconCreator;; /**< Pointer to the CombinedIconCreator associated with the icon provider. */
 };
 
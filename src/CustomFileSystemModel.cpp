@@ -25,17 +25,108 @@
  */
 
 #include "CustomFileSystemModel.h"
+#include "CustomFileIconProvider.h"
 #include "ExtendedAttributes.h"
 #include <QDebug>
 #include "ApplicationBundle.h"
 #include <QMimeData>
 #include <QUrl>
 #include <QMessageBox>
+#include <QDir>
+#include "Trace.h"
+
+CustomFileSystemModel* CustomFileSystemModel::s_sharedModel = nullptr;
 
 CustomFileSystemModel::CustomFileSystemModel(QObject* parent)
         : QFileSystemModel(parent)
 {
     LaunchDB ldb;
+
+    // The icon provider asks the model for the stored "open-with" attributes
+    m_iconProvider = new CustomFileIconProvider();
+    m_iconProvider->setModel(this);
+    setIconProvider(m_iconProvider);
+
+    connect(this, &QFileSystemModel::directoryLoaded, this, [this](const QString& path) {
+        m_loadedDirectories.insert(path);
+        auto started = m_loadStarted.find(path);
+        if (started != m_loadStarted.end()) {
+            FILER_TRACE_COMPLETE("directory-load", started.value());
+            m_loadStarted.erase(started);
+        }
+        if (m_loadedDirectories.size() >= MaxLoadedDirectories && s_sharedModel == this) {
+            qDebug() << "CustomFileSystemModel: Retiring the shared model after listing" << m_loadedDirectories.size() << "directories";
+            s_sharedModel = nullptr;
+        }
+    });
+
+    // A directory that is deleted, or renamed, has to be listed again if it comes back
+    connect(this, &QAbstractItemModel::rowsAboutToBeRemoved, this, [this](const QModelIndex& parent, int first, int last) {
+        for (int row = first; row <= last; row++) {
+            forgetDirectories(filePath(index(row, 0, parent)));
+        }
+    });
+    connect(this, &QFileSystemModel::fileRenamed, this, [this](const QString& path, const QString& oldName, const QString&) {
+        forgetDirectories(QDir::cleanPath(path + "/" + oldName));
+    });
+}
+
+CustomFileSystemModel::~CustomFileSystemModel()
+{
+    setIconProvider(nullptr);
+    delete m_iconProvider;
+}
+
+CustomFileSystemModel* CustomFileSystemModel::acquire()
+{
+    if (!s_sharedModel) {
+        s_sharedModel = new CustomFileSystemModel();
+        s_sharedModel->setRootPath("/");
+    }
+    s_sharedModel->m_references++;
+    return s_sharedModel;
+}
+
+void CustomFileSystemModel::release(CustomFileSystemModel* model)
+{
+    Q_ASSERT(model && model->m_references > 0);
+    if (--model->m_references == 0) {
+        if (s_sharedModel == model) {
+            s_sharedModel = nullptr;
+        }
+        // Proxy models of the last window may still refer to it until they are destroyed
+        model->deleteLater();
+    }
+}
+
+// Forgets that a directory and the directories below it have been listed
+void CustomFileSystemModel::forgetDirectories(const QString& path)
+{
+    QString prefix = path + "/";
+    for (auto it = m_loadedDirectories.begin(); it != m_loadedDirectories.end();) {
+        if (*it == path || it->startsWith(prefix)) {
+            it = m_loadedDirectories.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_loadStarted.remove(path);
+}
+
+void CustomFileSystemModel::loadDirectory(const QString& path)
+{
+    FILER_TRACE_SCOPE("load-directory");
+    QModelIndex index = CustomFileSystemModel::index(path);
+    if (canFetchMore(index)) {
+        // The listing is gathered in the background; its span ends with directoryLoaded
+        m_loadStarted.insert(QDir::cleanPath(path), Trace::now());
+        fetchMore(index);
+    }
+}
+
+bool CustomFileSystemModel::isDirectoryLoaded(const QString& path) const
+{
+    return m_loadedDirectories.contains(QDir::cleanPath(path));
 }
 
 QByteArray CustomFileSystemModel::readExtendedAttribute(const QModelIndex& index, const QString& attributeName) const
@@ -134,11 +225,12 @@ bool CustomFileSystemModel::dropMimeData(const QMimeData *data, Qt::DropAction a
     // When a drop occurs, the model index corresponding to the parent item will either be valid,
     // indicating that the drop occurred on an item, or it will be invalid,
     // indicating that the drop occurred somewhere in the view that corresponds to top level of the model.
+    // Since the model is shared by all windows, a drop onto the background of a view arrives with
+    // the root index of the view, i.e., the directory shown in the window
     QModelIndex index = parent;
     QString dropTargetPath;
-    if (!index.isValid()) {
-        qDebug() << "CustomFileSystemModel::dropMimeData Drop occurred on top level of the model (not on an item)";
-        dropTargetPath = rootPath();
+    if (index.isValid() && isDir(index)) {
+        dropTargetPath = filePath(index);
         qDebug() << "CustomFileSystemModel::dropMimeData dropTargetPath:" << dropTargetPath;
     } else {
         qDebug() << "CustomFileSystemModel::dropMimeData Drop occurred on an item, TODO: Handle in item delegate";
@@ -28,14 +28,37 @@
 
 #include <QFileSystemModel>
 #include <QByteArray>
+#include <QSet>
+#include <QHash>
 #include "LaunchDB.h"
 #include "CombinedIconCreator.h"
 
+class CustomFileIconProvider;
+
 class CustomFileSystemModel : public QFileSystemModel
 {
 Q_OBJECT
 public:
     explicit CustomFileSystemModel(QObject* parent = nullptr);
+    ~CustomFileSystemModel();
+
+    // The model shared by all windows and dialogs, so that metadata, icons and watches are only computed once;
+    // each window shows one directory of it through its own proxy model.
+    // Every acquire() must be paired with a release() of the same model; a model is destroyed with its last reference
+    static CustomFileSystemModel* acquire();
+    static void release(CustomFileSystemModel* model);
+
+    // A model keeps the nodes and watches of every directory that it has listed. Once it has listed this many,
+    // acquire() hands out a new model, and the old one goes away with the windows that still use it
+    static constexpr int MaxLoadedDirectories = 64;
+
+    // Starts listing a directory unless it has been listed already, e.g., for another window
+    void loadDirectory(const QString& path);
+
+    // Whether a directory has been listed completely; afterwards the model keeps it up to date
+    bool isDirectoryLoaded(const QString& path) const;
+
+    CustomFileIconProvider* customIconProvider() const { return m_iconProvider; }
 
     QByteArray readExtendedAttribute(const QModelIndex& index, const QString& attributeName) const;
 
@@ -70,6 +93,17 @@ private:
 
     LaunchDB ldb;
 
+    CustomFileIconProvider* m_iconProvider;
+
+    QSet<QString> m_loadedDirectories;
+    QHash<QString, qint64> m_loadStarted; /**< Trace timestamps of the listings being gathered. */
+
+    int m_references = 0;
+
+    static CustomFileSystemModel* s_sharedModel;
+
+    void forgetDirectories(const QString& path);
+
     // Private method to create a bookmark file via drag and drop, e.g., from a web browser
     bool createBrowserBookmarkFile(const QMimeData *data, QString dropTargetPath) const;
 
@@ -45,6 +45,7 @@
 #include "InfoDialog.h"
 #include "AppGlobals.h"
 #include "DBusInterface.h"
+#include "Trace.h"
 
 // Constructor that takes a QObject pointer and a QFileSystemModel pointer as arguments
 CustomItemDelegate::CustomItemDelegate(QObject* parent, QAbstractProxyModel* fileSystemModel)
@@ -54,16 +55,7 @@ CustomItemDelegate::CustomItemDelegate(QObject* parent, QAbstractProxyModel* fil
     // Initialize the m_fileSystemModel member variable with the provided QFileSystemModel pointer
     m_fileSystemModel = fileSystemModel;
 
-    // Create an instance of the custom icon provider
-    iconProvider = new CustomFileIconProvider();
-
-    // Set the custom file system model in the file icon provider.
-    iconProvider->setModel(m_fileSystemModel);
-
-    // Set the icon provider for the model
-    // Get the model's source model and cast it as a CustomFileSystemModel
-    CustomFileSystemModel* customFileSystemModel = qobject_cast<CustomFileSystemModel*>(m_fileSystemModel->sourceModel());
-    customFileSystemModel->setIconProvider(iconProvider);
+    // The icon provider belongs to the file system model, which is shared by all windows
 
     // Create a QTimeLine instance for the animation
     animationTimeline = new QTimeLine(1000, this); // 1000 ms duration for the animation
@@ -90,7 +82,6 @@ CustomItemDelegate::CustomItemDelegate(QObject* parent, QAbstractProxyModel* fil
 CustomItemDelegate::~CustomItemDelegate()
 {
     delete animationTimeline;
-    delete iconProvider;
 }
 
 // Reimplement the displayText() function of the CustomItemDelegate class
@@ -115,6 +106,7 @@ QString CustomItemDelegate::displayText(const QVariant &value, const QLocale &lo
 void CustomItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
                                const QModelIndex &index) const
 {
+    FILER_TRACE_SCOPE("paint-item");
 
     /* To persist the fact that QModelItemDelegate objects in a QIconView have been moved,
      * we need to update the model to reflect the new positions of the delegate.
@@ -421,7 +413,7 @@ bool CustomItemDelegate::editorEvent(QEvent *event, QAbstractItemModel *model,
                 TrashHandler::emptyTrash();
             });
         }
-        if (resolvedFilePath.startsWith(AppGlobals::mediaPath)) {
+        if (resolvedFilePath.startsWith(AppGlobals::mediaPath())) {
             moveToTrashAction->setText(tr("Eject"));
         }
         if (resolvedFilePath == "/") {
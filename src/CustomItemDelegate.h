@@ -181,8 +181,6 @@ private:
 
     QTimeLine* animationTimeline;
 
-    CustomFileIconProvider* iconProvider;
-
     qreal currentAnimationValue;
 
     // Member variables to store the current index and option
@@ -37,6 +37,7 @@
 #include "FileOperationManager.h"
 #include "DragAndDropHandler.h"
 #include "AppGlobals.h"
+#include "Trace.h"
 
 CustomListView::CustomListView(QWidget* parent) : QListView(parent) {
     should_paint_desktop_picture = false;
@@ -60,6 +61,7 @@ void CustomListView::requestDesktopPictureToBePainted(bool request) {
 
 void CustomListView::paintEvent(QPaintEvent* event)
 {
+    FILER_TRACE_SCOPE("paint");
 
     if(!should_paint_desktop_picture) {
         QListView::paintEvent(event);
@@ -50,6 +50,11 @@ public:
         QListView::setPositionForIndex(position, index);
     }
 
+    // Access the protected function rectForIndex to get the icon coordinates
+    inline QPoint positionForIndex(const QModelIndex& index) const {
+        return rectForIndex(index).topLeft();
+    }
+
     // Public function to get the item delegate for a given index
     QAbstractItemDelegate* getItemDelegateForIndex(const QModelIndex& index) const {
         return itemDelegate(index);
@@ -34,12 +34,19 @@
 #include <QUrl>
 #include <QFileSystemModel>
 #include "Mountpoints.h"
+#include "Trace.h"
 
 CustomProxyModel::CustomProxyModel(QObject *parent)
         : QSortFilterProxyModel(parent)
 {
 }
 
+void CustomProxyModel::sort(int column, Qt::SortOrder order)
+{
+    FILER_TRACE_SCOPE("sort");
+    QSortFilterProxyModel::sort(column, order);
+}
+
 bool CustomProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
 {
     QString leftPath = sourceModel()->data(left, Qt::DisplayRole).toString();
@@ -70,8 +77,8 @@ bool CustomProxyModel::lessThan(const QModelIndex &left, const QModelIndex &righ
     if (leftIsDir && rightIsDir) {
         // qDebug() << "leftFullPath:" << leftFullPath << "rightFullPath:" << rightFullPath;
 
-        bool leftIsMountPoint = Mountpoints::isMountpoint(leftFullPath);
-        bool rightIsMountPoint = Mountpoints::isMountpoint(rightFullPath);
+        bool leftIsMountPoint = Mountpoints::isMountpoint(leftFullPath, false);
+        bool rightIsMountPoint = Mountpoints::isMountpoint(rightFullPath, false);
         // qDebug() << "leftIsMountPoint:" << leftIsMountPoint << "rightIsMountPoint:" << rightIsMountPoint;
 
         ApplicationBundle *leftApplicationBundle = new ApplicationBundle(leftFullPath);
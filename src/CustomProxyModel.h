@@ -62,6 +62,11 @@ public:
      */
     bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
 
+    /**
+     * @brief Sorts the model; overridden to record how long sorting takes.
+     */
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
     // This gets called when a file is dropped onto the view
     bool dropMimeData(const QMimeData *data, Qt::DropAction action, int row, int column, const QModelIndex &parent) override;
 
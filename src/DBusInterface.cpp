@@ -29,6 +29,7 @@
 #include <QDebug>
 #include <QDBusConnection>
 #include <QDBusConnectionInterface>
+#include <QDBusPendingCallWatcher>
 #include <QMessageBox>
 #include <QApplication>
 #include <QUrl>
@@ -36,6 +37,8 @@
 
 #include "FileManagerMainWindow.h"
 #include "InfoDialog.h"
+#include "StallWatchdog.h"
+#include "Trace.h"
 
 DBusInterface::DBusInterface()
     : QObject()
@@ -45,8 +48,16 @@ DBusInterface::DBusInterface()
          QDBusConnection::ExportScriptableContents | QDBusConnection::ExportAdaptors);
     QDBusConnectionInterface *sessionInterface = QDBusConnection::sessionBus().interface();
     if (sessionInterface) {
-        sessionInterface->registerService(QStringLiteral("org.freedesktop.FileManager1"),
-                                          QDBusConnectionInterface::QueueService);
+        // Request the name without waiting for the bus to answer, so that startup does not block;
+        // flags 0 queue the request like QDBusConnectionInterface::QueueService
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
+                sessionInterface->asyncCall(QStringLiteral("RequestName"), QStringLiteral("org.freedesktop.FileManager1"), 0u), this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, [watcher]() {
+            if (watcher->isError()) {
+                qWarning() << "Could not register the FileManager1 D-Bus service:" << watcher->error().message();
+            }
+            watcher->deleteLater();
+        });
     }
 
     if (!QDBusConnection::sessionBus().interface()) {
@@ -54,6 +65,36 @@ DBusInterface::DBusInterface()
     }
 }
 
+/**
+ * @brief Returns the window for a directory, opening one if there is none yet.
+ * @return nullptr if no window could be opened, e.g., because the directory is not readable.
+ */
+static FileManagerMainWindow* windowForDirectory(const QString &directory)
+{
+    if (FileManagerMainWindow::instances().isEmpty()) {
+        return nullptr;
+    }
+    FileManagerMainWindow *mainWindow = qobject_cast<FileManagerMainWindow *>(qApp->activeWindow());
+    if (!mainWindow) {
+        mainWindow = FileManagerMainWindow::instances().first();
+    }
+
+    // Opening a window is synchronous, so the window exists afterwards unless opening was refused
+    if (!mainWindow->instanceExists(directory)) {
+        mainWindow->openFolderInNewWindow(directory);
+    }
+    FileManagerMainWindow *window = mainWindow->getInstanceForDirectory(directory);
+    if (!window) {
+        // The window is bound to the absolute path, with a symlink resolved
+        QString resolvedDirectory = QFileInfo(directory).absoluteFilePath();
+        if (QFileInfo(resolvedDirectory).isSymLink()) {
+            resolvedDirectory = QFileInfo(resolvedDirectory).symLinkTarget();
+        }
+        window = mainWindow->getInstanceForDirectory(resolvedDirectory);
+    }
+    return window;
+}
+
 void DBusInterface::ShowFolders(const QStringList &uriList, const QString &startUpId)
 {
     qDebug() << "ShowFolders" << uriList << startUpId;
@@ -74,19 +115,12 @@ void DBusInterface::ShowFolders(const QStringList &uriList, const QString &start
             }
         }
 
-        FileManagerMainWindow *mainWindow = qobject_cast<FileManagerMainWindow *>(qApp->activeWindow());
-
-        if (!mainWindow->instanceExists(filePath)) {
-            mainWindow->openFolderInNewWindow(filePath);
-        }
-
-        while (!mainWindow->instanceExists(filePath)) {
-            qDebug() << "Waiting for instance of FileManagerMainWindow for" << filePath;
-            QApplication::processEvents();
+        FileManagerMainWindow *mainWindow = windowForDirectory(filePath);
+        if (!mainWindow) {
+            qDebug() << "No window could be opened for" << filePath;
+            continue;
         }
 
-        mainWindow = mainWindow->getInstanceForDirectory(filePath);
-        
         mainWindow->bringToFront();
     }
 }
@@ -109,21 +143,13 @@ void DBusInterface::ShowItems(const QStringList &uriList, const QString &startUp
             continue;
         }
 
-        FileManagerMainWindow* mainWindow = qobject_cast<FileManagerMainWindow*>(qApp->activeWindow());
-
-        if (!mainWindow->instanceExists(parentDir)) {
-            mainWindow->openFolderInNewWindow(parentDir);
-        }
-
-        // Find the instance of FileManagerMainWindow for parentDir
-        // Wait until this succeeds: mainWindow->getInstanceForDirectory(parentDir);
-        while (!mainWindow->instanceExists(parentDir)) {
-            qDebug() << "Waiting for instance of FileManagerMainWindow for" << parentDir;
-            QApplication::processEvents();
+        FileManagerMainWindow* mainWindow = windowForDirectory(parentDir);
+        if (!mainWindow) {
+            qDebug() << "No window could be opened for" << parentDir;
+            continue;
         }
 
-        mainWindow = mainWindow->getInstanceForDirectory(parentDir);
-
+        // The selection is applied once the directory is loaded
         QStringList filePathList = QStringList() << filePath;
         mainWindow->selectItems(filePathList);
     }
@@ -149,4 +175,14 @@ void DBusInterface::SortOrderForUrl(const QString &url, QString &role, QString &
 {
     QMessageBox::warning(0, 0, "SortOrderForUrl is not implemented yet");
     qDebug() << "SortOrderForUrl" << url << role << order;
-}
\ No newline at end of file
+}
+QString DBusInterface::StallHistogram()
+{
+    StallWatchdog *watchdog = StallWatchdog::instance();
+    return watchdog ? watchdog->histogram() : QString();
+}
+
+bool DBusInterface::WriteTrace(const QString &path)
+{
+    return Trace::writeChromeTrace(path);
+}
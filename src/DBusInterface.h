@@ -73,6 +73,19 @@ public:
      */
     Q_SCRIPTABLE void SortOrderForUrl(const QString &url, QString &role, QString &order);
 
+    /**
+     * @brief Returns the number of GUI thread stalls by length, for diagnostics.
+     * @return One histogram bucket per line, or an empty string if the stall watchdog is not running.
+     */
+    Q_SCRIPTABLE QString StallHistogram();
+
+    /**
+     * @brief Writes the most recent trace spans as Chrome Trace Event JSON, e.g., for Perfetto.
+     * @param path The file to write.
+     * @return False if the file could not be written.
+     */
+    Q_SCRIPTABLE bool WriteTrace(const QString &path);
+
 private:
     bool m_isDaemon = false; /**< Indicates if the interface is used as a daemon. */
 };
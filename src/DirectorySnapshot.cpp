@@ -0,0 +1,222 @@
+#include "DirectorySnapshot.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QBuffer>
+#include <QPixmap>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QDebug>
+#include <condition_variable>
+#include <mutex>
+#include <sys/time.h>
+#include "TaskRuntime.h"
+
+namespace {
+const quint32 SnapshotMagic = 0x464e5350; // "FNSP"
+const quint16 SnapshotVersion = 1;
+const int StoredIconSize = 32; /**< The icon size of the icon view. */
+
+std::mutex backgroundSavesMutex;
+std::condition_variable backgroundSavesDone;
+int backgroundSaves = 0;
+}
+
+DirectorySnapshot::DirectorySnapshot(const QString& directory) : m_directory(directory) {
+
+}
+
+void DirectorySnapshot::addEntry(const QString& name, bool isDirectory, const QIcon& icon, const QPoint& position) {
+    Entry entry;
+    entry.name = name;
+    entry.isDirectory = isDirectory;
+    entry.position = position;
+    if (!icon.name().isEmpty()) {
+        entry.iconName = icon.name();
+    } else if (!icon.isNull()) {
+        // Icons such as the combined document icons have no name; store their image. Many documents
+        // share the same QIcon, which is rendered only once; pixmaps can only be rendered on the GUI thread
+        auto rendered = m_renderedIconIndexes.constFind(icon.cacheKey());
+        if (rendered != m_renderedIconIndexes.constEnd()) {
+            entry.iconData = rendered.value();
+        } else {
+            entry.iconData = m_renderedIcons.size();
+            m_renderedIcons.append(icon.pixmap(StoredIconSize, StoredIconSize).toImage());
+            m_renderedIconIndexes.insert(icon.cacheKey(), entry.iconData);
+        }
+    }
+    m_entries.append(entry);
+}
+
+QIcon DirectorySnapshot::icon(const Entry& entry) const {
+    if (!entry.iconName.isEmpty()) {
+        return QIcon::fromTheme(entry.iconName);
+    }
+    if (entry.iconData >= 0 && entry.iconData < m_renderedIcons.size()) {
+        // Not encoded yet
+        return QIcon(QPixmap::fromImage(m_renderedIcons.at(entry.iconData)));
+    }
+    if (entry.iconData >= 0 && entry.iconData < m_iconImages.size()) {
+        if (m_decodedIcons.size() != m_iconImages.size()) {
+            m_decodedIcons.resize(m_iconImages.size());
+        }
+        QIcon& decoded = m_decodedIcons[entry.iconData];
+        if (decoded.isNull()) {
+            QPixmap pixmap;
+            pixmap.loadFromData(m_iconImages.at(entry.iconData), "PNG");
+            decoded = QIcon(pixmap);
+        }
+        return decoded;
+    }
+    return QIcon::fromTheme(entry.isDirectory ? "folder" : "unknown");
+}
+
+// Encodes the rendered icons as PNG and stores identical images only once, since different QIcons
+// may still look the same
+void DirectorySnapshot::encodeIcons() {
+    if (m_renderedIcons.isEmpty()) {
+        return;
+    }
+    QVector<qint32> indexes(m_renderedIcons.size());
+    QHash<QByteArray, qint32> indexByImage;
+    QVector<QByteArray> images;
+    for (int i = 0; i < m_renderedIcons.size(); i++) {
+        QByteArray image;
+        QBuffer buffer(&image);
+        buffer.open(QIODevice::WriteOnly);
+        m_renderedIcons.at(i).save(&buffer, "PNG");
+        auto known = indexByImage.constFind(image);
+        if (known != indexByImage.constEnd()) {
+            indexes[i] = known.value();
+        } else {
+            indexes[i] = images.size();
+            indexByImage.insert(image, indexes[i]);
+            images.append(image);
+        }
+    }
+    for (Entry& entry : m_entries) {
+        if (entry.iconData >= 0) {
+            entry.iconData = indexes.at(entry.iconData);
+        }
+    }
+    m_iconImages = images;
+    m_decodedIcons.clear();
+    m_renderedIcons.clear();
+    m_renderedIconIndexes.clear();
+}
+
+bool DirectorySnapshot::load() {
+    QFile file(snapshotPath(m_directory));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    if (file.size() > MaxBytes) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic;
+    quint16 version;
+    QString directory;
+    stream >> magic >> version >> directory;
+    if (magic != SnapshotMagic || version != SnapshotVersion || directory != m_directory) {
+        // Written by another version, or a hash collision
+        return false;
+    }
+
+    qint32 entryCount;
+    stream >> m_iconImages >> entryCount;
+    if (stream.status() != QDataStream::Ok || entryCount < 0 || entryCount > MaxEntries) {
+        return false;
+    }
+
+    QVector<Entry> entries;
+    entries.reserve(entryCount);
+    for (qint32 i = 0; i < entryCount; i++) {
+        Entry entry;
+        stream >> entry.name >> entry.isDirectory >> entry.iconName >> entry.iconData >> entry.position;
+        entries.append(entry);
+    }
+    if (stream.status() != QDataStream::Ok) {
+        qDebug() << "Ignoring truncated snapshot of" << m_directory;
+        m_iconImages.clear();
+        return false;
+    }
+    m_entries = entries;
+    m_decodedIcons.clear();
+
+    // The modification time tells which snapshots were used least recently
+    utimes(QFile::encodeName(file.fileName()).constData(), nullptr);
+    return true;
+}
+
+bool DirectorySnapshot::save() {
+    if (m_directory.isEmpty() || m_entries.size() > MaxEntries) {
+        return false;
+    }
+    encodeIcons();
+
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << SnapshotMagic << SnapshotVersion << m_directory << m_iconImages << qint32(m_entries.size());
+    for (const Entry& entry : m_entries) {
+        stream << entry.name << entry.isDirectory << entry.iconName << entry.iconData << entry.position;
+    }
+    if (data.size() > MaxBytes) {
+        qDebug() << "Not keeping a snapshot of" << m_directory << "because it is too large:" << data.size();
+        return false;
+    }
+
+    if (!QDir().mkpath(snapshotDirectory())) {
+        return false;
+    }
+    QSaveFile file(snapshotPath(m_directory));
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        qDebug() << "Cannot write snapshot" << file.fileName() << file.errorString();
+        return false;
+    }
+
+    evict();
+    return true;
+}
+
+void DirectorySnapshot::saveInBackground(const DirectorySnapshot& snapshot) {
+    {
+        std::lock_guard<std::mutex> lock(backgroundSavesMutex);
+        backgroundSaves++;
+    }
+    TaskRuntime::instance()->run(TaskRuntime::Background, [snapshot](const CancellationToken&) mutable {
+        snapshot.save();
+        std::lock_guard<std::mutex> lock(backgroundSavesMutex);
+        backgroundSaves--;
+        backgroundSavesDone.notify_all();
+    });
+}
+
+void DirectorySnapshot::waitForBackgroundSaves() {
+    std::unique_lock<std::mutex> lock(backgroundSavesMutex);
+    backgroundSavesDone.wait(lock, []() { return backgroundSaves == 0; });
+}
+
+QString DirectorySnapshot::snapshotDirectory() {
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/Filer/snapshots";
+}
+
+QString DirectorySnapshot::snapshotPath(const QString& directory) {
+    QByteArray hash = QCryptographicHash::hash(directory.toUtf8(), QCryptographicHash::Sha1);
+    return snapshotDirectory() + "/" + QString::fromLatin1(hash.toHex());
+}
+
+void DirectorySnapshot::evict() {
+    QDir directory(snapshotDirectory());
+    QFileInfoList snapshots = directory.entryInfoList(QDir::Files | QDir::NoDotAndDotDot, QDir::Time);
+    // Sorted by modification time, most recent first
+    for (int i = MaxSnapshots; i < snapshots.size(); i++) {
+        QFile::remove(snapshots.at(i).absoluteFilePath());
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef DIRECTORYSNAPSHOT_H
+#define DIRECTORYSNAPSHOT_H
+
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include <QPoint>
+#include <QIcon>
+#include <QImage>
+#include <QHash>
+
+/**
+ * @file DirectorySnapshot.h
+ * @class DirectorySnapshot
+ * @brief A compact record of what a folder window showed the last time it was open.
+ *
+ * Holds the names, kinds, icons and icon positions of the items of one directory. Snapshots are
+ * written in a binary format to the cache directory when a window closes and are read when a
+ * window for the same directory opens again, so that the window can show the items at once while
+ * the live listing is still being loaded. Only a bounded number of snapshots of bounded size is kept;
+ * the least recently used ones are removed first.
+ */
+class DirectorySnapshot {
+public:
+    /**
+     * @brief One item of the directory.
+     */
+    struct Entry {
+        QString name;
+        bool isDirectory = false;
+        QString iconName; /**< Name of the theme icon, if the icon came from the theme. */
+        qint32 iconData = -1; /**< Index into the stored icon images otherwise, or -1. */
+        QPoint position = QPoint(-1, -1); /**< Position in the icon view, or (-1, -1) if unknown. */
+    };
+
+    static constexpr int MaxEntries = 4096; /**< Larger directories are not snapshotted. */
+    static constexpr int MaxBytes = 1024 * 1024; /**< Maximum size of a single snapshot file. */
+    static constexpr int MaxSnapshots = 64; /**< Maximum number of snapshot files. */
+
+    explicit DirectorySnapshot(const QString& directory = QString());
+
+    QString directory() const { return m_directory; }
+    const QVector<Entry>& entries() const { return m_entries; }
+    bool isEmpty() const { return m_entries.isEmpty(); }
+
+    /**
+     * @brief Adds an item; icons without a theme name are stored as images, once per distinct image.
+     * @note Must be called on the GUI thread, since it renders the icons; encoding them is left to save().
+     */
+    void addEntry(const QString& name, bool isDirectory, const QIcon& icon, const QPoint& position);
+
+    /**
+     * @brief Returns the icon of an item, falling back to a generic icon for its kind.
+     */
+    QIcon icon(const Entry& entry) const;
+
+    /**
+     * @brief Reads the snapshot of a directory.
+     * @return False if there is no usable snapshot.
+     */
+    bool load();
+
+    /**
+     * @brief Writes the snapshot and removes the least recently used snapshots above the limit.
+     * @note May be called on any thread.
+     * @return False if the snapshot exceeds the size limits or cannot be written.
+     */
+    bool save();
+
+    /**
+     * @brief Saves a snapshot on a worker thread, e.g., when a window closes.
+     */
+    static void saveInBackground(const DirectorySnapshot& snapshot);
+
+    /**
+     * @brief Waits until the snapshots that are being saved in the background are written.
+     */
+    static void waitForBackgroundSaves();
+
+private:
+    void encodeIcons();
+
+    static QString snapshotDirectory();
+    static QString snapshotPath(const QString& directory);
+    static void evict();
+
+    QString m_directory;
+    QVector<Entry> m_entries;
+    QVector<QByteArray> m_iconImages; /**< PNG images of the icons that have no theme name. */
+    QVector<QImage> m_renderedIcons; /**< Icons added since the last encodeIcons(), by the index in iconData. */
+    QHash<qint64, qint32> m_renderedIconIndexes; /**< By QIcon::cacheKey(), so that each QIcon is rendered once. */
+    mutable QVector<QIcon> m_decodedIcons;
+};
+
+#endif // DIRECTORYSNAPSHOT_H
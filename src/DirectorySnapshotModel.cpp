@@ -0,0 +1,34 @@
+#include "DirectorySnapshotModel.h"
+
+DirectorySnapshotModel::DirectorySnapshotModel(const DirectorySnapshot& snapshot, QObject* parent)
+        : QAbstractListModel(parent), m_entries(snapshot.entries()) {
+    m_icons.reserve(m_entries.size());
+    for (const DirectorySnapshot::Entry& entry : m_entries) {
+        m_icons.append(snapshot.icon(entry));
+    }
+}
+
+int DirectorySnapshotModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : m_entries.size();
+}
+
+QVariant DirectorySnapshotModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= m_entries.size()) {
+        return QVariant();
+    }
+    switch (role) {
+        case Qt::DisplayRole:
+            return m_entries.at(index.row()).name;
+        case Qt::DecorationRole:
+            return m_icons.at(index.row());
+        default:
+            return QVariant();
+    }
+}
+
+QPoint DirectorySnapshotModel::position(int row) const {
+    if (row < 0 || row >= m_entries.size()) {
+        return QPoint(-1, -1);
+    }
+    return m_entries.at(row).position;
+}
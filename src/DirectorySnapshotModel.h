@@ -0,0 +1,34 @@
+#ifndef DIRECTORYSNAPSHOTMODEL_H
+#define DIRECTORYSNAPSHOTMODEL_H
+
+#include <QAbstractListModel>
+#include "DirectorySnapshot.h"
+
+/**
+ * @file DirectorySnapshotModel.h
+ * @class DirectorySnapshotModel
+ * @brief Presents a DirectorySnapshot to a view until the live listing of the directory is loaded.
+ *
+ * The live view replaces the snapshot view as soon as the listing is complete; it lays out all
+ * items anyway, so the snapshot is not brought up to date first.
+ */
+class DirectorySnapshotModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    explicit DirectorySnapshotModel(const DirectorySnapshot& snapshot, QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role) const override;
+
+    /**
+     * @brief Returns the position that the item had in the icon view, or (-1, -1).
+     */
+    QPoint position(int row) const;
+
+private:
+    QVector<DirectorySnapshot::Entry> m_entries;
+    QVector<QIcon> m_icons;
+};
+
+#endif // DIRECTORYSNAPSHOTMODEL_H
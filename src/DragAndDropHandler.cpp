@@ -249,12 +249,8 @@ void DragAndDropHandler::handleDropEvent(QDropEvent* event)
         if (targetPath.isEmpty()) {
             // If the target path is empty, the files are being dropped
             // onto the root of the view, so use the current directory
-            // So get the model for this view and get the current directory
-            CustomProxyModel* model = static_cast<CustomProxyModel*>(m_view->model());
-            CustomFileSystemModel* sourceModel = static_cast<CustomFileSystemModel*>(model->sourceModel());
-            // Get the root index and from it, get the current directory
-            QModelIndex rootIndex = sourceModel->index(sourceModel->rootPath());
-            targetPath = rootIndex.data(QFileSystemModel::FilePathRole).toString();
+            // The root index of the view is the current directory
+            targetPath = m_view->rootIndex().data(QFileSystemModel::FilePathRole).toString();
         }
 
         // Get the coordinates of the mouse
@@ -362,6 +358,10 @@ void DragAndDropHandler::handleDropEvent(QDropEvent* event)
     QModelIndex index = m_view->indexAt(event->pos());
     int row = index.row();
     int column = index.column();
+    // A drop onto the background goes to the directory shown in the view
+    if (!index.isValid()) {
+        index = m_view->rootIndex();
+    }
     m_view->model()->dropMimeData(event->mimeData(), event->dropAction(), row, column, index);
 }
 
@@ -369,12 +369,8 @@ void DragAndDropHandler::handleStartDrag(Qt::DropActions supportedActions) {
     qDebug() << "DragAndDropHandler::startDrag";
     // Get the selected items
     QModelIndexList selectedIndexes = m_view->selectionModel()->selectedIndexes();
-    // Get the model for this view
-    CustomProxyModel* model = static_cast<CustomProxyModel*>(m_view->model());
-    CustomFileSystemModel* sourceModel = static_cast<CustomFileSystemModel*>(model->sourceModel());
-    // Get the root index and from it, get the current directory
-    QModelIndex rootIndex = sourceModel->index(sourceModel->rootPath());
-    QString currentDirectory = rootIndex.data(QFileSystemModel::FilePathRole).toString();
+    // The root index of the view is the current directory
+    QString currentDirectory = m_view->rootIndex().data(QFileSystemModel::FilePathRole).toString();
     // Get the list of paths for the selected items
     QStringList paths;
     for (int i = 0; i < selectedIndexes.size(); ++i) {
@@ -401,7 +397,7 @@ void DragAndDropHandler::handleStartDrag(Qt::DropActions supportedActions) {
     // Set the icon for the drag object so that while dragging, the icon being dragged is actually shown
     // Get the icon for the first item
     QModelIndex firstIndex = selectedIndexes.at(0);
-    QIcon icon = model->data(firstIndex, Qt::DecorationRole).value<QIcon>();
+    QIcon icon = m_view->model()->data(firstIndex, Qt::DecorationRole).value<QIcon>();
     // Get the pixmap for the icon
     // TODO: Which pixmap to use if there are multiple items?
     // The one for the first item? Or the one for the whole selection?
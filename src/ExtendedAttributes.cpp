@@ -26,10 +26,11 @@
 
 #include "ExtendedAttributes.h"
 
-#include <QProcess>
 #include <QStringList>
 #include <QTextStream>
 #include <QDebug>
+#include "Trace.h"
+#include "Vfs.h"
 
 ExtendedAttributes::ExtendedAttributes(const QString &filePath) : m_file(filePath) { }
 
@@ -38,100 +39,27 @@ bool ExtendedAttributes::write(const QString &attributeName, const QByteArray &a
     qDebug() << "Trying to write extended attribute" << attributeName << "with value"
              << attributeValue;
 
-    if (!m_file.exists()) {
+    Vfs* vfs = Vfs::instance();
+    if (!vfs->exists(m_file.fileName())) {
         // Error: File does not exist
         qWarning() << "ExtendedAttributes::write(): File does not exist";
         return false;
     }
 
-#if defined(__unix__) || defined(__APPLE__)
-    // Write the extended attribute to the file in the "user" namespace
-    qDebug() << "Writing extended attribute" << attributeName << "with value" << attributeValue
-             << "to file" << m_file.fileName();
-    QProcess extattr;
-    extattr.start("setextattr",
-                  QStringList() << "-hq"
-                                << "user" << attributeName << attributeValue << m_file.fileName());
-    if (!extattr.waitForFinished()) {
-        // Error writing extended attribute to user namespace
-        qWarning() << "ExtendedAttributes::write(): Error writing extended attribute to user "
-                      "namespace";
-        return false;
-    } else {
-        // Extended attribute was written successfully
-        // qDebug() << "Extended attribute was written successfully";
-    }
-#elif defined(__linux__)
-    qDebug() << "Writing extended attribute" << attributeName << "with value" << attributeValue
-             << "to file" << m_file.fileName();
-    // Write the extended attribute to the file in the "user" namespace
-    QProcess xattr;
-    xattr.start("setfattr",
-                QStringList() << "-n" << "user." + attributeName
-                            << "-v" << attributeValue
-                            << m_file.fileName());
-    if (!xattr.waitForFinished()) {
-        // Error writing extended attribute to user namespace
-        qWarning() << "ExtendedAttributes::write(): Error writing extended attribute to user "
-                      "namespace";
-        return false;
-    } else {
-        // Extended attribute was written successfully
-        // qDebug() << "Extended attribute was written successfully";
-    }
-#endif
-    return true;
-    qDebug() << "ExtendedAttributes::wrote(): " << attributeName << " " << attributeValue;
+    return vfs->writeExtendedAttribute(m_file.fileName(), attributeName, attributeValue);
 }
 
 QByteArray ExtendedAttributes::read(const QString &attributeName)
 {
+    FILER_TRACE_SCOPE("xattr-read");
     // qDebug() << "Trying to read extended attribute" << attributeName;
 
-    if (!m_file.exists()) {
+    Vfs* vfs = Vfs::instance();
+    if (!vfs->exists(m_file.fileName())) {
         // Error: File does not exist
         qWarning() << "ExtendedAttributes::read(): File does not exist";
         return QByteArray();
     }
 
-#if defined(__unix__) || defined(__APPLE__)
-    // Read the extended attribute from the file in the "user" namespace
-    // qDebug() << "Reading extended attribute" << attributeName << "from file" << m_file.fileName();
-    QProcess extattr;
-    extattr.start("getextattr",
-                  QStringList() << "-hq"
-                                << "user" << attributeName << m_file.fileName());
-    if (!extattr.waitForFinished()) {
-        // Error reading extended attribute from user namespace
-        qWarning() << "ExtendedAttributes::read(): Error reading extended attribute from user "
-                      "namespace";
-        return QByteArray();
-    } else {
-        // Extended attribute was read successfully
-        // qDebug() << "Extended attribute was read successfully";
-    }
-    QByteArray attributeValue = extattr.readAllStandardOutput().trimmed();
-    // qDebug() << "ExtendedAttributes::read():" << attributeName << " " << attributeValue;
-    return attributeValue;
-#elif defined(__linux__)
-    // Read the extended attribute from the file in the "user" namespace
-    qDebug() << "Reading extended attribute" << attributeName << "from file" << m_file.fileName();
-    QProcess xattr;
-    xattr.start("getfattr",
-                QStringList() << "-n" << "user." + attributeName
-                            << "-d" << m_file.fileName());
-    if (!xattr.waitForFinished()) {
-        // Error reading extended attribute from user namespace
-        qWarning() << "ExtendedAttributes::read(): Error reading extended attribute from user "
-                      "namespace";
-        return QByteArray();
-    } else {
-        // Extended attribute was read successfully
-        qDebug() << "Extended attribute was read successfully";
-    }
-
-    QByteArray attributeValue = xattr.readAllStandardOutput().trimmed();
-    qDebug() << "ExtendedAttributes::read():" << attributeName << " " << attributeValue;
-    return attributeValue;
-#endif
-}
\ No newline at end of file
+    return vfs->readExtendedAttribute(m_file.fileName(), attributeName);
+}
@@ -26,7 +26,6 @@
 
 #include "FileManagerMainWindow.h"
 #include "CustomItemDelegate.h"
-#include "CustomFileIconProvider.h"
 #include "FileOperationManager.h"
 
 #include <QMenuBar>
@@ -66,13 +65,17 @@
 #include <QUrl>
 #include "ApplicationBundle.h"
 #include "TrashHandler.h"
+#include "TrashIndex.h"
 #include "InfoDialog.h"
 #include "AppGlobals.h"
 #include "CustomProxyModel.h"
 #include <QStorageInfo>
 #include "Mountpoints.h"
 #include <QScreen>
-#include "VolumeWatcher.h"
+#include "DirectorySnapshotModel.h"
+#include "WindowPool.h"
+#include "CommandRunner.h"
+#include "Trace.h"
 
 /*
  * This creates a FileManagerMainWindow object with a QTreeView subclass and QListView subclass widget.
@@ -96,16 +99,12 @@ FileManagerMainWindow::FileManagerMainWindow(QWidget *parent, const QString &ini
 {
     qDebug() << "FileManagerMainWindow::FileManagerMainWindow()";
 
-    m_currentDir = initialDirectory;
+    // The first window is the desktop. Windows without a directory wait in the WindowPool
+    // until bindDirectory() is called
+    m_isFirstInstance = instances().isEmpty() && !initialDirectory.isEmpty();
+    qDebug() << "isFirstInstance:" << m_isFirstInstance;
 
-    m_extendedAttributes = new ExtendedAttributes(m_currentDir);
-
-    // Get number of instances
-    int instanceCount = instances().count();
-    qDebug() << "instanceCount:" << instanceCount;
-
-    if (instanceCount == 0) {
-        m_isFirstInstance = true;
+    if (m_isFirstInstance) {
         // If this is the first window, set this window as the root window of the main screen
         // Check if ~/Desktop exists; create it if it doesn't
         QDir homeDir(QDir::homePath());
@@ -116,51 +115,11 @@ FileManagerMainWindow::FileManagerMainWindow(QWidget *parent, const QString &ini
         // Set the object name to "Desktop" so that we can find it later
         setObjectName("Desktop");
 
-        // Set the root path to ~/Desktop
-        setDirectory(QDir::homePath() + "/Desktop");
-
         qDebug() << "First instance, show the desktop";
         setFixedSize(QApplication::desktop()->screenGeometry(0).size());
         setAttribute(Qt::WA_X11NetWmWindowTypeDesktop, true);
-
-    } else {
-        m_isFirstInstance = false;
-        setDirectory(initialDirectory);
-
-        // Read extended attributes describing the window geometry
-        qDebug() << "Reading extended attributes";
-
-        QByteArray positionAndGeometry =  m_extendedAttributes->read("positionAndGeometry");
-        // from qbytearray to qstring
-        QString positionAndGeometryString = QString::fromUtf8(positionAndGeometry);
-        qDebug() << "positionAndGeometryString:" << positionAndGeometryString;
-
-        // Check if contains only digits and 3 "," in between
-        QRegExp rx("^[0-9]+,[0-9]+,[0-9]+,[0-9]+$");
-        if (rx.exactMatch(positionAndGeometryString)) {
-            qDebug() << "positionAndGeometryString is valid";
-            // from qstring to qrect
-            QStringList positionAndGeometryList = positionAndGeometryString.split(",");
-            QRect positionAndGeometryRect =
-                    QRect(positionAndGeometryList[0].toInt(), positionAndGeometryList[1].toInt(),
-                          positionAndGeometryList[2].toInt(), positionAndGeometryList[3].toInt());
-            qDebug() << "positionAndGeometryRect:" << positionAndGeometryRect;
-            setGeometry(positionAndGeometryRect);
-        } else {
-            qDebug() << "positionAndGeometryString is invalid";
-            resize(600, 400);
-            // move(100, 100);
-        }
-        // If the window is outside the screen, move it to the center of the screen
-        if (!QApplication::desktop()->screenGeometry().contains(geometry())) {
-            qDebug() << "Window is outside the screen";
-            move(QApplication::desktop()->screen()->rect().center() - rect().center());
-        }
     }
 
-    // Append to the list of windows
-    instances().append(this);
-
     // Set type of window to be a file manager window
     setProperty("type", "filemanager");
 
@@ -208,11 +167,9 @@ FileManagerMainWindow::FileManagerMainWindow(QWidget *parent, const QString &ini
         // the same as we do with Installer
     }
 
-    // Create an instance of our custom QFileIconProvider
-    CustomFileIconProvider provider;
-
-    m_fileSystemModel = new CustomFileSystemModel(this);
-    m_fileSystemModel->setRootPath(m_currentDir);
+    // All windows share one file system model, which also provides the icons;
+    // the proxy model and the root index of the views select the directory of this window
+    m_fileSystemModel = CustomFileSystemModel::acquire();
     m_proxyModel = new CustomProxyModel(this);
     m_proxyModel->setSourceModel(m_fileSystemModel);
 
@@ -220,9 +177,6 @@ FileManagerMainWindow::FileManagerMainWindow(QWidget *parent, const QString &ini
     // m_proxyModel->setFilterRegExp(QRegExp("^[^z].*"));
     // Works!
 
-    // Call the function to set the filter based on the .hidden file
-    setFilterRegExpForHiddenFiles(m_proxyModel, m_currentDir + "/.hidden");
-
     m_proxyModel->setDynamicSortFilter(true);
     m_proxyModel->setSortCaseSensitivity(Qt::CaseInsensitive);
 
@@ -230,36 +184,10 @@ FileManagerMainWindow::FileManagerMainWindow(QWidget *parent, const QString &ini
     m_proxyModel->setSortRole(Qt::DecorationRole);
     m_proxyModel->sort(0, Qt::AscendingOrder);
 
-    provider.setModel(m_proxyModel);
-
-    // Make the file system model use the custom icon provider
-    m_fileSystemModel->setIconProvider(&provider);
-
     // Set the file system model as the model for the tree view and icon view
     m_treeView->setModel(m_proxyModel);
     m_iconView->setModel(m_proxyModel);
 
-    // Preload the data for the tree view (so that e.g., CustomIconProvider can know open-with attributes)
-    m_treeView->setRootIndex(m_proxyModel->mapFromSource(m_fileSystemModel->index(m_currentDir)));
-    m_iconView->setRootIndex(m_proxyModel->mapFromSource(m_fileSystemModel->index(m_currentDir)));
-
-    // Set the window title to the root path of the QFileSystemModel
-    setWindowTitle(QFileInfo(m_fileSystemModel->rootPath()).fileName());
-
-    // If we are at /
-    if (m_fileSystemModel->rootPath() == "/") {
-        setWindowTitle(VolumeWatcher::getRootDiskName());
-        // Resize the window since we cannot store the position and geometry
-        // of the root window in extended attributes appropriately
-        // TODO: Find a way to store the position and geometry of the root window
-        resize(600, 400);
-    }
-
-    // If we are at the Trash, set the window title to "Trash"
-    if (m_fileSystemModel->rootPath() == TrashHandler::getTrashPath()) {
-        setWindowTitle(tr("Trash"));
-    }
-
     // Create an instance of the CustomItemDelegate class;
     // we need this so that we have control over how the items (icons with text)
     // get drawn
@@ -314,6 +242,10 @@ FileManagerMainWindow::FileManagerMainWindow(QWidget *parent, const QString &ini
     setStatusBar(m_statusBar);
     m_statusBar->hide();
 
+    // Show the progress of file operations into this folder in the status bar
+    connect(FileOperationManager::instance(), &FileOperationManager::jobChanged, this,
+            &FileManagerMainWindow::showFileOperationProgress);
+
     // Set the width of the first column
     m_treeView->setColumnWidth(0, 400);
 
@@ -356,7 +288,7 @@ FileManagerMainWindow::FileManagerMainWindow(QWidget *parent, const QString &ini
     /* Icon view */
 
     // If this is the first window, arrange icons differently
-    if (instanceCount == 0) {
+    if (m_isFirstInstance) {
         // Set the flow property to TopToBottom
         m_iconView->setFlow(QListView::TopToBottom);
         // Mirror the layout of the icons
@@ -390,10 +322,120 @@ FileManagerMainWindow::FileManagerMainWindow(QWidget *parent, const QString &ini
 
     /* Overall */
 
-    // showTreeView();
-    // showIconView();
+    // If this is the first instance, disable m_showHideStatusBarAction
+    if (m_isFirstInstance) {
+        m_showHideStatusBarAction->setEnabled(false);
+    }
+
+    // Replace the snapshot by the live listing once it is complete
+    connect(m_fileSystemModel, &QFileSystemModel::directoryLoaded, this, [this](const QString &path) {
+        if (!m_currentDir.isEmpty() && path == QDir::cleanPath(m_currentDir)) {
+            m_directoryLoaded = true;
+            hideSnapshot();
+            if (!m_pendingSelection.isEmpty()) {
+                selectItems(m_pendingSelection);
+                m_pendingSelection.clear();
+            }
+        }
+    });
+
+    // Call destructor and destroy the window immediately when the window is closed
+    // Only this way the window will be destroyed immediately and not when the event loop is
+    // finished and we can remove the window from the list of child windows of the parent window
+    setAttribute(Qt::WA_DeleteOnClose);
+
+    if (!initialDirectory.isEmpty()) {
+        if (m_isFirstInstance) {
+            // The desktop keeps its window attributes on the initial directory rather than on ~/Desktop,
+            // so that a folder window for ~/Desktop does not take the size of the desktop
+            m_extendedAttributes = new ExtendedAttributes(initialDirectory);
+            bindDirectory(QDir::homePath() + "/Desktop");
+        } else {
+            bindDirectory(initialDirectory);
+        }
+    }
+}
+
+void FileManagerMainWindow::bindDirectory(const QString &directory)
+{
+    qDebug() << Q_FUNC_INFO << directory;
+    FILER_TRACE_SCOPE("bind-directory");
+    Q_ASSERT(m_currentDir.isEmpty());
+
+    setDirectory(directory);
+    if (!m_extendedAttributes) {
+        m_extendedAttributes = new ExtendedAttributes(m_currentDir);
+    }
+
+    if (!m_isFirstInstance) {
+        // Read extended attributes describing the window geometry
+        qDebug() << "Reading extended attributes";
+
+        QByteArray positionAndGeometry =  m_extendedAttributes->read("positionAndGeometry");
+        // from qbytearray to qstring
+        QString positionAndGeometryString = QString::fromUtf8(positionAndGeometry);
+        qDebug() << "positionAndGeometryString:" << positionAndGeometryString;
+
+        // Check if contains only digits and 3 "," in between
+        QRegExp rx("^[0-9]+,[0-9]+,[0-9]+,[0-9]+$");
+        if (rx.exactMatch(positionAndGeometryString)) {
+            qDebug() << "positionAndGeometryString is valid";
+            // from qstring to qrect
+            QStringList positionAndGeometryList = positionAndGeometryString.split(",");
+            QRect positionAndGeometryRect =
+                    QRect(positionAndGeometryList[0].toInt(), positionAndGeometryList[1].toInt(),
+                          positionAndGeometryList[2].toInt(), positionAndGeometryList[3].toInt());
+            qDebug() << "positionAndGeometryRect:" << positionAndGeometryRect;
+            setGeometry(positionAndGeometryRect);
+        } else {
+            qDebug() << "positionAndGeometryString is invalid";
+            resize(600, 400);
+            // move(100, 100);
+        }
+        // If the window is outside the screen, move it to the center of the screen
+        if (!QApplication::desktop()->screenGeometry().contains(geometry())) {
+            qDebug() << "Window is outside the screen";
+            move(QApplication::desktop()->screen()->rect().center() - rect().center());
+        }
+    }
+
+    // Append to the list of windows
+    instances().append(this);
+
+    m_fileSystemModel->loadDirectory(m_currentDir);
+    m_directoryLoaded = m_fileSystemModel->isDirectoryLoaded(m_currentDir);
+
+    // Call the function to set the filter based on the .hidden file
+    setFilterRegExpForHiddenFiles(m_proxyModel, m_currentDir + "/.hidden");
+
+    // Preload the data for the tree view (so that e.g., CustomIconProvider can know open-with attributes)
+    m_treeView->setRootIndex(m_proxyModel->mapFromSource(m_fileSystemModel->index(m_currentDir)));
+    m_iconView->setRootIndex(m_proxyModel->mapFromSource(m_fileSystemModel->index(m_currentDir)));
+
+    // Set the window title to the directory of the window
+    setWindowTitle(QFileInfo(m_currentDir).fileName());
+
+    // If we are at /
+    if (m_currentDir == "/") {
+        setWindowTitle(AppGlobals::rootDiskName());
+        // Resize the window since we cannot store the position and geometry
+        // of the root window in extended attributes appropriately
+        // TODO: Find a way to store the position and geometry of the root window
+        resize(600, 400);
+    }
+
+    // If we are at the Trash, set the window title to "Trash"
+    if (m_currentDir == TrashHandler::getTrashPath()) {
+        setWindowTitle(tr("Trash"));
+    }
+
+    // There is nothing above /
+    bool canGoUp = !m_isFirstInstance && QFileInfo(m_currentDir).canonicalFilePath() != "/";
+    for (QAction *goUpAction : m_goUpActions) {
+        goUpAction->setEnabled(canGoUp);
+    }
 
-    if (instanceCount != 0) {
+    if (!m_isFirstInstance) {
         // Read extended attribute describing the view mode
         QByteArray viewMode = m_extendedAttributes->read("WindowView");
         int viewModeInt = viewMode.toInt();
@@ -404,26 +446,25 @@ FileManagerMainWindow::FileManagerMainWindow(QWidget *parent, const QString &ini
         } else {
             // Set the central widget to the tree view
             showIconView();
+            // Until the live listing is loaded, show what the folder looked like the last time
+            showSnapshot();
         }
     } else {
         // The desktop is always shown as icons
         showIconView();
     }
 
-    // If this is the first instance, disable m_showHideStatusBarAction
-    if (instanceCount == 0) {
-        m_showHideStatusBarAction->setEnabled(false);
-    }
-
-    // Call destructor and destroy the window immediately when the window is closed
-    // Only this way the window will be destroyed immediately and not when the event loop is
-    // finished and we can remove the window from the list of child windows of the parent window
-    setAttribute(Qt::WA_DeleteOnClose);
+    updateMenus();
 }
 
 // Saves the window geometry
 void FileManagerMainWindow::saveWindowGeometry()
 {
+    // Windows that are still waiting in the WindowPool have nothing to save
+    if (m_currentDir.isEmpty()) {
+        return;
+    }
+
     // Print window positionAndGeometry
     qDebug() << "Window positionAndGeometry: " << geometry();
     qDebug() << "Window size: " << size();
@@ -433,8 +474,7 @@ void FileManagerMainWindow::saveWindowGeometry()
     qDebug() << "Window display number: " << displayNumber;
 
     // Get the filename of the current directory
-    QString currentDir =
-            m_fileSystemModel->filePath(m_fileSystemModel->index(m_fileSystemModel->rootPath()));
+    QString currentDir = m_currentDir;
 
     // Writing the window position and geometry directly as a QByteArray does not work because it
     // contains null bytes, so we convert it to a string
@@ -493,6 +533,119 @@ void FileManagerMainWindow::resizeEvent(QResizeEvent *event)
     saveWindowGeometry();
 }
 
+namespace {
+// Shows a DirectorySnapshotModel with the icons where they were in the icon view
+class SnapshotListView : public QListView
+{
+public:
+    using QListView::QListView;
+
+    void restorePositions(const DirectorySnapshotModel *model)
+    {
+        for (int row = 0; row < model->rowCount(); row++) {
+            QPoint position = model->position(row);
+            if (position != QPoint(-1, -1)) {
+                setPositionForIndex(position, model->index(row));
+            }
+        }
+    }
+};
+}
+
+void FileManagerMainWindow::showSnapshot()
+{
+    FILER_TRACE_SCOPE("show-snapshot");
+    // Nothing to bridge if another window has listed the directory already
+    if (m_directoryLoaded) {
+        return;
+    }
+
+    DirectorySnapshot snapshot(m_currentDir);
+    if (!snapshot.load() || snapshot.isEmpty()) {
+        return;
+    }
+    qDebug() << "Showing snapshot of" << snapshot.directory() << "with" << snapshot.entries().size() << "items";
+
+    m_snapshotModel = new DirectorySnapshotModel(snapshot, this);
+
+    // Look like the icon view
+    SnapshotListView *snapshotView = new SnapshotListView(this);
+    snapshotView->setFrameStyle(QFrame::NoFrame);
+    snapshotView->setViewMode(QListView::IconMode);
+    snapshotView->setMovement(QListView::Free);
+    snapshotView->setIconSize(m_iconView->iconSize());
+    snapshotView->setGridSize(m_iconView->gridSize());
+    snapshotView->setTextElideMode(Qt::ElideMiddle);
+    snapshotView->setSelectionMode(QAbstractItemView::NoSelection);
+    snapshotView->setModel(m_snapshotModel);
+    snapshotView->restorePositions(m_snapshotModel);
+
+    // Items can already be opened from the snapshot
+    connect(
+            snapshotView, &QListView::doubleClicked, this,
+            [this](const QModelIndex &index) {
+                open(m_currentDir + "/" + index.data(Qt::DisplayRole).toString());
+            },
+            Qt::QueuedConnection);
+
+    m_snapshotView = snapshotView;
+    m_stackedWidget->addWidget(m_snapshotView);
+    m_stackedWidget->setCurrentWidget(m_snapshotView);
+}
+
+void FileManagerMainWindow::hideSnapshot()
+{
+    if (!m_snapshotView) {
+        return;
+    }
+    FILER_TRACE_SCOPE("hide-snapshot");
+
+    // Hand over to the live view, which now has the items in the same places
+    if (m_stackedWidget->currentWidget() == m_snapshotView) {
+        m_stackedWidget->setCurrentWidget(m_iconView);
+    }
+    m_stackedWidget->removeWidget(m_snapshotView);
+    m_snapshotView->deleteLater();
+    m_snapshotModel->deleteLater();
+    m_snapshotView = nullptr;
+    m_snapshotModel = nullptr;
+}
+
+DirectorySnapshot FileManagerMainWindow::liveSnapshot() const
+{
+    DirectorySnapshot snapshot(m_currentDir);
+    QModelIndex rootIndex = m_proxyModel->mapFromSource(m_fileSystemModel->index(m_currentDir));
+    int rowCount = m_proxyModel->rowCount(rootIndex);
+    if (rowCount > DirectorySnapshot::MaxEntries) {
+        return snapshot;
+    }
+
+    // Positions are only meaningful while the icon view is laid out
+    bool hasPositions = (m_stackedWidget->currentWidget() == m_iconView);
+    for (int row = 0; row < rowCount; row++) {
+        QModelIndex index = m_proxyModel->index(row, 0, rootIndex);
+        QModelIndex sourceIndex = m_proxyModel->mapToSource(index);
+        snapshot.addEntry(m_fileSystemModel->fileName(sourceIndex), m_fileSystemModel->isDir(sourceIndex),
+                          index.data(Qt::DecorationRole).value<QIcon>(),
+                          hasPositions ? m_iconView->positionForIndex(index) : QPoint(-1, -1));
+    }
+    return snapshot;
+}
+
+void FileManagerMainWindow::saveSnapshot()
+{
+    // A partial listing would make the next window show items that may not exist
+    if (!m_directoryLoaded) {
+        return;
+    }
+    if (m_proxyModel->rowCount(m_proxyModel->mapFromSource(m_fileSystemModel->index(m_currentDir)))
+        > DirectorySnapshot::MaxEntries) {
+        return;
+    }
+    // Encoding the icons and writing the file would hold up closing the window
+    DirectorySnapshot::saveInBackground(liveSnapshot());
+}
+
 void FileManagerMainWindow::refresh() {
     qDebug() << "Calling update() on the views";
     m_treeView->update();
@@ -503,9 +656,22 @@ FileManagerMainWindow::~FileManagerMainWindow()
 {
     qDebug() << "Destructor called";
 
+    // Windows that are still waiting in the WindowPool have never shown a directory
+    if (m_currentDir.isEmpty()) {
+        CustomFileSystemModel::release(m_fileSystemModel);
+        return;
+    }
+
     // Save the window geometry
     saveWindowGeometry();
 
+    // Keep what the window showed so that it can be shown at once the next time
+    if (!m_isFirstInstance) {
+        saveSnapshot();
+    }
+
+    CustomFileSystemModel::release(m_fileSystemModel);
+
     // Remove from the list of windows
     instances().removeAll(this);
 
@@ -567,7 +733,7 @@ void FileManagerMainWindow::createMenus()
         if (ok && !name.isEmpty()) {
             qDebug() << "Creating new folder " << name;
             // Get the absolute path of the current directory
-            QString currentDir = m_fileSystemModel->filePath(m_fileSystemModel->index(m_fileSystemModel->rootPath()));
+            QString currentDir = m_currentDir;
             // Create the new folder
             QDir dir(currentDir);
             dir.mkdir(name);
@@ -849,6 +1015,7 @@ void FileManagerMainWindow::createMenus()
     connect(editMenu, &QMenu::aboutToShow, this, [this, editMenu]() {
         updateEmptyTrashMenu();
     });
+    connect(TrashIndex::instance(), &TrashIndex::changed, this, &FileManagerMainWindow::updateEmptyTrashMenu);
 
     // Add the Edit menu to the menu bar
     m_menuBar->addMenu(editMenu);
@@ -887,28 +1054,21 @@ void FileManagerMainWindow::createMenus()
     // Create the Go menu
     QMenu *goMenu = new QMenu(tr("Go"), this);
 
+    // Whether these can be used depends on the directory; see bindDirectory()
     goMenu->addAction(tr("Go Up"));
     goMenu->actions().last()->setShortcut(QKeySequence("Ctrl+Up"));
-    if (QFileInfo(m_currentDir).canonicalFilePath() == "/") {
-        goMenu->actions().last()->setEnabled(false);
-    }
     connect(goMenu->actions().last(), &QAction::triggered, this, [this]() {
         openFolderInNewWindow(QFileInfo(m_currentDir + "/../").canonicalFilePath());
     });
-    if (m_isFirstInstance)
-        goMenu->actions().last()->setEnabled(false);
+    m_goUpActions.append(goMenu->actions().last());
 
     goMenu->addAction(tr("Go Up and Close Current"));
     goMenu->actions().last()->setShortcut(QKeySequence("Shift+Ctrl+Up"));
-    if (QFileInfo(m_currentDir).canonicalFilePath() == "/") {
-        goMenu->actions().last()->setEnabled(false);
-    }
     connect(goMenu->actions().last(), &QAction::triggered, this, [this]() {
         openFolderInNewWindow(QFileInfo(m_currentDir + "/../").canonicalFilePath());
         close();
     });
-    if (m_isFirstInstance)
-        goMenu->actions().last()->setEnabled(false);
+    m_goUpActions.append(goMenu->actions().last());
 
     goMenu->addSeparator();
 
@@ -933,12 +1093,12 @@ void FileManagerMainWindow::createMenus()
     goMenu->addMenu(devicesMenu);
     connect(devicesMenu, &QMenu::aboutToShow, this, [this, devicesMenu, goMenu]() {
         devicesMenu->clear();
-        QDir mediaDir(AppGlobals::mediaPath);
+        QDir mediaDir(AppGlobals::mediaPath());
         if (mediaDir.exists()) {
             for (const QString &entry : mediaDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
                 QAction *action = devicesMenu->addAction(entry);
                 connect(action, &QAction::triggered, this,
-                        [this, entry]() { openFolderInNewWindow(AppGlobals::mediaPath +"/" + entry); });
+                        [this, entry]() { openFolderInNewWindow(AppGlobals::mediaPath() +"/" + entry); });
             }
         }
     });
@@ -1226,6 +1386,29 @@ void FileManagerMainWindow::updateStatusBar()
     qDebug() << "Completed" << Q_FUNC_INFO;
 }
 
+void FileManagerMainWindow::showFileOperationProgress(int id, const QString &type, const QString &state,
+                                                      const QString &targetPath, qint64 bytesDone,
+                                                      qint64 totalBytes, int filesDone, int totalFiles)
+{
+    Q_UNUSED(id);
+    Q_UNUSED(bytesDone);
+    Q_UNUSED(totalBytes);
+
+    if (QDir(targetPath) != QDir(m_currentDir)) {
+        return;
+    }
+
+    QString operation = type == "move" ? tr("Moving") : tr("Copying");
+    if (state == "running") {
+        m_statusBar->showMessage(tr("%1 %2 of %3 items").arg(operation).arg(filesDone).arg(totalFiles), 1000);
+    } else if (state == "paused" || state == "queued") {
+        m_statusBar->showMessage(tr("%1 %2 items (waiting)").arg(operation).arg(totalFiles), 1000);
+    } else {
+        // The operation is over; go back to showing the selection
+        updateStatusBar();
+    }
+}
+
 // Getter method for the directory property
 QString FileManagerMainWindow::directory() const
 {
@@ -1271,7 +1454,7 @@ void FileManagerMainWindow::openFolderInNewWindow(const QString &rootPath)
     // Check if a window for the specified root path already exists
     bool windowExists = false;
     for (FileManagerMainWindow *window : instances()) {
-        if (window->m_fileSystemModel->rootPath() == resolvedRootPath) {
+        if (window->m_currentDir == resolvedRootPath) {
             // A window for the specified root path already exists
             window->bringToFront();
             windowExists = true;
@@ -1283,7 +1466,8 @@ void FileManagerMainWindow::openFolderInNewWindow(const QString &rootPath)
         // No window for the specified root path exists, so create a new one
         // Not setting a parent, so that the window does not get destroyed when the parent gets
         // destroyed
-        FileManagerMainWindow *newWindow = new FileManagerMainWindow(nullptr, resolvedRootPath);
+        // Take a window that has been set up ahead of time, if there is one
+        FileManagerMainWindow *newWindow = WindowPool::instance()->take(resolvedRootPath);
         newWindow->show();
     }
 }
@@ -1524,7 +1708,7 @@ void FileManagerMainWindow::renameSelectedItem()
     }
     qDebug() << "absoluteFilePath:" << absoluteFilePath;
 
-    if (Mountpoints::isMountpoint(absoluteFilePath)) {
+    if (Mountpoints::isMountpoint(absoluteFilePath, false)) {
 
         // TODO: Possibly move everything in this if statement to a separate class,
         // similar to the FileOperationManager class
@@ -1561,25 +1745,24 @@ void FileManagerMainWindow::renameSelectedItem()
         }
 
         QString oldName = currentPath.split("/").last();
-        QProcess *p = new QProcess(this);
         // TODO: Check if we need sudo at all for this kind of filesystem; e.g., if it's a FAT32 filesystem
         // then we don't need sudo
-        p->setProgram("sudo");
-        p->setArguments({ "-A", "-E", foundBinary, absoluteFilePath, newName });
-        qDebug() << p->program() << "'" + p->arguments().join("' '") + "'";
-        p->start();
-        p->waitForFinished();
-        qDebug() << "renamedisk exit code:" << p->exitCode();
-        if (p->exitCode() != 0) {
-            QStringList errorLines = QString(p->readAllStandardError()).split("\n");
-            for (const QString &errorLine : errorLines) {
-                qCritical() << errorLine;
+        // No timeout, since sudo may be waiting for the user to enter the password
+        QStringList arguments = { "-A", "-E", foundBinary, absoluteFilePath, newName };
+        CommandRunner::run("sudo", arguments, CommandRunner::NoTimeout, this,
+                           [this, oldName, newName, currentPath](const CommandResult &result) {
+            qDebug() << "renamedisk exit code:" << result.exitCode;
+            if (!result.succeeded()) {
+                QStringList errorLines = QString(result.standardError).split("\n");
+                for (const QString &errorLine : errorLines) {
+                    qCritical() << errorLine;
+                }
+                QMessageBox::critical(this, tr("Error"), tr("Could not rename %1 to %2").arg(oldName).arg(newName));
+            } else {
+                qDebug() << "Renamed" << currentPath << "to" << newName;
+                // The view will automatically update itself; works
             }
-            QMessageBox::critical(this, tr("Error"), tr("Could not rename %1 to %2").arg(oldName).arg(newName));
-        } else {
-            qDebug() << "Renamed" << currentPath << "to" << newName;
-            // The view will automatically update itself; works
-        }
+        });
         return;
     }
 
@@ -1725,7 +1908,7 @@ QAbstractItemView* FileManagerMainWindow::getCurrentView() const
     {
         currentActiveView = m_treeView;
     }
-    else if (m_stackedWidget->currentWidget() == m_iconView)
+    else if (m_stackedWidget->currentWidget() == m_iconView || m_stackedWidget->currentWidget() == m_snapshotView)
     {
         currentActiveView = m_iconView;
     }
@@ -1747,6 +1930,12 @@ void FileManagerMainWindow::selectItems(const QStringList &paths)
 
     bringToFront();
 
+    // The items can only be found once the listing is complete; select them then
+    if (!m_directoryLoaded) {
+        m_pendingSelection = paths;
+        return;
+    }
+
     // Get the current view
     QAbstractItemView* currentActiveView = getCurrentView();
 
@@ -1769,12 +1958,6 @@ void FileManagerMainWindow::selectItems(const QStringList &paths)
         // Select the item
         m_selectionModel->select(proxyIndex, QItemSelectionModel::Select);
 
-        // Wait until the view is not busy
-        while (currentActiveView->property("isBusy").toBool()) {
-            qDebug() << "Waiting for view to be ready";
-            QCoreApplication::processEvents();
-        }
-
         // Scroll to the item based on the current active view
         currentActiveView->scrollTo(proxyIndex, QAbstractItemView::PositionAtCenter);
     }
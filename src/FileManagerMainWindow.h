@@ -39,6 +39,9 @@
 #include "CustomListView.h"
 #include "ExtendedAttributes.h"
 #include <QSortFilterProxyModel>
+#include "DirectorySnapshot.h"
+
+class DirectorySnapshotModel;
 
 class FileManagerMainWindow : public QMainWindow
 {
@@ -51,8 +54,13 @@ public:
 
     bool instanceExists(const QString &directory);
 
+    // Without an initial directory, the window is set up completely but does not show anything
+    // until bindDirectory() is called; the WindowPool keeps such windows ready
     FileManagerMainWindow(QWidget *parent = nullptr, const QString &initialDirectory = "/");
 
+    // Shows the directory in a window that was created without one; can only be called once
+    void bindDirectory(const QString &directory);
+
     ~FileManagerMainWindow();
 
     QItemSelectionModel *m_selectionModel;
@@ -94,6 +102,9 @@ public slots:
     void updateMenus();
     void updateEmptyTrashMenu();
 
+    void showFileOperationProgress(int id, const QString &type, const QString &state, const QString &targetPath,
+                                   qint64 bytesDone, qint64 totalBytes, int filesDone, int totalFiles);
+
 private:
     QStackedWidget *m_stackedWidget;
 
@@ -122,6 +133,8 @@ private:
 
     QAction *m_showHideStatusBarAction;
 
+    QList<QAction *> m_goUpActions;
+
     QStringList readFilenamesFromHiddenFile(const QString &filePath);
 
     void createMenus();
@@ -133,10 +146,20 @@ private:
 
     void saveWindowGeometry();
 
+    // Show the items from the last time the directory was open until the live listing is loaded
+    void showSnapshot();
+    void hideSnapshot();
+    void saveSnapshot();
+    DirectorySnapshot liveSnapshot() const;
+    bool m_directoryLoaded = false;
+    QStringList m_pendingSelection; /**< Items to select once the directory is loaded. */
+    QListView *m_snapshotView = nullptr;
+    DirectorySnapshotModel *m_snapshotModel = nullptr;
+
     void setFilterRegExpForHiddenFiles(QSortFilterProxyModel *proxyModel, const QString &hiddenFilePath);
     void closeAllWindowsOnScreen(int targetScreenIndex);
 
-    ExtendedAttributes *m_extendedAttributes;
+    ExtendedAttributes *m_extendedAttributes = nullptr;
 
     void handleSelectionChange();
 };
@@ -5,22 +5,66 @@
 #include <QProcess>
 #include <QMessageBox>
 #include <QDebug>
+#include <QTimer>
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDBusError>
+#include <QDBusMessage>
+#include <QDBusPendingCall>
+#include <QDBusPendingCallWatcher>
 
-void FileOperationManager::executeFileOperation(const QStringList& fromPaths, const QString& toPath, const QString& operation) {
-    QString fileOperationBinary = findFileOperationBinary();
-    QProcess* process = new QProcess();
+static const QString fileOperationService = QStringLiteral("org.helloSystem.FileOperation");
+static const QString fileOperationPath = QStringLiteral("/org/helloSystem/FileOperation");
+static const QString fileOperationInterface = QStringLiteral("org.helloSystem.FileOperation");
 
-    QStringList arguments;
-    arguments << operation;
-    for (const QString& fromPath : fromPaths) {
-        arguments << fromPath;
-    }
-    arguments << toPath;
+FileOperationManager::FileOperationManager(QObject* parent)
+    : QObject(parent),
+      m_serviceWatcher(fileOperationService, QDBusConnection::sessionBus(), QDBusServiceWatcher::WatchForOwnerChange)
+{
+    // Track whether the service is running instead of asking the bus for every operation
+    QDBusConnectionInterface* interface = QDBusConnection::sessionBus().interface();
+    m_serviceRunning = interface && interface->isServiceRegistered(fileOperationService);
+    connect(&m_serviceWatcher, &QDBusServiceWatcher::serviceRegistered, this, &FileOperationManager::onServiceRegistered);
+    connect(&m_serviceWatcher, &QDBusServiceWatcher::serviceUnregistered, this, [this]() {
+        qDebug() << "File operation service has quit";
+        m_serviceRunning = false;
+    });
 
-    qDebug() << "Executing file operation:" << fileOperationBinary << arguments;
+    // Relay the state of all jobs to every window
+    QDBusConnection::sessionBus().connect(fileOperationService, fileOperationPath, fileOperationInterface, "JobChanged",
+                                          this, SLOT(onJobChanged(int,QString,QString,QString,qlonglong,qlonglong,int,int)));
+}
 
-    process->start(fileOperationBinary, arguments);
+FileOperationManager* FileOperationManager::instance() {
+    static FileOperationManager* instance = new FileOperationManager(qApp);
+    return instance;
+}
+
+void FileOperationManager::executeFileOperation(const QStringList& fromPaths, const QString& toPath, const QString& operation) {
+    PendingOperation pending;
+    if (operation == "--copy") {
+        pending.method = "Copy";
+    } else if (operation == "--move") {
+        pending.method = "Move";
+    } else if (operation == "--delete") {
+        pending.method = "Delete";
+    }
+    pending.arguments << fromPaths;
+    pending.fallbackArguments << operation << fromPaths;
+    if (operation != "--delete") {
+        pending.arguments << toPath;
+        pending.fallbackArguments << toPath;
+    }
+
+    FileOperationManager* manager = instance();
+    if (isServiceRunning()) {
+        manager->callService(pending);
+        return;
+    }
 
+    // Start the service and submit the operation once it is registered
+    manager->m_pendingOperations.append(pending);
+    startService();
 }
 
 void FileOperationManager::copyWithProgress(const QStringList& fromPaths, const QString& toPath) {
@@ -31,6 +75,114 @@ void FileOperationManager::moveWithProgress(const QStringList& fromPaths, const
     executeFileOperation(fromPaths, toPath, "--move");
 }
 
+void FileOperationManager::deleteWithProgress(const QStringList& paths) {
+    executeFileOperation(paths, QString(), "--delete");
+}
+
+void FileOperationManager::startService() {
+    FileOperationManager* manager = instance();
+    if (manager->m_serviceStarting || isServiceRunning()) {
+        return;
+    }
+
+    QString fileOperationBinary = findFileOperationBinary();
+    if (fileOperationBinary.isEmpty()) {
+        return;
+    }
+
+    qDebug() << "Starting file operation service:" << fileOperationBinary << "--daemon";
+    manager->m_serviceStarting = QProcess::startDetached(fileOperationBinary, QStringList() << "--daemon");
+    if (!manager->m_serviceStarting) {
+        manager->onServiceTimeout();
+        return;
+    }
+
+    // If the service does not show up in time, run the pending operations in their own processes
+    QTimer::singleShot(5000, manager, &FileOperationManager::onServiceTimeout);
+}
+
+bool FileOperationManager::isServiceRunning() {
+    return instance()->m_serviceRunning;
+}
+
+void FileOperationManager::onServiceRegistered() {
+    qDebug() << "File operation service is available";
+    m_serviceRunning = true;
+    m_serviceStarting = false;
+    const QList<PendingOperation> pendingOperations = m_pendingOperations;
+    m_pendingOperations.clear();
+    for (const PendingOperation& pending : pendingOperations) {
+        callService(pending);
+    }
+}
+
+void FileOperationManager::onServiceTimeout() {
+    m_serviceStarting = false;
+    if (isServiceRunning()) {
+        onServiceRegistered();
+        return;
+    }
+    if (m_pendingOperations.isEmpty()) {
+        return;
+    }
+    qWarning() << "File operation service did not start, running operations in separate processes";
+    const QList<PendingOperation> pendingOperations = m_pendingOperations;
+    m_pendingOperations.clear();
+    for (const PendingOperation& pending : pendingOperations) {
+        runInProcess(pending.fallbackArguments);
+    }
+}
+
+void FileOperationManager::callService(const PendingOperation& operation) {
+    QDBusMessage message = QDBusMessage::createMethodCall(fileOperationService, fileOperationPath,
+                                                          fileOperationInterface, operation.method);
+    message.setArguments(operation.arguments);
+    // Do not block the user interface while the service accepts the job
+    QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(message), this);
+    QStringList fallbackArguments = operation.fallbackArguments;
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, watcher, fallbackArguments]() {
+        if (watcher->isError()) {
+            QDBusError error = watcher->error();
+            qWarning() << "File operation service failed:" << error.name() << error.message();
+            if (error.type() == QDBusError::ServiceUnknown || error.type() == QDBusError::NameHasNoOwner) {
+                // The service is gone, so it has not taken the job
+                runInProcess(fallbackArguments);
+            } else {
+                // E.g., on a timeout the service may have queued the job already; running it again
+                // could move or delete files twice
+                QMessageBox::critical(nullptr, "Filer",
+                                      tr("The file operation service did not confirm the operation: %1\n"
+                                         "It may still be carried out.").arg(error.message()));
+            }
+        }
+        watcher->deleteLater();
+    });
+}
+
+void FileOperationManager::runInProcess(const QStringList& arguments) {
+    QString fileOperationBinary = findFileOperationBinary();
+    if (fileOperationBinary.isEmpty()) {
+        return;
+    }
+    QProcess* process = new QProcess(this);
+
+    qDebug() << "Executing file operation:" << fileOperationBinary << arguments;
+
+    // Reap the process when it is done
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), process, &QObject::deleteLater);
+    connect(process, &QProcess::errorOccurred, process, [process](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            process->deleteLater();
+        }
+    });
+    process->start(fileOperationBinary, arguments);
+}
+
+void FileOperationManager::onJobChanged(int id, const QString& type, const QString& state, const QString& targetPath,
+                                        qlonglong bytesDone, qlonglong totalBytes, int filesDone, int totalFiles) {
+    emit jobChanged(id, type, state, targetPath, bytesDone, totalBytes, filesDone, totalFiles);
+}
+
 QString FileOperationManager::findFileOperationBinary() {
     QStringList fileOperationBinaryCandidates;
 
@@ -1,16 +1,30 @@
 #ifndef FILEOPERATIONMANAGER_H
 #define FILEOPERATIONMANAGER_H
 
+#include <QObject>
 #include <QString>
 #include <QStringList>
+#include <QList>
+#include <QDBusServiceWatcher>
 
 /**
  * @file FileOperationManager.h
  * @class FileOperationManager
- * @brief The FileOperationManager class provides functionality for copying and moving files with progress.
+ * @brief The FileOperationManager class provides functionality for copying, moving and deleting files with progress.
+ *
+ * File operations are submitted to the 'fileoperation' service over D-Bus. The service is started
+ * on demand and kept running, so that operations start without the cost of launching a process.
+ * If the service cannot be reached, a 'fileoperation' process is started for the operation instead.
  */
-class FileOperationManager {
+class FileOperationManager : public QObject {
+    Q_OBJECT
+
 public:
+    /**
+     * @brief Returns the instance that relays job state from the 'fileoperation' service.
+     */
+    static FileOperationManager* instance();
+
     /**
      * @brief Copies a list of files to a destination folder with progress.
      * @param fromPaths The list of source file paths.
@@ -25,6 +39,12 @@ public:
      */
     static void moveWithProgress(const QStringList& fromPaths, const QString& toPath);
 
+    /**
+     * @brief Permanently deletes a list of files and directory trees with progress.
+     * @param paths The paths to delete.
+     */
+    static void deleteWithProgress(const QStringList& paths);
+
     /**
      * @brief Finds the path to the file operation binary, 'fileoperation'.
      * @note The binary should be shipped with this application. All file operation functionality is implemented in the binary.
@@ -32,15 +52,53 @@ public:
      */
     static QString findFileOperationBinary();
 
+    /**
+     * @brief Starts the 'fileoperation' service in the background if it is not running yet.
+     */
+    static void startService();
+
+signals:
+    /**
+     * @brief Emitted whenever the state or progress of a file operation changes.
+     * @param state One of "queued", "running", "paused", "finished", "failed", "canceled".
+     */
+    void jobChanged(int id, const QString& type, const QString& state, const QString& targetPath,
+                    qint64 bytesDone, qint64 totalBytes, int filesDone, int totalFiles);
+
+private slots:
+    void onJobChanged(int id, const QString& type, const QString& state, const QString& targetPath,
+                      qlonglong bytesDone, qlonglong totalBytes, int filesDone, int totalFiles);
+    void onServiceRegistered();
+
 private:
+    explicit FileOperationManager(QObject* parent = nullptr);
+
+    /**
+     * @brief A file operation that waits for the service to come up.
+     */
+    struct PendingOperation {
+        QString method;
+        QList<QVariant> arguments;
+        QStringList fallbackArguments;
+    };
+
     /**
      * @brief Executes a file operation with progress.
      * @param fromPaths The list of source file paths.
-     * @param toPath The destination folder path.
+     * @param toPath The destination folder path; ignored for deletions.
      * @param operation The operation to perform.
      */
     static void executeFileOperation(const QStringList& fromPaths, const QString& toPath, const QString& operation);
 
+    static bool isServiceRunning();
+    void callService(const PendingOperation& operation);
+    void runInProcess(const QStringList& arguments);
+    void onServiceTimeout();
+
+    QDBusServiceWatcher m_serviceWatcher;
+    QList<PendingOperation> m_pendingOperations;
+    bool m_serviceRunning = false;
+    bool m_serviceStarting = false;
 };
 
 #endif // FILEOPERATIONMANAGER_H
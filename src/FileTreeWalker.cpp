@@ -0,0 +1,341 @@
+#include "FileTreeWalker.h"
+#include "Vfs.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+
+/**
+ * @brief The record that getdents64() returns; glibc does not declare it.
+ */
+struct LinuxDirent64 {
+    quint64 d_ino;
+    qint64 d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+#endif
+
+static const int DirectoryFlags = O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC;
+
+QByteArray FileTreeEntry::path() const {
+    QByteArray result = *parentPath;
+    if (!result.endsWith('/')) {
+        result += '/';
+    }
+    return result + name;
+}
+
+QString FileTreeEntry::filePath() const {
+    return QFile::decodeName(path());
+}
+
+FileTreeWalker::FileTreeWalker(FileTreeVisitor* visitor) : m_visitor(visitor) {
+
+}
+
+bool FileTreeWalker::walk(const QString& path) {
+    m_stopped.store(false, std::memory_order_relaxed);
+
+    QFileInfo info(path);
+    QByteArray encoded = QFile::encodeName(QDir::cleanPath(info.absoluteFilePath()));
+    QByteArray parentPath;
+    QByteArray name;
+    if (encoded == "/") {
+        parentPath = "/";
+        name = ".";
+    } else {
+        int slash = encoded.lastIndexOf('/');
+        parentPath = slash == 0 ? QByteArray("/") : encoded.left(slash);
+        name = encoded.mid(slash + 1);
+    }
+
+    Frame parent{::open(parentPath.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC), parentPath};
+    if (parent.fd < 0) {
+        qDebug() << "Cannot open" << parentPath << ":" << strerror(errno);
+        return false;
+    }
+
+    Context context;
+    context.maxOpen = m_maxOpenDirectories;
+    context.nested = false;
+    push(context, &parent);
+
+    FileTreeEntry entry;
+    entry.parentFd = parent.fd;
+    entry.name = name.constData();
+    entry.parentPath = &parent.path;
+    entry.depth = 0;
+    bool ok = false;
+    Vfs::instance()->account(Vfs::Stat);
+    if (fstatat(parent.fd, entry.name, &entry.stat, AT_SYMLINK_NOFOLLOW) != 0) {
+        qDebug() << "Cannot stat" << encoded << ":" << strerror(errno);
+    } else {
+        entry.hasStat = true;
+        entry.type = S_ISDIR(entry.stat.st_mode) ? FileTreeEntry::Directory
+                   : S_ISLNK(entry.stat.st_mode) ? FileTreeEntry::SymLink
+                   : S_ISREG(entry.stat.st_mode) ? FileTreeEntry::File
+                   : FileTreeEntry::Other;
+        FileTreeVisitor::Action action = m_visitor->enter(entry);
+        ok = visit(action);
+        if (ok && action == FileTreeVisitor::Continue && entry.type == FileTreeEntry::Directory) {
+            ok = descend(context, parent, entry);
+        }
+    }
+
+    pop(context);
+    return ok && !m_stopped.load(std::memory_order_relaxed);
+}
+
+bool FileTreeWalker::walkDirectory(Context& context, Frame& directory, int depth) {
+    QVector<Child> children;
+    if (!readDirectory(directory.fd, children)) {
+        return visit(m_visitor->failed(directory.path, errno));
+    }
+
+    bool split = !context.nested && m_threadCount > 1 && depth <= m_splitDepth;
+    QVector<FileTreeEntry> subtrees;
+
+    for (const Child& child : children) {
+        if (m_stopped.load(std::memory_order_relaxed) || !ensureOpen(context, directory)) {
+            return false;
+        }
+
+        FileTreeEntry entry;
+        entry.parentFd = directory.fd;
+        entry.name = child.name.constData();
+        entry.parentPath = &directory.path;
+        entry.depth = depth + 1;
+        if (!fillEntry(entry, child.type)) {
+            // Vanished since the directory was read
+            continue;
+        }
+
+        FileTreeVisitor::Action action = m_visitor->enter(entry);
+        if (!visit(action)) {
+            return false;
+        }
+        if (action != FileTreeVisitor::Continue || entry.type != FileTreeEntry::Directory) {
+            continue;
+        }
+        if (split) {
+            subtrees.append(entry);
+            continue;
+        }
+        if (!descend(context, directory, entry)) {
+            return false;
+        }
+    }
+
+    if (subtrees.isEmpty()) {
+        return true;
+    }
+    if (subtrees.size() == 1) {
+        // Nothing to split here; maybe further down
+        return ensureOpen(context, directory) && descend(context, directory, subtrees[0]);
+    }
+
+    // The directory stays open while the other threads walk its subdirectories; they use its fd
+    // read-only and do not put it on their own stacks
+    if (!ensureOpen(context, directory)) {
+        return false;
+    }
+    std::atomic<int> next{0};
+    std::atomic<bool> ok{true};
+    auto work = [&]() {
+        Context nested;
+        nested.maxOpen = qMax(2, m_maxOpenDirectories / m_threadCount);
+        nested.nested = true;
+        for (int i = next.fetch_add(1); i < subtrees.size() && ok.load(); i = next.fetch_add(1)) {
+            FileTreeEntry entry = subtrees.at(i);
+            entry.parentFd = directory.fd;
+            if (!descend(nested, directory, entry)) {
+                ok.store(false);
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int i = 1; i < qMin(m_threadCount, subtrees.size()); i++) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return ok.load();
+}
+
+bool FileTreeWalker::descend(Context& context, Frame& parent, FileTreeEntry& entry) {
+    // In a nested context, the parent belongs to another thread, which keeps it open
+    if (context.stack.contains(&parent) && !ensureOpen(context, parent)) {
+        return false;
+    }
+    Vfs::instance()->account(Vfs::Open);
+    Frame directory{openat(parent.fd, entry.name, DirectoryFlags), QByteArray()};
+    directory.path = entry.path();
+    if (directory.fd < 0) {
+        return visit(m_visitor->failed(directory.path, errno));
+    }
+
+    push(context, &directory);
+    bool ok = walkDirectory(context, directory, entry.depth);
+    pop(context);
+    if (!ok) {
+        return false;
+    }
+
+    if (context.stack.contains(&parent) && !ensureOpen(context, parent)) {
+        return false;
+    }
+    entry.parentFd = parent.fd;
+    if (!m_visitor->leave(entry)) {
+        m_stopped.store(true, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+bool FileTreeWalker::fillEntry(FileTreeEntry& entry, unsigned char type) {
+    switch (type) {
+    case DT_DIR:
+        entry.type = FileTreeEntry::Directory;
+        break;
+    case DT_LNK:
+        entry.type = FileTreeEntry::SymLink;
+        break;
+    case DT_REG:
+        entry.type = FileTreeEntry::File;
+        break;
+    case DT_UNKNOWN:
+        break;
+    default:
+        entry.type = FileTreeEntry::Other;
+        break;
+    }
+
+    bool needStat = type == DT_UNKNOWN || m_statMode == StatAll || (m_statMode == StatFiles && type == DT_REG);
+    entry.hasStat = false;
+    if (!needStat) {
+        return true;
+    }
+    Vfs::instance()->account(Vfs::Stat);
+    if (fstatat(entry.parentFd, entry.name, &entry.stat, AT_SYMLINK_NOFOLLOW) != 0) {
+        return false;
+    }
+    entry.hasStat = true;
+    entry.type = S_ISDIR(entry.stat.st_mode) ? FileTreeEntry::Directory
+               : S_ISLNK(entry.stat.st_mode) ? FileTreeEntry::SymLink
+               : S_ISREG(entry.stat.st_mode) ? FileTreeEntry::File
+               : FileTreeEntry::Other;
+    return true;
+}
+
+bool FileTreeWalker::ensureOpen(Context& context, Frame& frame) {
+    if (frame.fd >= 0) {
+        return true;
+    }
+    Vfs::instance()->account(Vfs::Open);
+    frame.fd = ::open(frame.path.constData(), DirectoryFlags);
+    if (frame.fd < 0) {
+        visit(m_visitor->failed(frame.path, errno));
+        m_stopped.store(true, std::memory_order_relaxed);
+        return false;
+    }
+    context.openCount++;
+    return true;
+}
+
+void FileTreeWalker::push(Context& context, Frame* frame) {
+    context.stack.append(frame);
+    context.openCount++;
+
+    // Close the ancestors that are furthest away; they are reopened by path when the walk returns to them
+    for (Frame* ancestor : qAsConst(context.stack)) {
+        if (context.openCount <= context.maxOpen) {
+            break;
+        }
+        if (ancestor->fd >= 0) {
+            ::close(ancestor->fd);
+            ancestor->fd = -1;
+            context.openCount--;
+        }
+    }
+}
+
+void FileTreeWalker::pop(Context& context) {
+    Frame* frame = context.stack.takeLast();
+    if (frame->fd >= 0) {
+        ::close(frame->fd);
+        frame->fd = -1;
+        context.openCount--;
+    }
+}
+
+bool FileTreeWalker::visit(FileTreeVisitor::Action action) {
+    if (action == FileTreeVisitor::Stop) {
+        m_stopped.store(true, std::memory_order_relaxed);
+        return false;
+    }
+    return !m_stopped.load(std::memory_order_relaxed);
+}
+
+bool FileTreeWalker::readDirectory(int fd, QVector<Child>& children) {
+    // Works on descriptors like the copy backends, hence only accounts to the Vfs, which may delay it
+    Vfs::instance()->account(Vfs::List);
+#ifdef __linux__
+    // getdents64() fills one large buffer per call instead of going through readdir() entry by entry
+    QByteArray buffer(64 * 1024, Qt::Uninitialized);
+    for (;;) {
+        long count = syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+        if (count < 0) {
+            return false;
+        }
+        if (count == 0) {
+            return true;
+        }
+        for (long offset = 0; offset < count;) {
+            const LinuxDirent64* record = reinterpret_cast<const LinuxDirent64*>(buffer.constData() + offset);
+            offset += record->d_reclen;
+            const char* name = record->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                continue;
+            }
+            children.append(Child{QByteArray(name), record->d_type});
+        }
+    }
+#else
+    // fdopendir() takes ownership of the descriptor, which the walk still needs
+    int readFd = dup(fd);
+    if (readFd < 0) {
+        return false;
+    }
+    DIR* dir = fdopendir(readFd);
+    if (!dir) {
+        ::close(readFd);
+        return false;
+    }
+    errno = 0;
+    while (struct dirent* record = readdir(dir)) {
+        const char* name = record->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+        children.append(Child{QByteArray(name), record->d_type});
+    }
+    int error = errno;
+    closedir(dir);
+    errno = error;
+    return error == 0;
+#endif
+}
@@ -0,0 +1,155 @@
+#ifndef FILETREEWALKER_H
+#define FILETREEWALKER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <sys/stat.h>
+
+/**
+ * @brief An entry of a file tree, as passed to a FileTreeVisitor.
+ *
+ * The entry is only valid during the callback. Use parentFd and name with the *at() system calls
+ * instead of the full path wherever possible; this avoids resolving every path component again.
+ */
+struct FileTreeEntry {
+    enum Type { File, Directory, SymLink, Other };
+
+    int parentFd; /**< Open file descriptor of the directory containing the entry. */
+    const char* name; /**< Name of the entry relative to parentFd. */
+    const QByteArray* parentPath; /**< Encoded path of the directory containing the entry. */
+    Type type;
+    int depth; /**< 0 for the path passed to FileTreeWalker::walk(). */
+    bool hasStat; /**< Whether stat holds the result of fstatat() for the entry. */
+    struct stat stat;
+
+    /**
+     * @brief Builds the encoded full path of the entry.
+     */
+    QByteArray path() const;
+
+    /**
+     * @brief Builds the full path of the entry.
+     */
+    QString filePath() const;
+};
+
+/**
+ * @brief Receives the entries of a file tree from a FileTreeWalker.
+ * @note If the walker uses more than one thread, the methods are called concurrently.
+ */
+class FileTreeVisitor {
+public:
+    enum Action { Continue, SkipSubtree, Stop };
+
+    virtual ~FileTreeVisitor() = default;
+
+    /**
+     * @brief Called for every entry; for directories, before their contents.
+     */
+    virtual Action enter(const FileTreeEntry& entry) = 0;
+
+    /**
+     * @brief Called for directories after their contents.
+     * @return false to stop the walk.
+     */
+    virtual bool leave(const FileTreeEntry& entry) { Q_UNUSED(entry); return true; }
+
+    /**
+     * @brief Called when a directory cannot be opened or read.
+     * @param path The encoded path of the directory.
+     * @param error The errno value.
+     */
+    virtual Action failed(const QByteArray& path, int error) { Q_UNUSED(path); Q_UNUSED(error); return Stop; }
+};
+
+/**
+ * @file FileTreeWalker.h
+ * @class FileTreeWalker
+ * @brief Walks file trees relative to directory file descriptors.
+ *
+ * Directories are read with getdents64() on Linux and readdir() elsewhere, and the type in the
+ * directory entry is used so that most entries do not need a stat() at all. Entries that do are
+ * examined with fstatat() relative to their directory. Symbolic links are never followed.
+ *
+ * At most a fixed number of directories is kept open; in very deep trees, the ancestors that are
+ * furthest away are closed and reopened by path when the walk returns to them. Optionally, the
+ * subdirectories near the top of the tree are walked by several threads in parallel.
+ */
+class FileTreeWalker {
+public:
+    enum StatMode {
+        StatNone, /**< Only when the directory entry does not tell the type. */
+        StatFiles, /**< Regular files as well, e.g., to get their size. */
+        StatAll /**< Every entry. */
+    };
+
+    explicit FileTreeWalker(FileTreeVisitor* visitor);
+
+    void setStatMode(StatMode mode) { m_statMode = mode; }
+
+    /**
+     * @brief Sets the number of threads; with more than one, the visitor must be thread-safe.
+     */
+    void setThreadCount(int count) { m_threadCount = qMax(1, count); }
+
+    /**
+     * @brief Sets how deep in the tree subdirectories are still handed to other threads.
+     * @param depth 0 splits only the subdirectories of the path that is walked.
+     */
+    void setSplitDepth(int depth) { m_splitDepth = depth; }
+
+    /**
+     * @brief Sets the maximum number of directory file descriptors kept open per thread.
+     */
+    void setMaxOpenDirectories(int count) { m_maxOpenDirectories = qMax(2, count); }
+
+    /**
+     * @brief Walks the given path, which is visited itself first; directories are walked recursively.
+     * @return false if the walk was stopped by the visitor or the path does not exist.
+     */
+    bool walk(const QString& path);
+
+    /**
+     * @brief Stops the walk as soon as possible; may be called from any thread.
+     */
+    void stop() { m_stopped.store(true, std::memory_order_relaxed); }
+
+private:
+    struct Frame {
+        int fd;
+        QByteArray path;
+    };
+
+    struct Child {
+        QByteArray name;
+        unsigned char type;
+    };
+
+    struct Context {
+        QVector<Frame*> stack;
+        int openCount = 0;
+        int maxOpen;
+        bool nested; /**< Whether the context runs a subtree on behalf of another thread. */
+    };
+
+    bool walkDirectory(Context& context, Frame& directory, int depth);
+    bool descend(Context& context, Frame& parent, FileTreeEntry& entry);
+    bool fillEntry(FileTreeEntry& entry, unsigned char type);
+    bool ensureOpen(Context& context, Frame& frame);
+    void push(Context& context, Frame* frame);
+    void pop(Context& context);
+    bool visit(FileTreeVisitor::Action action);
+
+    static bool readDirectory(int fd, QVector<Child>& children);
+
+    FileTreeVisitor* m_visitor;
+    StatMode m_statMode = StatNone;
+    int m_threadCount = 1;
+    int m_splitDepth = 0;
+    int m_maxOpenDirectories = 64;
+    std::atomic<bool> m_stopped{false};
+};
+
+#endif // FILETREEWALKER_H
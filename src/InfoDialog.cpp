@@ -43,8 +43,11 @@
 #include <QProcess>
 #include <QClipboard>
 #include <QMouseEvent>
-#include <QSortFilterProxyModel>
 #include "Mountpoints.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 QMap<QString, InfoDialog*> InfoDialog::instances; // All instances of InfoDialog share this map
 
@@ -162,32 +165,15 @@ void InfoDialog::setupInformation()
     QIcon icon = QIcon::fromTheme("unknown");
     ui->iconInfo->setPixmap(icon.pixmap(128, 128));
 
-    // Get the icon from CustomFileIconProvider
-    CustomFileIconProvider *iconProvider = new CustomFileIconProvider();
-
-    // CustomFileSystemModel *model = new CustomFileSystemModel();
-    // Parent directory of filePath
-    QString parentDir = filePath.mid(0, filePath.lastIndexOf("/"));
-    // Need to set a model so that we can get the proper document icon.
-    // Since CustomFileIconProvider now needs a QAbstractProxyModel, we need to create one...
-    // TODO: Make this less convoluted, e.g,. by making CustomFileIconProvider take a QAbstractItemModel
-    //  in addition to a QAbstractProxyModel
-    CustomFileSystemModel *sourceModel = new CustomFileSystemModel();
-    sourceModel->setRootPath(parentDir);
-    QSortFilterProxyModel *model = new QSortFilterProxyModel();
-    qDebug() << "Still alive";
-    model->setSourceModel(sourceModel);
-    qDebug() << "Alive no more";
-    iconProvider->setModel(model);
-
-    QIcon i = iconProvider->icon(fileInfo);
+    // Get the icon and the open-with attribute from the file system model shared with the windows,
+    // which has them cached already if the file is shown in a window
+    CustomFileSystemModel *model = CustomFileSystemModel::acquire();
+    QIcon i = model->customIconProvider()->icon(fileInfo);
     if (!i.isNull()) {
         ui->iconInfo->setPixmap(i.pixmap(128, 128));
     }
-    openWith = sourceModel->openWith(filePath); // Used below
-    delete model;
-    delete sourceModel;
-    delete iconProvider;
+    openWith = model->openWith(filePath); // Used below
+    CustomFileSystemModel::release(model);
 
     ui->pathInfo->setText(filePath);
     ui->pathInfo->setTextInteractionFlags(Qt::TextSelectableByMouse | Qt::TextSelectableByKeyboard);
@@ -325,16 +311,21 @@ void InfoDialog::setExecutable()
         return;
     }
 
-    QFile::Permissions permissions = file.permissions();
-    QProcess process;
-    if (ui->executableCheckBox->checkState() == Qt::Checked) {
-        process.start("chmod", QStringList() << "+x" << filePath);
-        process.waitForFinished();
-    } else {
-        process.start("chmod", QStringList() << "-x" << filePath);
-        process.waitForFinished();
+    // Change the mode directly rather than running chmod, which would block until it has finished
+    QByteArray path = QFile::encodeName(filePath);
+    struct stat st;
+    bool ok = (stat(path.constData(), &st) == 0);
+    if (ok) {
+        mode_t mode = st.st_mode & 07777;
+        if (ui->executableCheckBox->checkState() == Qt::Checked) {
+            mode |= S_IXUSR | S_IXGRP | S_IXOTH;
+        } else {
+            mode &= ~(S_IXUSR | S_IXGRP | S_IXOTH);
+        }
+        ok = (fchmodat(AT_FDCWD, path.constData(), mode, 0) == 0);
     }
-    if (process.exitCode() != 0) {
+    if (!ok) {
+        qDebug() << "Could not change the mode of" << filePath << ":" << strerror(errno);
         QMessageBox::warning(this, tr("Error"), tr("Error setting permissions."));
         updatePermissions();
     }
@@ -383,10 +374,10 @@ void InfoDialog::fileChanged(const QString &path)
     // The MainWindow (currently) only watches the directory, not the items inside it;
     // so we touch the parent directory to trigger a refresh. This does result in
     // an updated icon when the permissions have been changed
-    QProcess process;
     qDebug() << "Touching parent directory: " << fileInfo.dir().path();
-    process.start("touch", QStringList() << fileInfo.dir().path());
-    process.waitForFinished();
+    if (utimensat(AT_FDCWD, QFile::encodeName(fileInfo.dir().path()).constData(), nullptr, 0) != 0) {
+        qDebug() << "Could not touch" << fileInfo.dir().path() << ":" << strerror(errno);
+    }
 }
 void InfoDialog::copyIcon()
 {
@@ -0,0 +1,122 @@
+#include "LatencyVfs.h"
+#include <QDebug>
+#include <thread>
+
+namespace {
+
+// Parses "name=value,name=value" into the values per operation; returns false if nothing was set
+bool parseSettings(const char* variable, double values[Vfs::OperationCount]) {
+    QString settings = qEnvironmentVariable(variable);
+    bool found = false;
+    for (const QString& setting : settings.split(',', QString::SkipEmptyParts)) {
+        QStringList parts = setting.trimmed().split('=');
+        bool ok = false;
+        double value = parts.size() == 2 ? parts.at(1).toDouble(&ok) : 0.0;
+        if (!ok || value < 0) {
+            qWarning() << "LatencyVfs: ignoring" << setting << "in" << variable;
+            continue;
+        }
+        bool known = false;
+        for (int operation = 0; operation < Vfs::OperationCount; operation++) {
+            if (parts.at(0) == "all" || parts.at(0) == Vfs::operationName(static_cast<Vfs::Operation>(operation))) {
+                values[operation] = value;
+                known = true;
+            }
+        }
+        if (!known) {
+            qWarning() << "LatencyVfs: unknown operation" << parts.at(0) << "in" << variable;
+        }
+        found = found || known;
+    }
+    return found;
+}
+
+}
+
+LatencyVfs::LatencyVfs(std::unique_ptr<Vfs> vfs) : m_vfs(std::move(vfs)) {
+    for (int operation = 0; operation < OperationCount; operation++) {
+        m_latency[operation].store(0, std::memory_order_relaxed);
+        m_bandwidth[operation].store(0, std::memory_order_relaxed);
+    }
+}
+
+std::unique_ptr<Vfs> LatencyVfs::fromEnvironment(std::unique_ptr<Vfs> vfs) {
+    double latencies[OperationCount] = {};
+    double bandwidths[OperationCount] = {};
+    bool hasLatency = parseSettings("FILER_VFS_LATENCY", latencies);
+    bool hasBandwidth = parseSettings("FILER_VFS_BANDWIDTH", bandwidths);
+    if (!hasLatency && !hasBandwidth) {
+        return vfs;
+    }
+
+    std::unique_ptr<LatencyVfs> latencyVfs(new LatencyVfs(std::move(vfs)));
+    for (int operation = 0; operation < OperationCount; operation++) {
+        Operation op = static_cast<Operation>(operation);
+        latencyVfs->setLatency(op, std::chrono::microseconds(qRound64(latencies[operation] * 1000)));
+        latencyVfs->setBandwidth(op, qRound64(bandwidths[operation] * 1000000));
+        if (latencies[operation] > 0 || bandwidths[operation] > 0) {
+            qDebug() << "LatencyVfs:" << operationName(op) << latencies[operation] << "ms,"
+                     << bandwidths[operation] << "MB/s";
+        }
+    }
+    return std::move(latencyVfs);
+}
+
+void LatencyVfs::setLatency(Operation operation, std::chrono::microseconds latency) {
+    m_latency[operation].store(latency.count(), std::memory_order_relaxed);
+}
+
+void LatencyVfs::setBandwidth(Operation operation, qint64 bytesPerSecond) {
+    m_bandwidth[operation].store(bytesPerSecond, std::memory_order_relaxed);
+}
+
+void LatencyVfs::delay(Operation operation, qint64 bytes) {
+    qint64 latency = m_latency[operation].load(std::memory_order_relaxed);
+    if (latency > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(latency));
+    }
+
+    qint64 bandwidth = m_bandwidth[operation].load(std::memory_order_relaxed);
+    if (bandwidth <= 0 || bytes <= 0) {
+        return;
+    }
+    // Transfers queue for the link, so that the cap holds for all threads together
+    auto duration = std::chrono::nanoseconds(bytes * 1000000000LL / bandwidth);
+    std::chrono::steady_clock::time_point done;
+    {
+        std::lock_guard<std::mutex> locker(m_linkMutex);
+        done = std::max(std::chrono::steady_clock::now(), m_linkFree[operation]) + duration;
+        m_linkFree[operation] = done;
+    }
+    std::this_thread::sleep_until(done);
+}
+
+Vfs::Status LatencyVfs::status(const QString& path, bool followSymLinks) {
+    delay(Stat);
+    return m_vfs->status(path, followSymLinks);
+}
+
+QString LatencyVfs::symLinkTarget(const QString& path) {
+    delay(Stat);
+    return m_vfs->symLinkTarget(path);
+}
+
+QStringList LatencyVfs::entries(const QString& directory, const QStringList& nameFilters, QDir::Filters filters) {
+    delay(List);
+    return m_vfs->entries(directory, nameFilters, filters);
+}
+
+QByteArray LatencyVfs::readExtendedAttribute(const QString& path, const QString& name) {
+    delay(ExtendedAttribute);
+    return m_vfs->readExtendedAttribute(path, name);
+}
+
+bool LatencyVfs::writeExtendedAttribute(const QString& path, const QString& name, const QByteArray& value) {
+    delay(ExtendedAttribute);
+    return m_vfs->writeExtendedAttribute(path, name, value);
+}
+
+void LatencyVfs::account(Operation operation, qint64 bytes) {
+    delay(operation, bytes);
+    m_vfs->account(operation, bytes);
+}
@@ -0,0 +1,62 @@
+#ifndef LATENCYVFS_H
+#define LATENCYVFS_H
+
+#include "Vfs.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+/**
+ * @file LatencyVfs.h
+ * @class LatencyVfs
+ * @brief Makes another Vfs behave like slow media by delaying every operation and capping the bandwidth.
+ *
+ * Each operation waits for its latency before it is passed on. Reads and writes also share a link
+ * of the configured bandwidth per direction, as they would on a USB stick or a network share, so
+ * that concurrent transfers slow each other down.
+ *
+ * Vfs::instance() is a LatencyVfs if the environment configures one, e.g.:
+ *
+ *     FILER_VFS_LATENCY=stat=5,list=20,open=5,xattr=5    # Milliseconds per operation
+ *     FILER_VFS_BANDWIDTH=read=20,write=10               # Megabytes per second
+ *
+ * The operations are named as by Vfs::operationName(); "all" sets every operation.
+ */
+class LatencyVfs : public Vfs {
+public:
+    explicit LatencyVfs(std::unique_ptr<Vfs> vfs);
+
+    /**
+     * @brief Wraps vfs in a LatencyVfs as configured by FILER_VFS_LATENCY and FILER_VFS_BANDWIDTH.
+     * @return vfs itself if neither is set.
+     */
+    static std::unique_ptr<Vfs> fromEnvironment(std::unique_ptr<Vfs> vfs);
+
+    void setLatency(Operation operation, std::chrono::microseconds latency);
+
+    /**
+     * @param bytesPerSecond The cap for Read or Write; 0 removes it.
+     */
+    void setBandwidth(Operation operation, qint64 bytesPerSecond);
+
+    Status status(const QString& path, bool followSymLinks = true) override;
+    QString symLinkTarget(const QString& path) override;
+    QStringList entries(const QString& directory, const QStringList& nameFilters = QStringList(),
+                        QDir::Filters filters = QDir::NoFilter) override;
+    QByteArray readExtendedAttribute(const QString& path, const QString& name) override;
+    bool writeExtendedAttribute(const QString& path, const QString& name, const QByteArray& value) override;
+    void account(Operation operation, qint64 bytes = 0) override;
+    bool isSimulated() const override { return true; }
+
+private:
+    void delay(Operation operation, qint64 bytes = 0);
+
+    std::unique_ptr<Vfs> m_vfs;
+    std::atomic<qint64> m_latency[OperationCount];       /**< Microseconds. */
+    std::atomic<qint64> m_bandwidth[OperationCount];     /**< Bytes per second. */
+    std::mutex m_linkMutex;
+    std::chrono::steady_clock::time_point m_linkFree[OperationCount]; /**< When the link of each direction is idle. */
+};
+
+#endif // LATENCYVFS_H
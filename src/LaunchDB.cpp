@@ -27,6 +27,8 @@
 #include "LaunchDB.h"
 #include <QDir>
 #include <QDebug>
+#include "Trace.h"
+#include "Vfs.h"
 
 LaunchDB::LaunchDB() {
     db = new QMimeDatabase;
@@ -37,6 +39,7 @@ LaunchDB::~LaunchDB() {
 }
 
 QString LaunchDB::applicationForFile(const QFileInfo &fileInfo) const {
+    FILER_TRACE_SCOPE("launchdb-lookup");
     // Check if the file exists
     if (!fileInfo.exists()) {
         return QString(); // Return an empty QString if the file doesn't exist
@@ -56,32 +59,33 @@ QString LaunchDB::applicationForFile(const QFileInfo &fileInfo) const {
 
     // If we have "text/x-pdf, see whether ~/.local/share/launch/MIME/text_x-pdf/ exists (just as an example)
     QString mimeDir = QDir::homePath() + "/.local/share/launch/MIME/" + mimeType.name().replace("/", "_");
-    if (QDir(mimeDir).exists()) {
+    Vfs* vfs = Vfs::instance();
+    if (vfs->status(mimeDir).isDirectory) {
         // If there is a default application for the MIME type, then return it
         QString defaultApplication = mimeDir + "/Default";
-        if (QFile(defaultApplication).exists()) {
+        if (vfs->exists(defaultApplication)) {
             defaultApplication = QFileInfo(defaultApplication).absoluteFilePath();
             // If it is a symlink, then resolve it
-            if (QFileInfo(defaultApplication).isSymLink()) {
-                defaultApplication = QFileInfo(defaultApplication).symLinkTarget();
+            if (vfs->status(defaultApplication, false).isSymLink) {
+                defaultApplication = vfs->symLinkTarget(defaultApplication);
             }
-            if (!QFile(defaultApplication).exists()) {
+            if (!vfs->exists(defaultApplication)) {
                 return QString();
             }
             return defaultApplication;
         }
         // If there is only one application for the MIME type (not counting the default application), then return it
-        QStringList applications = QDir(mimeDir).entryList(QDir::Files);
+        QStringList applications = vfs->entries(mimeDir, QStringList(), QDir::Files);
         // applications.removeAll("Default");
         if (applications.size() == 1) {
             QString application = mimeDir + "/" + applications.at(0);
-            if (QFile(application).exists()) {
+            if (vfs->exists(application)) {
                 application = QFileInfo(application).absoluteFilePath();
                 // If it is a symlink, then resolve it
-                if (QFileInfo(application).isSymLink()) {
-                    application = QFileInfo(application).symLinkTarget();
+                if (vfs->status(application, false).isSymLink) {
+                    application = vfs->symLinkTarget(application);
                 }
-                if (!QFile(application).exists()) {
+                if (!vfs->exists(application)) {
                     return QString();
                 }
                 return application;
@@ -0,0 +1,104 @@
+#include "LocalVfs.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QDebug>
+#include <sys/stat.h>
+
+Vfs::Status LocalVfs::status(const QString& path, bool followSymLinks) {
+    Status status;
+    QByteArray encodedPath = QFile::encodeName(path);
+    struct stat buffer;
+    int result = followSymLinks ? ::stat(encodedPath.constData(), &buffer) : ::lstat(encodedPath.constData(), &buffer);
+    if (result != 0) {
+        return status;
+    }
+    status.exists = true;
+    status.isDirectory = S_ISDIR(buffer.st_mode);
+    status.isSymLink = S_ISLNK(buffer.st_mode);
+    status.isExecutable = (buffer.st_mode & (S_IXUSR | S_IXGRP | S_IXOTH)) != 0;
+    status.size = buffer.st_size;
+    return status;
+}
+
+QString LocalVfs::symLinkTarget(const QString& path) {
+    return QFileInfo(path).symLinkTarget();
+}
+
+QStringList LocalVfs::entries(const QString& directory, const QStringList& nameFilters, QDir::Filters filters) {
+    return QDir(directory).entryList(nameFilters, filters);
+}
+
+QByteArray LocalVfs::readExtendedAttribute(const QString& path, const QString& name) {
+#if defined(__unix__) || defined(__APPLE__)
+    // Read the extended attribute from the file in the "user" namespace
+    QProcess extattr;
+    extattr.start("getextattr",
+                  QStringList() << "-hq"
+                                << "user" << name << path);
+    if (!extattr.waitForFinished()) {
+        // Error reading extended attribute from user namespace
+        qWarning() << "LocalVfs::readExtendedAttribute(): Error reading extended attribute from user "
+                      "namespace";
+        return QByteArray();
+    }
+    return extattr.readAllStandardOutput().trimmed();
+#elif defined(__linux__)
+    // Read the extended attribute from the file in the "user" namespace
+    qDebug() << "Reading extended attribute" << name << "from file" << path;
+    QProcess xattr;
+    xattr.start("getfattr",
+                QStringList() << "-n" << "user." + name
+                            << "-d" << path);
+    if (!xattr.waitForFinished()) {
+        // Error reading extended attribute from user namespace
+        qWarning() << "LocalVfs::readExtendedAttribute(): Error reading extended attribute from user "
+                      "namespace";
+        return QByteArray();
+    }
+
+    QByteArray attributeValue = xattr.readAllStandardOutput().trimmed();
+    qDebug() << "LocalVfs::readExtendedAttribute():" << name << " " << attributeValue;
+    return attributeValue;
+#else
+    Q_UNUSED(path)
+    Q_UNUSED(name)
+    return QByteArray();
+#endif
+}
+
+bool LocalVfs::writeExtendedAttribute(const QString& path, const QString& name, const QByteArray& value) {
+#if defined(__unix__) || defined(__APPLE__)
+    // Write the extended attribute to the file in the "user" namespace
+    qDebug() << "Writing extended attribute" << name << "with value" << value << "to file" << path;
+    QProcess extattr;
+    extattr.start("setextattr",
+                  QStringList() << "-hq"
+                                << "user" << name << value << path);
+    if (!extattr.waitForFinished()) {
+        // Error writing extended attribute to user namespace
+        qWarning() << "LocalVfs::writeExtendedAttribute(): Error writing extended attribute to user "
+                      "namespace";
+        return false;
+    }
+#elif defined(__linux__)
+    qDebug() << "Writing extended attribute" << name << "with value" << value << "to file" << path;
+    // Write the extended attribute to the file in the "user" namespace
+    QProcess xattr;
+    xattr.start("setfattr",
+                QStringList() << "-n" << "user." + name
+                            << "-v" << value
+                            << path);
+    if (!xattr.waitForFinished()) {
+        // Error writing extended attribute to user namespace
+        qWarning() << "LocalVfs::writeExtendedAttribute(): Error writing extended attribute to user "
+                      "namespace";
+        return false;
+    }
+#else
+    Q_UNUSED(path)
+    Q_UNUSED(name)
+    Q_UNUSED(value)
+#endif
+    return true;
+}
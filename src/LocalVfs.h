@@ -0,0 +1,25 @@
+#ifndef LOCALVFS_H
+#define LOCALVFS_H
+
+#include "Vfs.h"
+
+/**
+ * @file LocalVfs.h
+ * @class LocalVfs
+ * @brief The file systems of this machine, as the kernel provides them.
+ *
+ * Extended attributes are read and written with the command line tools rather than system calls,
+ * because the tools can be setuid root; this allows setting attributes on files that the user
+ * cannot write to.
+ */
+class LocalVfs : public Vfs {
+public:
+    Status status(const QString& path, bool followSymLinks = true) override;
+    QString symLinkTarget(const QString& path) override;
+    QStringList entries(const QString& directory, const QStringList& nameFilters = QStringList(),
+                        QDir::Filters filters = QDir::NoFilter) override;
+    QByteArray readExtendedAttribute(const QString& path, const QString& name) override;
+    bool writeExtendedAttribute(const QString& path, const QString& name, const QByteArray& value) override;
+};
+
+#endif // LOCALVFS_H
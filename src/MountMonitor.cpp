@@ -0,0 +1,193 @@
+#include "MountMonitor.h"
+#include <QCoreApplication>
+#include <QSocketNotifier>
+#include <QStorageInfo>
+#include <QTimer>
+#include <QThread>
+#include <QFile>
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef __FreeBSD__
+#include <sys/param.h>
+#include <sys/ucred.h>
+#include <sys/mount.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+// How often the mount table is read where the kernel does not tell about changes
+static const int PollInterval = 2000;
+
+static MountMonitor* monitorInstance = nullptr;
+
+#ifdef __linux__
+// Mount points in mountinfo have spaces, tabs, newlines and backslashes escaped as octal
+static QByteArray unescapeMountPoint(const QByteArray& escaped) {
+    QByteArray result;
+    result.reserve(escaped.size());
+    for (int i = 0; i < escaped.size(); i++) {
+        if (escaped.at(i) == '\\' && i + 3 < escaped.size()) {
+            bool ok;
+            int value = escaped.mid(i + 1, 3).toInt(&ok, 8);
+            if (ok) {
+                result += char(value);
+                i += 3;
+                continue;
+            }
+        }
+        result += escaped.at(i);
+    }
+    return result;
+}
+#endif
+
+MountMonitor::MountMonitor(QObject* parent) : QObject(parent) {
+#if defined(__linux__)
+    m_fd = ::open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+    if (m_fd >= 0) {
+        // The kernel flags the file with POLLPRI whenever the mount table changes, which
+        // Qt reports as an exception on the socket notifier
+        m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Exception, this);
+    }
+#elif defined(__FreeBSD__)
+    // devd announces "!system=VFS subsystem=FS type=MOUNT" and "type=UNMOUNT" on this socket
+    m_fd = socket(PF_LOCAL, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (m_fd >= 0) {
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        strlcpy(address.sun_path, "/var/run/devd.seqpacket.pipe", sizeof(address.sun_path));
+        if (::connect(m_fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) == 0) {
+            m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+        } else {
+            qDebug() << "MountMonitor: Cannot connect to devd:" << strerror(errno);
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+#endif
+
+    if (m_notifier) {
+        connect(m_notifier, &QSocketNotifier::activated, this, &MountMonitor::refresh);
+    } else {
+        qDebug() << "MountMonitor: Polling the mount table";
+        m_pollTimer = new QTimer(this);
+        connect(m_pollTimer, &QTimer::timeout, this, &MountMonitor::refresh);
+        m_pollTimer->start(PollInterval);
+    }
+
+    m_eventDriven = m_notifier != nullptr;
+    m_mountPoints = std::make_shared<const QSet<QString>>(readMountTable());
+}
+
+MountMonitor::~MountMonitor() {
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+}
+
+void MountMonitor::create() {
+    Q_ASSERT(QThread::currentThread() == qApp->thread());
+    if (!monitorInstance) {
+        monitorInstance = new MountMonitor(qApp);
+    }
+}
+
+MountMonitor* MountMonitor::instance() {
+    Q_ASSERT_X(monitorInstance, "MountMonitor::instance", "MountMonitor::create() was not called");
+    return monitorInstance;
+}
+
+void MountMonitor::refresh() {
+#ifdef __FreeBSD__
+    // Drain the announcements; only VFS events concern the mount table
+    if (m_fd >= 0) {
+        bool mountChanged = false;
+        char message[1024];
+        ssize_t length;
+        while ((length = recv(m_fd, message, sizeof(message) - 1, 0)) > 0) {
+            message[length] = '\0';
+            if (strstr(message, "system=VFS")) {
+                mountChanged = true;
+            }
+        }
+        if (length == 0) {
+            // devd has gone away; fall back to polling
+            m_notifier->setEnabled(false);
+            m_notifier->deleteLater();
+            m_notifier = nullptr;
+            m_eventDriven = false;
+            ::close(m_fd);
+            m_fd = -1;
+            m_pollTimer = new QTimer(this);
+            connect(m_pollTimer, &QTimer::timeout, this, &MountMonitor::refresh);
+            m_pollTimer->start(PollInterval);
+        }
+        if (!mountChanged && m_notifier) {
+            return;
+        }
+    }
+#endif
+
+    QSet<QString> mountPoints = readMountTable();
+    std::shared_ptr<const QSet<QString>> previous = table();
+    if (mountPoints == *previous) {
+        return;
+    }
+    std::atomic_store(&m_mountPoints, std::make_shared<const QSet<QString>>(mountPoints));
+
+    for (const QString& mountPoint : *previous) {
+        if (!mountPoints.contains(mountPoint)) {
+            qDebug() << "MountMonitor: Unmounted" << mountPoint;
+            emit unmounted(mountPoint);
+        }
+    }
+    for (const QString& mountPoint : qAsConst(mountPoints)) {
+        if (!previous->contains(mountPoint)) {
+            qDebug() << "MountMonitor: Mounted" << mountPoint;
+            emit mounted(mountPoint);
+        }
+    }
+    emit changed();
+}
+
+QSet<QString> MountMonitor::readMountTable() {
+    QSet<QString> mountPoints;
+
+#if defined(__linux__)
+    if (m_fd >= 0 && lseek(m_fd, 0, SEEK_SET) == 0) {
+        QByteArray contents;
+        char buffer[16 * 1024];
+        ssize_t length;
+        while ((length = read(m_fd, buffer, sizeof(buffer))) > 0) {
+            contents.append(buffer, int(length));
+        }
+        // Each line reads "id parent major:minor root mountpoint options ..."
+        for (const QByteArray& line : contents.split('\n')) {
+            QList<QByteArray> fields = line.split(' ');
+            if (fields.size() > 4) {
+                mountPoints.insert(QFile::decodeName(unescapeMountPoint(fields.at(4))));
+            }
+        }
+        return mountPoints;
+    }
+#elif defined(__FreeBSD__)
+    struct statfs* mounts;
+    int count = getmntinfo(&mounts, MNT_NOWAIT);
+    for (int i = 0; i < count; i++) {
+        mountPoints.insert(QFile::decodeName(mounts[i].f_mntonname));
+    }
+    if (count > 0) {
+        return mountPoints;
+    }
+#endif
+
+    for (const QStorageInfo& storage : QStorageInfo::mountedVolumes()) {
+        mountPoints.insert(storage.rootPath());
+    }
+    return mountPoints;
+}
@@ -0,0 +1,79 @@
+#ifndef MOUNTMONITOR_H
+#define MOUNTMONITOR_H
+
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <atomic>
+#include <memory>
+
+class QSocketNotifier;
+class QTimer;
+
+/**
+ * @file MountMonitor.h
+ * @class MountMonitor
+ * @brief Keeps an in-memory copy of the mount table and reports mounts and unmounts.
+ *
+ * The table is only read again when the kernel signals that it has changed: on Linux,
+ * /proc/self/mountinfo becomes ready for POLLPRI; on FreeBSD, devd announces VFS events.
+ * Elsewhere, or if neither is available, the table is polled. The new table is compared
+ * with the previous one, and the differences are emitted as signals on the event loop,
+ * so that nothing ever sleeps or blocks the user interface.
+ *
+ * The queries may be called from any thread, e.g., by the icon provider on the thread that
+ * QFileSystemModel gathers file information on; each change publishes a new immutable table.
+ */
+class MountMonitor : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Creates the monitor; must be called on the GUI thread before instance() is used.
+     */
+    static void create();
+
+    static MountMonitor* instance();
+
+    /**
+     * @brief Returns the paths at which file systems are mounted.
+     */
+    QStringList mountPoints() const { return table()->values(); }
+
+    /**
+     * @brief Returns whether a file system is mounted at the given absolute, clean path.
+     */
+    bool isMountPoint(const QString& path) const { return table()->contains(path); }
+
+    /**
+     * @brief Returns whether the kernel tells about changes, as opposed to the table being polled.
+     */
+    bool isEventDriven() const { return m_eventDriven.load(std::memory_order_relaxed); }
+
+signals:
+    void mounted(const QString& mountPoint);
+    void unmounted(const QString& mountPoint);
+
+    /**
+     * @brief Emitted after the mounted() and unmounted() signals for one change of the table.
+     */
+    void changed();
+
+private slots:
+    void refresh();
+
+private:
+    explicit MountMonitor(QObject* parent = nullptr);
+    ~MountMonitor();
+
+    QSet<QString> readMountTable();
+    std::shared_ptr<const QSet<QString>> table() const { return std::atomic_load(&m_mountPoints); }
+
+    std::shared_ptr<const QSet<QString>> m_mountPoints; /**< Replaced as a whole, never modified. */
+    std::atomic<bool> m_eventDriven{false};
+    int m_fd = -1; /**< /proc/self/mountinfo on Linux, the devd socket on FreeBSD. */
+    QSocketNotifier* m_notifier = nullptr;
+    QTimer* m_pollTimer = nullptr;
+};
+
+#endif // MOUNTMONITOR_H
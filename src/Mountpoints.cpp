@@ -25,26 +25,83 @@
  */
 
 #include "Mountpoints.h"
+#include "MountMonitor.h"
+#include <QDir>
+#include <QFile>
+#include <sys/stat.h>
 
-bool Mountpoints::isMountpoint(const QString &path)
+// Whether path is absolute and has no empty, "." or ".." components, as QDir::cleanPath() would return it
+static bool isCleanAbsolutePath(const QString &path)
 {
-    bool isMountpoint = true;
+    const int length = path.size();
+    if (length == 0 || path.at(0) != QLatin1Char('/')) {
+        return false;
+    }
+    if (length == 1) {
+        return true;
+    }
+    if (path.at(length - 1) == QLatin1Char('/')) {
+        return false;
+    }
+    for (int i = 0; i < length; i++) {
+        if (path.at(i) != QLatin1Char('/')) {
+            continue;
+        }
+        // The component after this slash
+        int end = i + 1;
+        while (end < length && path.at(end) != QLatin1Char('/')) {
+            end++;
+        }
+        int componentLength = end - i - 1;
+        if (componentLength == 0
+            || (componentLength == 1 && path.at(i + 1) == QLatin1Char('.'))
+            || (componentLength == 2 && path.at(i + 1) == QLatin1Char('.') && path.at(i + 2) == QLatin1Char('.'))) {
+            return false;
+        }
+        i = end - 1;
+    }
+    return true;
+}
 
-    QFileInfo fileInfo(path);
+bool Mountpoints::isMountpoint(const QString &path, bool mightBeSymLink)
+{
+    MountMonitor* monitor = MountMonitor::instance();
 
-    QStringList mountpoints;
-    for (const QStorageInfo &storage : QStorageInfo::mountedVolumes()) {
-        mountpoints << storage.rootPath();
+    // Callers mostly pass absolute paths, which are looked up in the cached mount table right away
+    if (monitor->isMountPoint(path)) {
+        return true;
+    }
+    // The table is up to date, and neither a link nor another spelling of the path can lead elsewhere
+    if (!mightBeSymLink && monitor->isEventDriven() && isCleanAbsolutePath(path)) {
+        return false;
     }
 
-    QString absoluteFilePathWithSymlinksResolved = fileInfo.absoluteFilePath();
-    if (fileInfo.isSymLink()) {
-        absoluteFilePathWithSymlinksResolved = fileInfo.symLinkTarget();
+    QByteArray encodedPath = QFile::encodeName(path);
+    struct stat info;
+    if (lstat(encodedPath.constData(), &info) != 0) {
+        return false;
     }
 
-    if (!mountpoints.contains(absoluteFilePathWithSymlinksResolved)) {
-        isMountpoint = false;
+    QFileInfo fileInfo(path);
+    if (S_ISLNK(info.st_mode)) {
+        return monitor->isMountPoint(QDir::cleanPath(fileInfo.symLinkTarget()));
+    }
+    if (!S_ISDIR(info.st_mode)) {
+        return false;
+    }
+    QString absolutePath = QDir::cleanPath(fileInfo.absoluteFilePath());
+    if (absolutePath != path && monitor->isMountPoint(absolutePath)) {
+        return true;
+    }
+    if (monitor->isEventDriven()) {
+        // The table is up to date
+        return false;
     }
 
-    return isMountpoint;
+    // The polled table may lag behind; a directory on another device than its parent is a mount point
+    struct stat parentInfo;
+    if (stat((encodedPath + "/..").constData(), &parentInfo) != 0) {
+        return false;
+    }
+    return parentInfo.st_dev != info.st_dev || parentInfo.st_ino == info.st_ino;
 }
@@ -44,9 +44,13 @@ public:
     /**
      * @brief isMountpoint
      * @param path
+     * @param mightBeSymLink False if the caller has resolved symlinks already; then an absolute,
+     * clean path is answered from the table alone while MountMonitor is event-driven
      * @return true if path (symlinks resolved) is a mountpoint, false otherwise
+     * @note Answered from the mount table cached by MountMonitor, so it is cheap enough to call
+     * for every item while sorting or drawing icons.
      */
-    static bool isMountpoint(const QString &path);
+    static bool isMountpoint(const QString &path, bool mightBeSymLink = true);
 };
 
 #endif // MOUNTPOINTS_H
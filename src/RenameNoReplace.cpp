@@ -0,0 +1,25 @@
+#include "RenameNoReplace.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#ifndef RENAME_NOREPLACE
+#define RENAME_NOREPLACE (1 << 0)
+#endif
+#endif
+
+int renameNoReplace(int fromDirFd, const char* from, int toDirFd, const char* to) {
+#ifdef SYS_renameat2
+    // Called through syscall() because older C libraries have no wrapper
+    return static_cast<int>(syscall(SYS_renameat2, fromDirFd, from, toDirFd, to, RENAME_NOREPLACE));
+#else
+    (void)fromDirFd;
+    (void)from;
+    (void)toDirFd;
+    (void)to;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
@@ -0,0 +1,20 @@
+#ifndef RENAMENOREPLACE_H
+#define RENAMENOREPLACE_H
+
+/**
+ * @file RenameNoReplace.h
+ * @brief Renames without replacing an existing target, atomically.
+ *
+ * Shared by the Trash and the file operations, which must not overwrite items that appear at
+ * the target between a check and the rename, including dangling symbolic links.
+ */
+
+/**
+ * @brief Renames from to to, relative to the given folder descriptors (or AT_FDCWD).
+ * @return 0 on success; otherwise -1 with errno set. EEXIST if the target exists; EINVAL or
+ * ENOSYS if the kernel or the filesystem cannot rename without replacing, in which case nothing
+ * has been renamed and the caller has to fall back to something else.
+ */
+int renameNoReplace(int fromDirFd, const char* from, int toDirFd, const char* to);
+
+#endif // RENAMENOREPLACE_H
@@ -0,0 +1,165 @@
+#include "StallWatchdog.h"
+#include "Trace.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QDebug>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <execinfo.h>
+
+namespace {
+
+// The GUI thread records its own stack when it receives this signal
+constexpr int CaptureSignal = SIGUSR2;
+constexpr int MaxFrames = 64;
+constexpr int CaptureTimeout = 200; // Milliseconds
+
+void* stackFrames[MaxFrames];
+std::atomic<int> stackFrameCount{0};
+std::atomic<bool> stackCaptured{false};
+
+void captureStack(int) {
+    int savedErrno = errno;
+    stackFrameCount.store(backtrace(stackFrames, MaxFrames), std::memory_order_relaxed);
+    stackCaptured.store(true, std::memory_order_release);
+    errno = savedErrno;
+}
+
+StallWatchdog* watchdog = nullptr;
+
+}
+
+const int StallWatchdog::s_bucketLimits[BucketCount - 1] = {100, 250, 500, 1000, 2000, 5000};
+
+void StallWatchdog::startFromEnvironment() {
+    if (watchdog || !qEnvironmentVariableIsSet("FILER_STALL_WATCHDOG")) {
+        return;
+    }
+    bool ok = false;
+    int threshold = qEnvironmentVariableIntValue("FILER_STALL_WATCHDOG", &ok);
+    if (!ok || threshold <= 0) {
+        threshold = DefaultThreshold;
+    }
+
+    // backtrace() loads its unwinder on first use, which must not happen in the signal handler
+    void* frame;
+    backtrace(&frame, 1);
+
+    struct sigaction action = {};
+    action.sa_handler = captureStack;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(CaptureSignal, &action, nullptr) != 0) {
+        qWarning() << "StallWatchdog: could not install the signal handler";
+        return;
+    }
+
+    watchdog = new StallWatchdog(threshold);
+    QObject::connect(qApp, &QCoreApplication::aboutToQuit, []() {
+        watchdog->stop();
+        qDebug().noquote() << "StallWatchdog: stalls by length\n" + watchdog->histogram();
+    });
+    qDebug() << "StallWatchdog: reporting stalls of the GUI thread longer than" << threshold << "ms";
+}
+
+StallWatchdog* StallWatchdog::instance() {
+    return watchdog;
+}
+
+StallWatchdog::StallWatchdog(int threshold)
+        : m_threshold(threshold), m_guiThread(pthread_self()), m_guiSpan(Trace::activeSpanSlot()) {
+    for (std::atomic<quint64>& stalls : m_stalls) {
+        stalls.store(0, std::memory_order_relaxed);
+    }
+    m_thread = std::thread(&StallWatchdog::watch, this);
+}
+
+void StallWatchdog::stop() {
+    m_running.store(false);
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void StallWatchdog::watch() {
+    const auto pollInterval = std::chrono::milliseconds(qBound(10, m_threshold / 4, 100));
+    quint64 sequence = 0;
+
+    while (m_running.load()) {
+        quint64 ping = ++sequence;
+        QElapsedTimer sent;
+        sent.start();
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [this, ping]() {
+            m_pingsAnswered.store(ping, std::memory_order_release);
+        }, Qt::QueuedConnection);
+
+        bool stalled = false;
+        while (m_running.load() && m_pingsAnswered.load(std::memory_order_acquire) < ping) {
+            std::this_thread::sleep_for(pollInterval);
+            if (!stalled && sent.elapsed() >= m_threshold) {
+                stalled = true;
+                reportStall(sent.elapsed());
+            }
+        }
+        if (stalled && m_pingsAnswered.load(std::memory_order_acquire) >= ping) {
+            qWarning() << "StallWatchdog: the GUI thread was stalled for" << sent.elapsed() << "ms";
+            record(sent.elapsed());
+        }
+
+        std::this_thread::sleep_for(pollInterval);
+    }
+}
+
+void StallWatchdog::reportStall(qint64 elapsed) {
+    const char* span = m_guiSpan->load(std::memory_order_relaxed);
+    qWarning() << "StallWatchdog: the GUI thread has not processed events for" << elapsed << "ms,"
+               << "active span:" << (span ? span : "none");
+    Trace::mark("gui-thread-stalled");
+
+    stackCaptured.store(false, std::memory_order_relaxed);
+    if (pthread_kill(m_guiThread, CaptureSignal) != 0) {
+        return;
+    }
+    QElapsedTimer waited;
+    waited.start();
+    while (!stackCaptured.load(std::memory_order_acquire) && waited.elapsed() < CaptureTimeout) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (!stackCaptured.load(std::memory_order_acquire)) {
+        qWarning() << "StallWatchdog: the GUI thread did not record its stack";
+        return;
+    }
+
+    int count = stackFrameCount.load(std::memory_order_relaxed);
+    char** symbols = backtrace_symbols(stackFrames, count);
+    if (!symbols) {
+        return;
+    }
+    // Frame 0 is the signal handler and frame 1 the signal trampoline
+    for (int i = 2; i < count; i++) {
+        qWarning().noquote() << "    #" + QString::number(i - 2) << symbols[i];
+    }
+    free(symbols);
+}
+
+void StallWatchdog::record(qint64 duration) {
+    int bucket = 0;
+    while (bucket < BucketCount - 1 && duration >= s_bucketLimits[bucket]) {
+        bucket++;
+    }
+    m_stalls[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+QString StallWatchdog::histogram() const {
+    QStringList lines;
+    for (int bucket = 0; bucket < BucketCount; bucket++) {
+        QString range = (bucket == BucketCount - 1)
+                        ? QString(">= %1 ms").arg(s_bucketLimits[bucket - 1])
+                        : QString("< %1 ms").arg(s_bucketLimits[bucket]);
+        lines << range + ": " + QString::number(m_stalls[bucket].load(std::memory_order_relaxed));
+    }
+    return lines.join("\n");
+}
@@ -0,0 +1,59 @@
+#ifndef STALLWATCHDOG_H
+#define STALLWATCHDOG_H
+
+#include <QString>
+#include <atomic>
+#include <pthread.h>
+#include <thread>
+
+/**
+ * @file StallWatchdog.h
+ * @class StallWatchdog
+ * @brief Detects when the GUI thread stops processing events and logs what it is stuck in.
+ *
+ * A thread of its own posts a ping to the event loop and waits for it to be answered. When the
+ * answer takes longer than the threshold, the watchdog logs the stack of the GUI thread and its
+ * active Trace::Span; once the event loop answers again, the length of the stall is added to a
+ * histogram. Opt-in with FILER_STALL_WATCHDOG=<threshold in milliseconds>.
+ */
+class StallWatchdog {
+public:
+    /**
+     * @brief Starts the watchdog if FILER_STALL_WATCHDOG is set; must be called on the GUI thread.
+     */
+    static void startFromEnvironment();
+
+    /**
+     * @brief Returns the watchdog, or nullptr if it is not running.
+     */
+    static StallWatchdog* instance();
+
+    /**
+     * @brief Returns the number of stalls and their lengths per histogram bucket, one bucket per line.
+     */
+    QString histogram() const;
+
+    int threshold() const { return m_threshold; }
+
+private:
+    explicit StallWatchdog(int threshold);
+
+    void watch();
+    void stop();
+    void reportStall(qint64 elapsed);
+    void record(qint64 duration);
+
+    static constexpr int DefaultThreshold = 250; /**< Milliseconds, used if the variable holds no number. */
+    static constexpr int BucketCount = 7;
+    static const int s_bucketLimits[BucketCount - 1]; /**< Upper limits of all but the last bucket in milliseconds. */
+
+    const int m_threshold;
+    pthread_t m_guiThread;
+    std::atomic<const char*>* m_guiSpan; /**< The active span of the GUI thread. */
+    std::thread m_thread;
+    std::atomic<bool> m_running{true};
+    std::atomic<quint64> m_pingsAnswered{0};
+    std::atomic<quint64> m_stalls[BucketCount];
+};
+
+#endif // STALLWATCHDOG_H
@@ -0,0 +1,146 @@
+#include "TaskRuntime.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QDebug>
+
+namespace {
+// Index of the worker running on the current thread, or -1 on other threads
+thread_local int t_workerIndex = -1;
+}
+
+TaskRuntime* TaskRuntime::instance() {
+    // Never destroyed; the workers must not be joined while tasks may still be walking a slow disk at exit
+    static TaskRuntime* runtime = new TaskRuntime();
+    return runtime;
+}
+
+TaskRuntime::TaskRuntime() {
+    for (std::atomic<int>& pending : m_pending) {
+        pending.store(0, std::memory_order_relaxed);
+    }
+
+    int count = qMax(2, QThread::idealThreadCount());
+    m_backgroundLimit = qMax(1, count / 2);
+    for (int i = 0; i < count; i++) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < count; i++) {
+        m_workers[i]->thread = std::thread(&TaskRuntime::workerLoop, this, i);
+    }
+    qDebug() << "TaskRuntime:" << count << "workers," << m_backgroundLimit << "for background tasks";
+}
+
+CancellationToken TaskRuntime::run(Lane lane, const std::function<void(const CancellationToken&)>& work) {
+    Task task;
+    task.work = work;
+    CancellationToken token = task.token;
+
+    if (t_workerIndex >= 0) {
+        Worker& worker = *m_workers[t_workerIndex];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queues[lane].push_back(std::move(task));
+    } else {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queues[lane].push_back(std::move(task));
+    }
+
+    {
+        // Taking the lock orders the increment before the check of a worker that is about to sleep
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending[lane].fetch_add(1, std::memory_order_relaxed);
+    }
+    m_wakeUp.notify_one();
+    return token;
+}
+
+void TaskRuntime::onGuiThread(const std::function<void()>& function) {
+    QMetaObject::invokeMethod(QCoreApplication::instance(), function, Qt::QueuedConnection);
+}
+
+bool TaskRuntime::hasRunnableTask() const {
+    return m_pending[Interactive].load(std::memory_order_relaxed) > 0
+           || m_pending[Prefetch].load(std::memory_order_relaxed) > 0
+           || (m_pending[Background].load(std::memory_order_relaxed) > 0
+               && m_backgroundRunning.load(std::memory_order_relaxed) < m_backgroundLimit);
+}
+
+bool TaskRuntime::takeTask(int index, Task& task, Lane& lane) {
+    for (int l = 0; l < LaneCount; l++) {
+        if (l == Background && m_backgroundRunning.load(std::memory_order_relaxed) >= m_backgroundLimit) {
+            break;
+        }
+        if (m_pending[l].load(std::memory_order_relaxed) <= 0) {
+            continue;
+        }
+
+        bool found = false;
+
+        // Own queue first, newest task first, since its data is most likely still in the cache
+        {
+            Worker& own = *m_workers[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.queues[l].empty()) {
+                task = std::move(own.queues[l].back());
+                own.queues[l].pop_back();
+                found = true;
+            }
+        }
+
+        // Then the tasks submitted from outside, in order
+        if (!found) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_queues[l].empty()) {
+                task = std::move(m_queues[l].front());
+                m_queues[l].pop_front();
+                found = true;
+            }
+        }
+
+        // Then steal the oldest task of another worker
+        for (size_t i = 1; !found && i < m_workers.size(); i++) {
+            Worker& victim = *m_workers[(index + i) % m_workers.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.queues[l].empty()) {
+                task = std::move(victim.queues[l].front());
+                victim.queues[l].pop_front();
+                found = true;
+            }
+        }
+
+        if (found) {
+            m_pending[l].fetch_sub(1, std::memory_order_relaxed);
+            if (l == Background) {
+                m_backgroundRunning.fetch_add(1, std::memory_order_relaxed);
+            }
+            lane = static_cast<Lane>(l);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskRuntime::workerLoop(int index) {
+    t_workerIndex = index;
+
+    while (true) {
+        Task task;
+        Lane lane;
+        if (!takeTask(index, task, lane)) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeUp.wait(lock, [this]() { return hasRunnableTask(); });
+            continue;
+        }
+
+        if (!task.token.isCanceled()) {
+            task.work(task.token);
+        }
+        if (lane == Background) {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_backgroundRunning.fetch_sub(1, std::memory_order_relaxed);
+            }
+            // A background task that was held back may run now
+            m_wakeUp.notify_one();
+        }
+    }
+}
@@ -0,0 +1,126 @@
+#ifndef TASKRUNTIME_H
+#define TASKRUNTIME_H
+
+#include <QObject>
+#include <QPointer>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @file TaskRuntime.h
+ * @class CancellationToken
+ * @brief Tells a task that its result is no longer needed.
+ *
+ * Copies share the same state. Tasks check isCanceled() at convenient points and return early;
+ * continuations of canceled tasks are not called.
+ */
+class CancellationToken {
+public:
+    CancellationToken() : m_canceled(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() const { m_canceled->store(true, std::memory_order_relaxed); }
+    bool isCanceled() const { return m_canceled->load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> m_canceled;
+};
+
+/**
+ * @class TaskRuntime
+ * @brief Runs work off the GUI thread in priority lanes and continues on the GUI thread.
+ *
+ * Workers take tasks from the most urgent lane that has any: Interactive for work whose result
+ * is about to be shown, Prefetch for work the user is likely to need soon, and Background for
+ * indexing and the like. Background tasks are held back while half of the workers are busy with
+ * them, so that interactive work always finds a free one. Tasks submitted from a worker go to the
+ * queue of that worker and idle workers steal from the other queues, so that a task that splits
+ * itself up keeps its pieces on one thread unless other threads have nothing to do.
+ */
+class TaskRuntime {
+public:
+    enum Lane { Interactive, Prefetch, Background };
+    static constexpr int LaneCount = 3;
+
+    static TaskRuntime* instance();
+
+    /**
+     * @brief Runs work on a worker thread.
+     * @return The token that cancels the task; the work is skipped if it is canceled before it starts.
+     */
+    CancellationToken run(Lane lane, const std::function<void(const CancellationToken&)>& work);
+
+    /**
+     * @brief Runs work on a worker thread and passes its result to then() on the GUI thread.
+     * @param context then() is not called if this object is destroyed in the meantime; must live on the
+     * GUI thread. May be nullptr.
+     * @note then() is not called if the task is canceled, even if the work has finished already.
+     */
+    template <typename Work, typename Then>
+    CancellationToken run(Lane lane, QObject* context, Work work, Then then) {
+        using Result = std::invoke_result_t<Work, const CancellationToken&>;
+        QPointer<QObject> guard(context);
+        bool hasContext = (context != nullptr);
+        return run(lane, [guard, hasContext, work, then](const CancellationToken& token) mutable {
+            if constexpr (std::is_void_v<Result>) {
+                work(token);
+                onGuiThread([guard, hasContext, token, then]() mutable {
+                    if (!token.isCanceled() && (!hasContext || guard)) {
+                        then();
+                    }
+                });
+            } else {
+                auto result = std::make_shared<Result>(work(token));
+                onGuiThread([guard, hasContext, token, then, result]() mutable {
+                    if (!token.isCanceled() && (!hasContext || guard)) {
+                        then(std::move(*result));
+                    }
+                });
+            }
+        });
+    }
+
+    /**
+     * @brief Calls a function on the GUI thread from the event loop.
+     */
+    static void onGuiThread(const std::function<void()>& function);
+
+    int workerCount() const { return static_cast<int>(m_workers.size()); }
+
+private:
+    struct Task {
+        std::function<void(const CancellationToken&)> work;
+        CancellationToken token;
+    };
+
+    /**
+     * @brief A worker thread and the tasks it submitted itself.
+     */
+    struct Worker {
+        std::thread thread;
+        std::mutex mutex;
+        std::deque<Task> queues[LaneCount];
+    };
+
+    TaskRuntime();
+
+    void workerLoop(int index);
+    bool takeTask(int index, Task& task, Lane& lane);
+    bool hasRunnableTask() const;
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::mutex m_mutex; /**< Guards the shared queues and the sleeping workers. */
+    std::condition_variable m_wakeUp;
+    std::deque<Task> m_queues[LaneCount]; /**< Tasks submitted from outside the workers. */
+    std::atomic<int> m_pending[LaneCount];
+    std::atomic<int> m_backgroundRunning{0};
+    int m_backgroundLimit;
+};
+
+#endif // TASKRUNTIME_H
@@ -0,0 +1,220 @@
+#include "Trace.h"
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QCoreApplication>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <chrono>
+#include <vector>
+#include <dlfcn.h>
+
+namespace {
+
+QMutex traceMutex;
+QElapsedTimer traceClock;
+QFile* traceFile = nullptr;
+
+thread_local std::atomic<const char*> activeSpan{nullptr};
+
+const char* activeSpanName() {
+    return activeSpan.load(std::memory_order_relaxed);
+}
+
+// If libfiler.so is preloaded to count system calls, it attributes them to the active span
+const bool syscallCounterConnected = []() {
+    using SetSpanSource = void (*)(const char* (*)());
+    auto setSpanSource = reinterpret_cast<SetSpanSource>(dlsym(RTLD_DEFAULT, "filer_syscalls_set_span_source"));
+    if (setSpanSource) {
+        setSpanSource(activeSpanName);
+    }
+    return setSpanSource != nullptr;
+}();
+
+const std::chrono::steady_clock::time_point processStart = std::chrono::steady_clock::now();
+
+// A span, or a mark if the duration is -1. The fields are atomic because writeChromeTrace()
+// may read an event while its thread overwrites it.
+struct TraceEvent {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<qint64> start{0};
+    std::atomic<qint64> duration{-1};
+    std::atomic<quint64> thread{0};
+};
+
+// The most recent events of one thread; only that thread writes to it, without locking
+struct TraceBuffer {
+    static constexpr quint64 Capacity = 8192;
+    // Slots next to the oldest event that the writing thread may be overwriting while they are read
+    static constexpr quint64 ReadMargin = 64;
+
+    TraceEvent events[Capacity];
+    std::atomic<quint64> head{0};
+    std::atomic<bool> inUse{true};
+};
+
+// The buffers are never freed; a thread that starts takes over the buffer of one that has exited
+QMutex buffersMutex;
+std::vector<TraceBuffer*> buffers;
+
+struct BufferOwner {
+    ~BufferOwner() {
+        if (buffer) {
+            buffer->inUse.store(false, std::memory_order_release);
+        }
+    }
+    TraceBuffer* buffer = nullptr;
+    quint64 thread = 0;
+};
+thread_local BufferOwner bufferOwner;
+
+void record(const char* name, qint64 start, qint64 duration) {
+    if (!bufferOwner.buffer) {
+        QMutexLocker locker(&buffersMutex);
+        for (TraceBuffer* buffer : buffers) {
+            bool unused = false;
+            if (buffer->inUse.compare_exchange_strong(unused, true)) {
+                bufferOwner.buffer = buffer;
+                break;
+            }
+        }
+        if (!bufferOwner.buffer) {
+            bufferOwner.buffer = new TraceBuffer;
+            buffers.push_back(bufferOwner.buffer);
+        }
+        bufferOwner.thread = reinterpret_cast<quintptr>(QThread::currentThreadId());
+    }
+
+    TraceBuffer* buffer = bufferOwner.buffer;
+    quint64 slot = buffer->head.load(std::memory_order_relaxed);
+    TraceEvent& event = buffer->events[slot % TraceBuffer::Capacity];
+    event.name.store(name, std::memory_order_relaxed);
+    event.start.store(start, std::memory_order_relaxed);
+    event.duration.store(duration, std::memory_order_relaxed);
+    event.thread.store(bufferOwner.thread, std::memory_order_relaxed);
+    buffer->head.store(slot + 1, std::memory_order_release);
+}
+
+QByteArray jsonString(const char* text) {
+    QByteArray escaped = "\"";
+    for (const char* c = text; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            escaped += '\\';
+            escaped += *c;
+        } else if (static_cast<unsigned char>(*c) < 0x20) {
+            escaped += ' ';
+        } else {
+            escaped += *c;
+        }
+    }
+    return escaped + '"';
+}
+
+}
+
+void Trace::begin(const QString& path) {
+    QMutexLocker locker(&traceMutex);
+    traceClock.start();
+
+    QString tracePath = qEnvironmentVariableIsSet("FILER_STARTUP_TRACE")
+                        ? QString::fromLocal8Bit(qgetenv("FILER_STARTUP_TRACE")) : path;
+    QDir().mkpath(QFileInfo(tracePath).absolutePath());
+    delete traceFile;
+    traceFile = new QFile(tracePath);
+    if (!traceFile->open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        delete traceFile;
+        traceFile = nullptr;
+    }
+}
+
+void Trace::mark(const char* event) {
+    record(event, now(), -1);
+
+    QMutexLocker locker(&traceMutex);
+    if (!traceFile) {
+        return;
+    }
+    QByteArray line = QByteArray::number(traceClock.nsecsElapsed() / 1e6, 'f', 3) + ' '
+                      + QByteArray::number(reinterpret_cast<quintptr>(QThread::currentThreadId()), 16) + ' '
+                      + event + '\n';
+    traceFile->write(line);
+    // Written right away so that the trace survives a crash or hang during startup
+    traceFile->flush();
+}
+
+QString Trace::defaultPath() {
+    // Does not depend on the application name, so that tracing can start before QApplication
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/Filer/startup-trace.log";
+}
+
+Trace::Span::Span(const char* name) : m_outer(activeSpan.load(std::memory_order_relaxed)), m_start(now()) {
+    activeSpan.store(name, std::memory_order_relaxed);
+}
+
+Trace::Span::~Span() {
+    const char* name = activeSpan.load(std::memory_order_relaxed);
+    record(name, m_start, now() - m_start);
+    activeSpan.store(m_outer, std::memory_order_relaxed);
+}
+
+std::atomic<const char*>* Trace::activeSpanSlot() {
+    return &activeSpan;
+}
+
+void Trace::complete(const char* name, qint64 start) {
+    record(name, start, now() - start);
+}
+
+qint64 Trace::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - processStart).count();
+}
+
+bool Trace::writeChromeTrace(const QString& path) {
+    QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    QByteArray processName = QCoreApplication::applicationName().toUtf8();
+    json += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + pid
+            + ",\"args\":{\"name\":" + jsonString(processName.constData()) + "}}";
+
+    int count = 0;
+    {
+        QMutexLocker locker(&buffersMutex);
+        for (const TraceBuffer* buffer : buffers) {
+            quint64 head = buffer->head.load(std::memory_order_acquire);
+            quint64 first = (head > TraceBuffer::Capacity) ? head - TraceBuffer::Capacity + TraceBuffer::ReadMargin : 0;
+            for (quint64 slot = first; slot < head; slot++) {
+                const TraceEvent& event = buffer->events[slot % TraceBuffer::Capacity];
+                const char* name = event.name.load(std::memory_order_relaxed);
+                if (!name) {
+                    continue;
+                }
+                qint64 duration = event.duration.load(std::memory_order_relaxed);
+                // Timestamps are in microseconds
+                json += ",\n{\"name\":" + jsonString(name) + ",\"cat\":\"filer\",\"pid\":" + pid
+                        + ",\"tid\":" + QByteArray::number(event.thread.load(std::memory_order_relaxed))
+                        + ",\"ts\":" + QByteArray::number(event.start.load(std::memory_order_relaxed) / 1e3, 'f', 3);
+                if (duration < 0) {
+                    json += ",\"ph\":\"i\",\"s\":\"t\"}";
+                } else {
+                    json += ",\"ph\":\"X\",\"dur\":" + QByteArray::number(duration / 1e3, 'f', 3) + "}";
+                }
+                count++;
+            }
+        }
+    }
+    json += "\n]}\n";
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit()) {
+        qWarning() << "Trace: could not write" << path << ":" << file.errorString();
+        return false;
+    }
+    qDebug() << "Trace: wrote" << count << "events to" << path;
+    return true;
+}
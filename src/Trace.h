@@ -0,0 +1,96 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QString>
+#include <atomic>
+
+/**
+ * @file Trace.h
+ * @class Trace
+ * @brief Writes timestamped events to a trace file, e.g., to measure the time to the first paint.
+ *
+ * Every line holds the milliseconds since begin(), the thread and the event, so that traces of
+ * different runs can be compared with standard tools. Events may be recorded from any thread.
+ *
+ * In addition, spans and marks are kept in a ring buffer per thread, holding the most recent
+ * events, which writeChromeTrace() writes in the Chrome Trace Event format for Perfetto or
+ * chrome://tracing.
+ */
+class Trace {
+public:
+    /**
+     * @brief Starts the clock and opens the trace file.
+     * @param path The trace file, which is overwritten; FILER_STARTUP_TRACE overrides it.
+     */
+    static void begin(const QString& path);
+
+    /**
+     * @brief Records an event; does nothing before begin().
+     */
+    static void mark(const char* event);
+
+    /**
+     * @brief Returns the default location of the startup trace.
+     */
+    static QString defaultPath();
+
+    /**
+     * @brief Names the work that the current thread is doing while it exists and records how long it took.
+     *
+     * Spans nest; the innermost one is the active one. The name must be a string literal or
+     * otherwise outlive the span. Use FILER_TRACE_SCOPE rather than a Span directly, so that the
+     * span is left out when tracing is disabled at compile time.
+     */
+    class Span {
+    public:
+        explicit Span(const char* name);
+        ~Span();
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        const char* m_outer;
+        const qint64 m_start;
+    };
+
+    /**
+     * @brief Returns the slot holding the name of the active span of the calling thread.
+     * @note Other threads may read the slot, e.g., to tell what the GUI thread is stuck in;
+     * it holds nullptr while no span is active.
+     */
+    static std::atomic<const char*>* activeSpanSlot();
+
+    /**
+     * @brief Records a span that started earlier, e.g., in another function, and ends now.
+     * @param start A timestamp from now().
+     */
+    static void complete(const char* name, qint64 start);
+
+    /**
+     * @brief Returns the nanoseconds since the process started, the clock of all recorded events.
+     */
+    static qint64 now();
+
+    /**
+     * @brief Writes the events in the ring buffers of all threads as Chrome Trace Event JSON.
+     * @return False if the file could not be written.
+     */
+    static bool writeChromeTrace(const QString& path);
+};
+
+#define FILER_TRACE_CONCAT_(a, b) a##b
+#define FILER_TRACE_CONCAT(a, b) FILER_TRACE_CONCAT_(a, b)
+
+/**
+ * @brief Records the rest of the enclosing scope as a span; nothing unless built with FILER_ENABLE_TRACING.
+ */
+#ifdef FILER_ENABLE_TRACING
+#define FILER_TRACE_SCOPE(name) Trace::Span FILER_TRACE_CONCAT(filerTraceSpan, __LINE__)(name)
+#define FILER_TRACE_COMPLETE(name, start) Trace::complete(name, start)
+#else
+#define FILER_TRACE_SCOPE(name) do {} while (false)
+#define FILER_TRACE_COMPLETE(name, start) do {} while (false)
+#endif
+
+#endif // TRACE_H
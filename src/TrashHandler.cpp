@@ -30,15 +30,27 @@
 #include <QTranslator>
 #include <QStorageInfo>
 #include <QDebug>
-#include <QProcess>
 #include <QMessageBox>
 #include "SoundPlayer.h"
 #include <QTimer>
 #include "FileManagerMainWindow.h"
 #include <QThread>
 #include "AppGlobals.h"
-#include <QFileSystemWatcher>
+#include "TrashIndex.h"
+#include "CommandRunner.h"
+#include "Trace.h"
+#include "FileOperationManager.h"
 #include "Mountpoints.h"
+#include "RenameNoReplace.h"
+#include <QUrl>
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 QString TrashHandler::m_trashPath = QDir::homePath() + "/.local/share/Trash/files";
 
@@ -46,27 +58,37 @@ TrashHandler::TrashHandler(QWidget *parent) : QObject(parent) {
     m_parent = parent;
     m_dialogShown = false;
 
-    // Tell the application to reload the desktop whenever
-    // the filesystem at TrashHandler::getTrashPath() changes
-    QFileSystemWatcher *fileSystemWatcher = new QFileSystemWatcher(this);
-    fileSystemWatcher->addPath(TrashHandler::getTrashPath());
-    connect(fileSystemWatcher, &QFileSystemWatcher::directoryChanged, this, [=]() {
+    // Tell the application to reload the desktop whenever the Trash
+    // becomes empty or stops being empty, so that its icon changes
+    m_wasEmpty = TrashIndex::instance()->isEmpty();
+    connect(TrashIndex::instance(), &TrashIndex::changed, this, [=]() {
+        if (TrashIndex::instance()->isEmpty() == m_wasEmpty) {
+            return;
+        }
+        m_wasEmpty = !m_wasEmpty;
         qDebug() << "TrashHandler::trashChanged";
-        // Reload the desktop
-        QProcess p;
-        p.start("touch", QStringList() << QDir::homePath() + QDir::separator() + "Desktop");
-        p.waitForFinished(-1);
+        // Reload the desktop by touching it
+        QString desktopPath = QDir::homePath() + QDir::separator() + "Desktop";
+        if (utimensat(AT_FDCWD, QFile::encodeName(desktopPath).constData(), nullptr, 0) != 0) {
+            qWarning() << "Could not touch" << desktopPath << ":" << strerror(errno);
+        }
     });
 }
 
 void TrashHandler::moveToTrash(const QStringList& paths) {
 
     qDebug() << "moveToTrash" << paths;
+    FILER_TRACE_SCOPE("move-to-trash");
 
     // This is used to know which sound to play at the end
-    bool unmounted = false;
     bool filesMoved = false;
 
+    // Mount points to unmount once all items are handled
+    QStringList pathsToUnmount;
+
+    // Items on other mount points that the user chose to delete permanently
+    QStringList pathsToDelete;
+
     foreach (const QString &path, paths) {
 
         QFileInfo fileInfo(path);
@@ -76,7 +98,7 @@ void TrashHandler::moveToTrash(const QStringList& paths) {
             absoluteFilePathWithSymlinksResolved = fileInfo.symLinkTarget();
         }
 
-        bool isMountpoint = Mountpoints::isMountpoint(absoluteFilePathWithSymlinksResolved);
+        bool isMountpoint = Mountpoints::isMountpoint(absoluteFilePathWithSymlinksResolved, false);
 
         if (isMountpoint) {
             qDebug() << "Path" << absoluteFilePathWithSymlinksResolved << "is a mount point";
@@ -105,26 +127,7 @@ void TrashHandler::moveToTrash(const QStringList& paths) {
                 continue;
             }
 
-            // Unmount the mount point
-            // TODO: Might be necessary to call with sudo -A -E
-            QProcess umount;
-            // If eject-and-clean exists, use it; otherwise use umount
-            // eject-and-clean is a wrapper around umount that also cleans up the mount point
-            if (QFile::exists("/usr/local/bin/eject-and-clean")) {
-                umount.start("eject-and-clean", QStringList() << absoluteFilePathWithSymlinksResolved);
-                qDebug() << "eject-and-clean" << absoluteFilePathWithSymlinksResolved;
-            } else {
-                umount.start("umount", QStringList() << absoluteFilePathWithSymlinksResolved);
-                qDebug() << "umount" << absoluteFilePathWithSymlinksResolved;
-            }
-            qDebug() << "Waiting for umount to finish";
-            umount.waitForFinished(10000); // Wait for 10 seconds; it can really take that long...
-            if (umount.exitCode() == 0) {
-                unmounted = true;
-            } else {
-                QMessageBox::critical(nullptr, tr("Error"),
-                                      tr("Failed to unmount the mount point: ") + absoluteFilePathWithSymlinksResolved);
-            }
+            pathsToUnmount << absoluteFilePathWithSymlinksResolved;
             continue;
         }
 
@@ -134,8 +137,8 @@ void TrashHandler::moveToTrash(const QStringList& paths) {
         }
 
         // If path is /media or /media/$USER, we refuse to move it to the trash
-        if (absoluteFilePathWithSymlinksResolved == AppGlobals::mediaPath) {
-            qDebug() << "Path" << absoluteFilePathWithSymlinksResolved << "is in" << AppGlobals::mediaPath << ", skipping";
+        if (absoluteFilePathWithSymlinksResolved == AppGlobals::mediaPath()) {
+            qDebug() << "Path" << absoluteFilePathWithSymlinksResolved << "is in" << AppGlobals::mediaPath() << ", skipping";
             continue;
         }
 
@@ -145,20 +148,6 @@ void TrashHandler::moveToTrash(const QStringList& paths) {
             continue;
         }
 
-        QDir trashDir(m_trashPath);
-
-        // Create the "Trash" directory if it doesn't exist
-        if (!trashDir.exists()) {
-            if (!trashDir.mkpath(".")) {
-                QMessageBox::critical(nullptr, tr("Error"),
-                                      tr("Failed to create the Trash directory."));
-                continue;
-            }
-        }
-
-        QString fileName = fileInfo.fileName();
-        QString newFilePath = m_trashPath + QDir::separator() + fileName;
-
         // Check if the file/directory is a critical system file/directory
         QStringList criticalSystemPaths = {"/",
                                            "/Applications",
@@ -212,13 +201,6 @@ void TrashHandler::moveToTrash(const QStringList& paths) {
             continue;
         }
 
-        // Check if the file/directory with the same name already exists in the Trash
-        int i = 1;
-        while (QFile::exists(newFilePath)) {
-            QString newFileName = fileInfo.baseName() + QString("_%1").arg(i++) + "." + fileInfo.suffix();
-            newFilePath = m_trashPath + QDir::separator() + newFileName;
-        }
-
         if (! m_dialogShown) {
             // Show a confirmation dialog (once)
             m_dialogShown = true;
@@ -239,99 +221,67 @@ void TrashHandler::moveToTrash(const QStringList& paths) {
             }
         }
 
-        // Check if the file/directory is on the same mount point as the Trash directory
-        QFileInfo trashDirInfo(m_trashPath);
-        if (trashDirInfo.isDir()) {
-            QStorageInfo trashDirStorageInfo(m_trashPath);
-            QStorageInfo fileStorageInfo(path);
-            qDebug() << "Trash dir mount point: " << trashDirStorageInfo.rootPath();
-            qDebug() << "File root mount point: " << fileStorageInfo.rootPath();
-            if (trashDirStorageInfo.rootPath() == fileStorageInfo.rootPath()) {
-                // The file/directory is on the same mount point as the Trash directory
-                // Move the file/directory to the Trash directory
-                qDebug() << "The file/directory is on the same mount point as the Trash directory";
-                if (!QFile::rename(path, newFilePath)) {
-                    // Failed to move the file/directory to Trash
-                    QMessageBox::critical(nullptr, tr("Error"),
-                                          tr("Failed to move to Trash. Please check file permissions."));
-                    continue;
-                } else {
-                    filesMoved = true;
-                    continue;
-                }
-            } else {
-                // The file/directory is on a different mount point than the Trash directory, hence
-                // inform the user and as whether to delete the file/directory permanently right away
-                qDebug() << "The file/directory is on a different mount point than the Trash directory";
-                int result = QMessageBox::warning(m_parent, tr("Confirm"),
-                                                  tr("The selected items are on a different mount point than the Trash directory. "
-                                                     "Do you want to delete the selected items permanently right away?"),
-                                                  QMessageBox::Yes | QMessageBox::No,
-                                                  QMessageBox::No);
-                if (result == QMessageBox::Yes) {
-                    // Delete the symlink/file/directory permanently
-                    if (fileInfo.isSymLink()) {
-                        // CAUTION: Handle symlinks before directories, otherwise not only the symlink but also the
-                        // contents of the directory it points to will be deleted
-                        if (!QFile::remove(path)) {
-                            // Use sudo -A -E rm -f <path> to delete the symlink
-                            QProcess p;
-                            p.start("sudo", QStringList() << "-A" << "-E" << "rm" << "-f" << path);
-                            p.waitForFinished(-1);
-                            if (p.exitCode() != 0) {
-                                QMessageBox::critical(nullptr, tr("Error"),
-                                                      tr("Failed to delete the symlink. Please check its permissions."));
-                            }
-                            continue;
-                        }
-                    } else if (fileInfo.isDir()) {
-                        if (!QDir(path).removeRecursively()) {
-                            // Use sudo -A -E rm -rf <path> to delete the directory
-                            QProcess p;
-                            p.start("sudo", QStringList() << "-A" << "-E" << "rm" << "-rf" << path);
-                            p.waitForFinished(-1);
-                            if (p.exitCode() != 0) {
-                                QMessageBox::critical(nullptr, tr("Error"),
-                                                      tr("Failed to delete the directory. Please check its permissions."));
-                            }
-                            continue;
-                        }
-                    } else {
-                        if (!QFile::remove(path)) {
-                            // Use sudo -A -E rm -f <path> to delete the file
-                            QProcess p;
-                            p.start("sudo", QStringList() << "-A" << "-E" << "rm" << "-f" << path);
-                            p.waitForFinished(-1);
-                            if (p.exitCode() != 0) {
-                                QMessageBox::critical(nullptr, tr("Error"),
-                                                      tr("Failed to delete the file. Please check its permissions."));
-                            }
-                            continue;
-                        }
-                    }
-                } else {
-                    // Do not delete the file/directory permanently
-                    continue;
-                }
+        // Move the file/directory to the Trash directory on its own volume, which is a rename
+        QString topDirectory;
+        QString trashDirectory = trashDirectoryFor(path, &topDirectory);
+        if (!trashDirectory.isEmpty()) {
+            qDebug() << "Trash directory for" << path << "is" << trashDirectory;
+            if (!moveItemToTrash(path, trashDirectory, topDirectory)) {
+                // Failed to move the file/directory to Trash
+                QMessageBox::critical(nullptr, tr("Error"),
+                                      tr("Failed to move to Trash. Please check file permissions."));
+                continue;
             }
+            filesMoved = true;
+            continue;
+        }
+
+        // There is no Trash directory that the user may use on the volume of the file/directory
+        // (e.g., it is read-only), hence inform the user and ask whether to delete the file/directory
+        // permanently right away
+        qDebug() << "There is no Trash directory for" << path;
+        int result = QMessageBox::warning(m_parent, tr("Confirm"),
+                                          tr("The selected items cannot be moved to the Trash on their volume. "
+                                             "Do you want to delete the selected items permanently right away?"),
+                                          QMessageBox::Yes | QMessageBox::No,
+                                          QMessageBox::No);
+        if (result == QMessageBox::Yes) {
+            // Delete the symlink/file/directory permanently once all items are handled
+            pathsToDelete << path;
         }
     }
 
-    if (unmounted && filesMoved) {
-        // Both mount points were unmounted and files were moved to trash
-        SoundPlayer::playSound("ffft.wav");
-    } else if (unmounted) {
-        // Only mount points were unmounted
-        SoundPlayer::playSound("pschiuu.wav");
-    } else if (filesMoved) {
-        // Only files were moved to trash
+    if (!pathsToDelete.isEmpty()) {
+        // The file operation service never follows symlinks, so the contents of directories
+        // that they point to are left alone
+        FileOperationManager::deleteWithProgress(pathsToDelete);
+    }
+
+    for (const QString& mountPoint : qAsConst(pathsToUnmount)) {
+        // Unmount in the background; it can really take 10 seconds
+        // TODO: Might be necessary to call with sudo -A -E
+        // If eject-and-clean exists, use it; otherwise use umount
+        // eject-and-clean is a wrapper around umount that also cleans up the mount point
+        QString program = QFile::exists("/usr/local/bin/eject-and-clean") ? "eject-and-clean" : "umount";
+        CommandRunner::run(program, QStringList() << mountPoint, UnmountTimeout, qApp,
+                           [mountPoint, filesMoved](const CommandResult& result) {
+            if (!result.succeeded()) {
+                QMessageBox::critical(nullptr, tr("Error"),
+                                      tr("Failed to unmount the mount point: ") + mountPoint);
+            } else if (!filesMoved) {
+                // Only mount points were unmounted
+                SoundPlayer::playSound("pschiuu.wav");
+            }
+        });
+    }
+
+    if (filesMoved) {
+        // Files were moved to trash, possibly along with mount points being unmounted
         SoundPlayer::playSound("ffft.wav");
     }
 }
 
 bool TrashHandler::emptyTrash() {
-    QDir trashDir(m_trashPath);
-
     // Ask user for confirmation
     int result = QMessageBox::warning(nullptr, tr("Trash"),
                                       tr("Do you want to permanently delete all items in the Trash?"),
@@ -341,49 +291,28 @@ bool TrashHandler::emptyTrash() {
         return false;
     }
 
-    // Remove all files and directories from the Trash directory
-    QStringList trashItems = trashDir.entryList(QDir::NoDotAndDotDot | QDir::AllEntries);
-    for (const QString& trashItem : trashItems) {
-        QString trashPath = m_trashPath + QDir::separator() + trashItem;
-        if (QFileInfo(trashPath).isSymLink()) {
-            // Remove the symlink
-            if (!QFile::remove(trashPath)) {
-                QMessageBox::critical(nullptr, tr("Error"),
-                                      tr("Failed to remove symlink from Trash: %1").arg(trashItem));
-                return false;
-            }
-        } else if (QFileInfo(trashPath).isDir()) {
-            // Recursively remove subdirectories and files
-            QDir subDir(trashPath);
-            if (!subDir.removeRecursively()) {
-                QMessageBox::critical(nullptr, tr("Error"),
-                                      tr("Failed to remove directory from Trash: %1").arg(trashItem));
-                return false;
-            }
-        } else {
-            // Remove the file
-            if (!QFile::remove(trashPath)) {
-                QMessageBox::critical(nullptr, tr("Error"),
-                                      tr("Failed to remove file from Trash: %1").arg(trashItem));
-                return false;
+    // Remove all files and directories from the Trash directories in the file operation service,
+    // which shows the progress and can be canceled; the Trash icon on the Desktop is refreshed
+    // once the trash index has seen the items disappear
+    QStringList trashItems;
+    const QStringList trashDirectories = TrashHandler::trashDirectories();
+    for (const QString& trashDirectory : trashDirectories) {
+        for (const QString& subdirectory : {QStringLiteral("/files"), QStringLiteral("/info")}) {
+            QDir dir(trashDirectory + subdirectory);
+            const QStringList names = dir.entryList(QDir::NoDotAndDotDot | QDir::AllEntries | QDir::Hidden | QDir::System);
+            for (const QString& name : names) {
+                trashItems << dir.absoluteFilePath(name);
             }
         }
     }
-
-    qDebug() << "TrashHandler::emptyTrash() - Trash is now empty";
+    if (trashItems.isEmpty()) {
+        return true;
+    }
+    FileOperationManager::deleteWithProgress(trashItems);
 
     SoundPlayer::playSound("rustle.wav");
 
-    qDebug() << "TrashHandler::emptyTrash() - Updating Trash icon";
-
-    // Use QProcess to run the following command: "touch ~/Desktop"
-    // this will cause the Trash icon on the Desktop to be refreshed, so that
-    // it will show the empty Trash icon.
-    QProcess p;
-    p.start("touch", QStringList() << QDir::homePath() + QDir::separator() + "Desktop");
-    p.waitForFinished(-1);
-
-    qDebug() << "TrashHandler::emptyTrash() - Done";
+    qDebug() << "TrashHandler::emptyTrash() - Submitted" << trashItems.size() << "items";
 
     return true;
 }
@@ -393,6 +322,196 @@ QString TrashHandler::getTrashPath() {
 }
 
 bool TrashHandler::isEmpty() {
-    QDir trashDir(m_trashPath);
-    return trashDir.isEmpty();
+    return TrashIndex::instance()->isEmpty();
+}
+
+QString TrashHandler::homeTrashDirectory() {
+    return QFileInfo(m_trashPath).absolutePath();
+}
+
+QStringList TrashHandler::trashDirectories() {
+    QStringList trashDirectories;
+    trashDirectories << homeTrashDirectory();
+
+    QString uid = QString::number(getuid());
+    const QList<QStorageInfo> volumes = QStorageInfo::mountedVolumes();
+    for (const QStorageInfo& volume : volumes) {
+        if (!volume.isValid() || !volume.isReady()) {
+            continue;
+        }
+        QString topDirectory = volume.rootPath() == "/" ? QString() : volume.rootPath();
+        for (const QString& candidate : {topDirectory + "/.Trash/" + uid, topDirectory + "/.Trash-" + uid}) {
+            if (QFileInfo(candidate + "/files").isDir() && !trashDirectories.contains(candidate)) {
+                trashDirectories << candidate;
+            }
+        }
+    }
+    return trashDirectories;
+}
+
+// Finds the Trash directory for an item according to the freedesktop.org Trash specification:
+// the home Trash for items on the same device as the home directory, otherwise $topdir/.Trash/$uid
+// if the administrator has set up $topdir/.Trash, otherwise $topdir/.Trash-$uid
+QString TrashHandler::trashDirectoryFor(const QString& path, QString* topDirectory) {
+    QByteArray parent = QFile::encodeName(QFileInfo(path).absolutePath());
+    struct stat itemStat;
+    if (stat(parent.constData(), &itemStat) != 0) {
+        return QString();
+    }
+
+    QString homeTrash = homeTrashDirectory();
+    bool homeTrashUsable = createHomeTrashDirectory(homeTrash);
+    int homeTrashError = homeTrashUsable ? 0 : errno;
+    struct stat homeStat;
+    QString homeTrashParent = QFileInfo(homeTrash).absolutePath();
+    if (stat(QFile::encodeName(homeTrashParent).constData(), &homeStat) == 0 && homeStat.st_dev == itemStat.st_dev) {
+        topDirectory->clear();
+        if (!homeTrashUsable) {
+            qWarning() << "TrashHandler: Cannot set up the home Trash directory" << homeTrash << ":" << strerror(homeTrashError);
+        }
+        // Even if unusable, the item belongs into the home Trash; moving it then fails with an error
+        return homeTrash;
+    }
+
+    *topDirectory = QStorageInfo(QFileInfo(path).absolutePath()).rootPath();
+    if (topDirectory->isEmpty()) {
+        return QString();
+    }
+    QString root = *topDirectory == "/" ? QString() : *topDirectory;
+    uid_t uid = getuid();
+
+    // The shared .Trash directory must be a real directory with the sticky bit set
+    struct stat sharedStat;
+    QString shared = root + "/.Trash";
+    if (lstat(QFile::encodeName(shared).constData(), &sharedStat) == 0
+            && S_ISDIR(sharedStat.st_mode) && (sharedStat.st_mode & S_ISVTX)) {
+        QString candidate = shared + "/" + QString::number(uid);
+        if (isUsableTrashDirectory(candidate, uid)) {
+            return candidate;
+        }
+    }
+
+    QString candidate = root + "/.Trash-" + QString::number(uid);
+    if (isUsableTrashDirectory(candidate, uid)) {
+        return candidate;
+    }
+    return QString();
+}
+
+// The home Trash belongs to the user, so unlike the ones on other volumes it may be a symlink
+bool TrashHandler::createHomeTrashDirectory(const QString& path) {
+    if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+        return false;
+    }
+    QByteArray encoded = QFile::encodeName(path);
+    if (mkdir(encoded.constData(), 0700) != 0 && errno != EEXIST) {
+        return false;
+    }
+    for (const char* subdirectory : {"/files", "/info"}) {
+        if (mkdir((encoded + subdirectory).constData(), 0700) != 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+    struct stat info;
+    return stat((encoded + "/info").constData(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+bool TrashHandler::isUsableTrashDirectory(const QString& path, uid_t uid) {
+    QByteArray encoded = QFile::encodeName(path);
+    if (mkdir(encoded.constData(), 0700) != 0 && errno != EEXIST) {
+        return false;
+    }
+    // Never follow a symlink that someone else may have planted
+    struct stat info;
+    if (lstat(encoded.constData(), &info) != 0 || !S_ISDIR(info.st_mode) || info.st_uid != uid) {
+        return false;
+    }
+    for (const char* subdirectory : {"/files", "/info"}) {
+        if (mkdir((encoded + subdirectory).constData(), 0700) != 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Renames without replacing an existing target; the name is reserved through the .trashinfo file
+// already, so the check only guards against items that were put into files/ without one
+static int renameIntoTrash(const char* from, int toDirFd, const char* to) {
+    int result = renameNoReplace(AT_FDCWD, from, toDirFd, to);
+    if (result == 0 || (errno != EINVAL && errno != ENOSYS)) {
+        return result;
+    }
+    // The filesystem does not support RENAME_NOREPLACE
+    struct stat existing;
+    if (fstatat(toDirFd, to, &existing, AT_SYMLINK_NOFOLLOW) == 0) {
+        errno = EEXIST;
+        return -1;
+    }
+    return renameat(AT_FDCWD, from, toDirFd, to);
+}
+
+bool TrashHandler::moveItemToTrash(const QString& path, const QString& trashDirectory, const QString& topDirectory) {
+    QFileInfo fileInfo(path);
+    QString originalPath = fileInfo.absoluteFilePath();
+    QString recordedPath = topDirectory.isEmpty() ? originalPath : QDir(topDirectory).relativeFilePath(originalPath);
+    QByteArray trashInfo = "[Trash Info]\nPath=" + QUrl::toPercentEncoding(recordedPath, "/")
+                         + "\nDeletionDate=" + QDateTime::currentDateTime().toString("yyyy-MM-ddThh:mm:ss").toUtf8() + "\n";
+
+    int filesFd = ::open(QFile::encodeName(trashDirectory + "/files").constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    int infoFd = ::open(QFile::encodeName(trashDirectory + "/info").constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (filesFd < 0 || infoFd < 0) {
+        qWarning() << "TrashHandler: Cannot open" << trashDirectory << ":" << strerror(errno);
+    }
+    QByteArray source = QFile::encodeName(path);
+    bool moved = false;
+
+    // Name collisions are resolved with a random suffix instead of probing for a free name
+    QString name = fileInfo.fileName();
+    for (int attempt = 0; attempt < 16 && filesFd >= 0 && infoFd >= 0; attempt++) {
+        if (attempt > 0) {
+            QString suffix = QString::number(QRandomGenerator::global()->generate(), 16);
+            name = fileInfo.completeBaseName() + "_" + suffix;
+            if (!fileInfo.suffix().isEmpty() && !fileInfo.completeBaseName().isEmpty()) {
+                name += "." + fileInfo.suffix();
+            }
+        }
+        QByteArray encodedName = QFile::encodeName(name);
+        QByteArray infoName = encodedName + ".trashinfo";
+
+        // Reserve the name by creating the .trashinfo file exclusively, as the specification asks for
+        int fd = openat(infoFd, infoName.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if (fd < 0) {
+            if (errno == EEXIST) {
+                continue;
+            }
+            qDebug() << "Cannot create" << infoName << ":" << strerror(errno);
+            break;
+        }
+        bool written = write(fd, trashInfo.constData(), trashInfo.size()) == trashInfo.size();
+        ::close(fd);
+        if (!written) {
+            unlinkat(infoFd, infoName.constData(), 0);
+            break;
+        }
+
+        if (renameIntoTrash(source.constData(), filesFd, encodedName.constData()) == 0) {
+            TrashIndex::instance()->addItem(trashDirectory + "/files/" + name);
+            moved = true;
+            break;
+        }
+        int error = errno;
+        unlinkat(infoFd, infoName.constData(), 0);
+        if (error != EEXIST) {
+            qDebug() << "Cannot move" << path << "to" << trashDirectory << ":" << strerror(error);
+            break;
+        }
+    }
+
+    if (filesFd >= 0) {
+        ::close(filesFd);
+    }
+    if (infoFd >= 0) {
+        ::close(infoFd);
+    }
+    return moved;
 }
\ No newline at end of file
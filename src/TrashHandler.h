@@ -34,19 +34,14 @@
 #include <QTextStream>
 #include <QDir>
 #include <QMessageBox>
+#include <sys/types.h>
 
-// TODO: Support Trash on non-root volumes. Verify the following logic with a Mac and implement it:
-// When you put a file in the Trash and that file is located on a removable drive
-// (such as an external hard drive, USB flash drive, or network drive), the file is moved
-// to a hidden directory on that removable drive.
-// Within this ".Trashes" directory, there are subdirectories named after the user's UID
-// (user identifier). The actual numeric UID of the user on the system is used as the name
-// of these subdirectories to ensure separation of trashed files between different users.
-// So, the path to the ".Trashes" directory on a removable drive would look something like this:
-// "/Volumes/YourRemovableDrive/.Trashes"
-// Inside the ".Trashes" directory, you would find subdirectories named after user UIDs, like:
-// "/Volumes/YourRemovableDrive/.Trashes/501"
-// And within each of these UID-named subdirectories, trashed files are stored.
+// Trash on non-root volumes follows the freedesktop.org Trash specification: items on the
+// device of the home directory go to ~/.local/share/Trash, items on other volumes go to
+// $topdir/.Trash/$uid (if the administrator has created $topdir/.Trash with the sticky bit)
+// or to $topdir/.Trash-$uid, so that moving an item to the Trash is always a rename.
+// Each trash directory holds the trashed items in "files" and a .trashinfo file per item,
+// recording the original path and the deletion date, in "info".
 
 /**
  * @brief The TrashHandler class provides functionality to manage a "Trash" (virtual trash) for files and directories.
@@ -69,7 +64,8 @@ public:
 
     /**
      * @brief Empties the "Trash" by deleting all files and directories in the virtual trash.
-     * @return True if the trash was emptied successfully, false otherwise.
+     * @note The deletion runs in the 'fileoperation' service; this returns as soon as it is submitted.
+     * @return True if the user confirmed emptying the trash, false otherwise.
      */
     static bool emptyTrash();
 
@@ -81,14 +77,30 @@ public:
 
     /**
      * @brief Checks if the "Trash" is empty.
+     * @note Answered from the TrashIndex without accessing the file system.
      * @return True if the trash is empty, false otherwise.
      */
     static bool isEmpty();
 
+    /**
+     * @brief Returns the trash directories of the user on all mounted volumes, the home trash first.
+     * @note Each of them holds the "files" and "info" directories of the freedesktop.org Trash specification.
+     */
+    static QStringList trashDirectories();
+
 private:
+    static QString homeTrashDirectory();
+    static QString trashDirectoryFor(const QString& path, QString* topDirectory);
+    static bool createHomeTrashDirectory(const QString& path);
+    static bool isUsableTrashDirectory(const QString& path, uid_t uid);
+    static bool moveItemToTrash(const QString& path, const QString& trashDirectory, const QString& topDirectory);
+
+    static constexpr int UnmountTimeout = 10000; /**< Milliseconds after which umount is given up on. */
+
     static QString m_trashPath; /**< The path to the trash directory. */
     QWidget *m_parent; /**< The parent QWidget used for displaying message boxes. */
     bool m_dialogShown = false; /**< Flag to track if the empty trash confirmation dialog has been shown. */
+    bool m_wasEmpty = true; /**< Whether the trash was empty when the Desktop was last reloaded. */
 };
 
 #endif // TRASHHANDLER_H
@@ -0,0 +1,252 @@
+#include "TrashIndex.h"
+#include "TrashHandler.h"
+#include "FileTreeWalker.h"
+#include "MountMonitor.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QCoreApplication>
+#include <QThread>
+#include <QDebug>
+
+static TrashIndex* indexInstance = nullptr;
+
+// Emptying or filling the Trash causes an event per item; they are handled together after this long
+static const int ScanDelay = 200; // Milliseconds
+
+// The "files" directory that holds an item of the Trash
+static QString filesPathOf(const QString& path) {
+    return path.left(path.lastIndexOf('/'));
+}
+
+/**
+ * @brief Adds up the sizes of the files in a tree.
+ */
+class SizeVisitor : public FileTreeVisitor {
+public:
+    explicit SizeVisitor(const CancellationToken& token) : m_token(token) {}
+
+    Action enter(const FileTreeEntry& entry) override {
+        if (m_token.isCanceled()) {
+            return Stop;
+        }
+        if (entry.type == FileTreeEntry::File && entry.hasStat) {
+            size += entry.stat.st_size;
+        }
+        return Continue;
+    }
+
+    Action failed(const QByteArray& path, int error) override {
+        // Count what is readable
+        Q_UNUSED(path);
+        Q_UNUSED(error);
+        return Continue;
+    }
+
+    qint64 size = 0;
+
+private:
+    CancellationToken m_token;
+};
+
+TrashIndex::TrashIndex(QObject* parent) : QObject(parent) {
+    m_scanTimer.setSingleShot(true);
+    m_scanTimer.setInterval(ScanDelay);
+    connect(&m_scanTimer, &QTimer::timeout, this, &TrashIndex::scanScheduled);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &TrashIndex::onDirectoryChanged);
+    connect(MountMonitor::instance(), &MountMonitor::changed, this, &TrashIndex::refreshTrashDirectories);
+    refreshTrashDirectories();
+}
+
+void TrashIndex::create() {
+    Q_ASSERT(QThread::currentThread() == qApp->thread());
+    if (!indexInstance) {
+        MountMonitor::create();
+        indexInstance = new TrashIndex(qApp);
+    }
+}
+
+TrashIndex* TrashIndex::instance() {
+    Q_ASSERT_X(indexInstance, "TrashIndex::instance", "TrashIndex::create() was not called");
+    return indexInstance;
+}
+
+void TrashIndex::refreshTrashDirectories() {
+    const QStringList trashDirectories = TrashHandler::trashDirectories();
+    QSet<QString> filesPaths;
+    for (const QString& trashDirectory : trashDirectories) {
+        filesPaths.insert(trashDirectory + "/files");
+    }
+
+    // Forget the items on volumes that are gone
+    const QSet<QString> previousFilesPaths = m_filesPaths;
+    for (const QString& filesPath : previousFilesPaths) {
+        if (!filesPaths.contains(filesPath)) {
+            m_watcher.removePath(filesPath);
+            m_filesPaths.remove(filesPath);
+            m_scheduledScans.remove(filesPath);
+            auto task = m_scanTasks.find(filesPath);
+            if (task != m_scanTasks.end()) {
+                task->cancel();
+                m_scanTasks.erase(task);
+            }
+            applyListing(filesPath, QStringList());
+        }
+    }
+    for (const QString& trashDirectory : trashDirectories) {
+        addTrashDirectory(trashDirectory);
+    }
+}
+
+void TrashIndex::addTrashDirectory(const QString& trashDirectory) {
+    QString filesPath = trashDirectory + "/files";
+    // The home trash directory is only created when the first item is moved to the Trash
+    if (m_watcher.directories().contains(filesPath)) {
+        return;
+    }
+    m_filesPaths.insert(filesPath);
+    if (QFileInfo(filesPath).isDir()) {
+        m_watcher.addPath(filesPath);
+    }
+    scan(filesPath);
+}
+
+void TrashIndex::addItem(const QString& path) {
+    QString filesPath = filesPathOf(path);
+    addTrashDirectory(filesPathOf(filesPath));
+    if (!m_items.value(filesPath).contains(path)) {
+        insert(path);
+        publish();
+    }
+    // A listing in progress may have been taken before the item arrived
+    if (m_scanTasks.contains(filesPath)) {
+        scan(filesPath);
+    }
+}
+
+void TrashIndex::onDirectoryChanged(const QString& filesPath) {
+    scheduleScan(filesPath);
+}
+
+void TrashIndex::scheduleScan(const QString& filesPath) {
+    m_scheduledScans.insert(filesPath);
+    if (!m_scanTimer.isActive()) {
+        m_scanTimer.start();
+    }
+}
+
+void TrashIndex::scanScheduled() {
+    const QSet<QString> filesPaths = m_scheduledScans;
+    m_scheduledScans.clear();
+    for (const QString& filesPath : filesPaths) {
+        scan(filesPath);
+    }
+}
+
+// Lists one trash directory again in the background; a listing that is still in progress is
+// superseded, so that its outdated result is not applied
+void TrashIndex::scan(const QString& filesPath) {
+    if (!m_filesPaths.contains(filesPath)) {
+        return;
+    }
+    auto previous = m_scanTasks.find(filesPath);
+    if (previous != m_scanTasks.end()) {
+        previous->cancel();
+    }
+    CancellationToken token = TaskRuntime::instance()->run(TaskRuntime::Prefetch, this,
+        [filesPath](const CancellationToken&) {
+            return QDir(filesPath).entryList(QDir::NoDotAndDotDot | QDir::AllEntries | QDir::Hidden | QDir::System);
+        },
+        [this, filesPath](const QStringList& names) {
+            m_scanTasks.remove(filesPath);
+            applyListing(filesPath, names);
+        });
+    m_scanTasks.insert(filesPath, token);
+}
+
+// Applies the differences between a listing of one trash directory and the index
+void TrashIndex::applyListing(const QString& filesPath, const QStringList& names) {
+    QSet<QString> present;
+    for (const QString& name : names) {
+        present.insert(filesPath + "/" + name);
+    }
+
+    bool modified = false;
+    const QStringList known = m_items.value(filesPath).keys();
+    for (const QString& path : known) {
+        if (!present.contains(path)) {
+            remove(path);
+            modified = true;
+        }
+    }
+    const QHash<QString, qint64> items = m_items.value(filesPath);
+    for (const QString& path : qAsConst(present)) {
+        if (!items.contains(path)) {
+            insert(path);
+            modified = true;
+        }
+    }
+
+    if (modified) {
+        qDebug() << "TrashIndex:" << m_count << "items," << m_size << "bytes";
+        publish();
+    }
+}
+
+void TrashIndex::insert(const QString& path) {
+    m_items[filesPathOf(path)].insert(path, -1);
+    m_count++;
+    calculateSize(path);
+}
+
+void TrashIndex::remove(const QString& path) {
+    auto items = m_items.find(filesPathOf(path));
+    if (items == m_items.end() || !items->contains(path)) {
+        return;
+    }
+    qint64 size = items->take(path);
+    m_count--;
+    if (items->isEmpty()) {
+        m_items.erase(items);
+    }
+    // A result for this item, or for another one of the same name later, must not be counted
+    auto task = m_sizeTasks.find(path);
+    if (task != m_sizeTasks.end()) {
+        task->cancel();
+        m_sizeTasks.erase(task);
+    }
+    if (size > 0) {
+        m_size -= size;
+    }
+}
+
+void TrashIndex::calculateSize(const QString& path) {
+    CancellationToken token = TaskRuntime::instance()->run(TaskRuntime::Background, this,
+        [path](const CancellationToken& token) {
+            SizeVisitor visitor(token);
+            FileTreeWalker walker(&visitor);
+            walker.setStatMode(FileTreeWalker::StatFiles);
+            walker.walk(path);
+            return visitor.size;
+        },
+        [this, path](qint64 size) {
+            sizeCalculated(path, size);
+        });
+    m_sizeTasks.insert(path, token);
+}
+
+void TrashIndex::sizeCalculated(const QString& path, qint64 size) {
+    m_sizeTasks.remove(path);
+    auto items = m_items.find(filesPathOf(path));
+    if (items == m_items.end() || !items->contains(path)) {
+        return;
+    }
+    items->insert(path, size);
+    m_size += size;
+    publish();
+}
+
+void TrashIndex::publish() {
+    m_publishedCount = m_count;
+    m_publishedSize = m_size;
+    emit changed();
+}
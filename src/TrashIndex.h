@@ -0,0 +1,101 @@
+#ifndef TRASHINDEX_H
+#define TRASHINDEX_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include "TaskRuntime.h"
+#include <atomic>
+
+/**
+ * @file TrashIndex.h
+ * @class TrashIndex
+ * @brief Keeps track of the items in all trash directories of the user.
+ *
+ * The number of items and their total size are kept up to date from file system watcher events
+ * and from the trash operations of Filer itself, so that the Trash icon and the menus can ask
+ * whether the Trash is empty without touching the file system. Watcher events are coalesced, and
+ * only the trash directories that changed are listed again, in the background; the sizes of new
+ * items are calculated in the background as well.
+ */
+class TrashIndex : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Creates and fills the index; must be called on the GUI thread before instance() is used.
+     * @note Creates the MountMonitor as well if need be.
+     */
+    static void create();
+
+    static TrashIndex* instance();
+
+    /**
+     * @note isEmpty(), count() and size() may be called from any thread, e.g., by the icon provider.
+     */
+    bool isEmpty() const { return count() == 0; }
+    int count() const { return m_publishedCount.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns the total size in bytes of the items whose size is known already.
+     */
+    qint64 size() const { return m_publishedSize.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Starts tracking a trash directory, e.g., after the first item was moved to the Trash on a volume.
+     * @param trashDirectory The directory holding "files" and "info".
+     */
+    void addTrashDirectory(const QString& trashDirectory);
+
+    /**
+     * @brief Records an item that Filer has just moved to the Trash, ahead of the watcher event.
+     * @param path The path of the item in the "files" directory of its trash directory.
+     */
+    void addItem(const QString& path);
+
+    /**
+     * @brief Looks for trash directories on volumes that were mounted or unmounted.
+     * @note Called whenever MountMonitor reports a change.
+     */
+    void refreshTrashDirectories();
+
+signals:
+    /**
+     * @brief Emitted whenever the number of items or their total size changes.
+     */
+    void changed();
+
+private slots:
+    void onDirectoryChanged(const QString& filesPath);
+
+private:
+    explicit TrashIndex(QObject* parent = nullptr);
+
+    void scheduleScan(const QString& filesPath);
+    void scanScheduled();
+    void scan(const QString& filesPath);
+    void applyListing(const QString& filesPath, const QStringList& names);
+    void insert(const QString& path);
+    void remove(const QString& path);
+    void calculateSize(const QString& path);
+    void sizeCalculated(const QString& path, qint64 size);
+    void publish();
+
+    QFileSystemWatcher m_watcher;
+    QSet<QString> m_filesPaths; /**< The "files" directories being tracked. */
+    QSet<QString> m_scheduledScans; /**< The "files" directories to list again when m_scanTimer fires. */
+    QTimer m_scanTimer;
+    QHash<QString, CancellationToken> m_scanTasks; /**< Listings in progress, by "files" directory. */
+    /** Size of each item, or -1 while it is being calculated, by the "files" directory that holds it. */
+    QHash<QString, QHash<QString, qint64>> m_items;
+    QHash<QString, CancellationToken> m_sizeTasks; /**< Pending size calculations, canceled when their item goes away. */
+    int m_count = 0;
+    qint64 m_size = 0;
+    std::atomic<int> m_publishedCount{0}; /**< m_count as of the last change, for other threads. */
+    std::atomic<qint64> m_publishedSize{0};
+};
+
+#endif // TRASHINDEX_H
@@ -0,0 +1,48 @@
+#include "Vfs.h"
+#include "LatencyVfs.h"
+#include "LocalVfs.h"
+#include <atomic>
+
+namespace {
+
+std::atomic<Vfs*> currentVfs{nullptr};
+
+Vfs* createFromEnvironment() {
+    return LatencyVfs::fromEnvironment(std::unique_ptr<Vfs>(new LocalVfs())).release();
+}
+
+}
+
+Vfs* Vfs::instance() {
+    Vfs* vfs = currentVfs.load(std::memory_order_acquire);
+    if (vfs) {
+        return vfs;
+    }
+    // Never destroyed; worker threads may still be probing items at exit
+    static Vfs* initialVfs = createFromEnvironment();
+    Vfs* expected = nullptr;
+    currentVfs.compare_exchange_strong(expected, initialVfs, std::memory_order_acq_rel);
+    return currentVfs.load(std::memory_order_acquire);
+}
+
+void Vfs::setInstance(Vfs* vfs) {
+    currentVfs.store(vfs, std::memory_order_release);
+}
+
+QString Vfs::operationName(Operation operation) {
+    switch (operation) {
+    case Stat:
+        return "stat";
+    case List:
+        return "list";
+    case Open:
+        return "open";
+    case Read:
+        return "read";
+    case Write:
+        return "write";
+    case ExtendedAttribute:
+        return "xattr";
+    }
+    return QString();
+}
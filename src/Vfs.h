@@ -0,0 +1,94 @@
+#ifndef VFS_H
+#define VFS_H
+
+#include <QByteArray>
+#include <QDir>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @file Vfs.h
+ * @class Vfs
+ * @brief The file system as seen by the code that runs per item, so that slow media can be simulated.
+ *
+ * ApplicationBundle, LaunchDB, ExtendedAttributes, and through them CustomFileSystemModel and its
+ * icon provider, as well as the copy backends and FileTreeWalker go through Vfs::instance() rather
+ * than calling the file system themselves; code that works on file descriptors accounts its calls
+ * with account(). The instance is a LocalVfs unless FILER_VFS_LATENCY or FILER_VFS_BANDWIDTH is
+ * set, in which case a LatencyVfs makes the local file system behave like a USB stick or an NFS
+ * share; see LatencyVfs.h.
+ *
+ * @note QFileSystemModel lists folders on a thread of its own, which does not go through the Vfs.
+ * The icon provider, which that thread calls for every item, accounts a stat per item for it;
+ * reading the folder itself is not delayed.
+ */
+class Vfs {
+public:
+    enum Operation { Stat, List, Open, Read, Write, ExtendedAttribute };
+    static constexpr int OperationCount = 6;
+
+    struct Status {
+        bool exists = false;
+        bool isDirectory = false;
+        bool isSymLink = false;
+        bool isExecutable = false; /**< Any of the execute permissions is set. */
+        qint64 size = 0;
+    };
+
+    virtual ~Vfs() = default;
+
+    static Vfs* instance();
+
+    /**
+     * @brief Replaces the instance, e.g., in a benchmark.
+     * @param vfs Must stay alive until the process exits; so must the previous instance, because
+     * other threads may still be using it.
+     */
+    static void setInstance(Vfs* vfs);
+
+    /**
+     * @brief Returns the status of a path; of the link itself rather than its target if followSymLinks is false.
+     */
+    virtual Status status(const QString& path, bool followSymLinks = true) = 0;
+
+    bool exists(const QString& path) { return status(path).exists; }
+
+    /**
+     * @brief Returns the absolute path that a symbolic link points to, or an empty string if it is none.
+     */
+    virtual QString symLinkTarget(const QString& path) = 0;
+
+    /**
+     * @brief Returns the names of the entries of a folder, sorted as QDir sorts them by default.
+     * @param nameFilters Wildcards that the names must match; all names match if empty.
+     * @param filters The kinds of entries; QDir::NoFilter means the default of QDir.
+     */
+    virtual QStringList entries(const QString& directory, const QStringList& nameFilters = QStringList(),
+                                QDir::Filters filters = QDir::NoFilter) = 0;
+
+    /**
+     * @brief Reads an attribute in the "user" namespace.
+     * @return The value, or an empty array if the attribute is not set or cannot be read.
+     */
+    virtual QByteArray readExtendedAttribute(const QString& path, const QString& name) = 0;
+
+    virtual bool writeExtendedAttribute(const QString& path, const QString& name, const QByteArray& value) = 0;
+
+    /**
+     * @brief Accounts for I/O that the caller does itself on file descriptors, like the copy backends do.
+     * @param bytes For Read and Write, the number of bytes transferred.
+     */
+    virtual void account(Operation operation, qint64 bytes = 0) {
+        Q_UNUSED(operation)
+        Q_UNUSED(bytes)
+    }
+
+    /**
+     * @brief Returns whether the file system behaves unlike the local one, e.g., has injected latency.
+     */
+    virtual bool isSimulated() const { return false; }
+
+    static QString operationName(Operation operation);
+};
+
+#endif // VFS_H
@@ -31,122 +31,103 @@
 #include <QFileInfo>
 #include <QStringList>
 #include <QStorageInfo>
-#include <QThread>
-#include <QApplication>
 #include <QProcess>
+#include "MountMonitor.h"
 #include "AppGlobals.h"
 #include "TrashHandler.h"
 #include <QDateTime>
 
-VolumeWatcher::VolumeWatcher(QObject *parent) : QObject(parent)
+VolumeWatcher::VolumeWatcher(const QString &rootDiskName, QObject *parent) : QObject(parent)
 {
 
-    m_mediaPath = getMediaPath();
+    // Probed at startup before the VolumeWatcher is created
+    m_mediaPath = AppGlobals::mediaPath();
+    m_desktopPath = QDir::homePath() + "/Desktop";
 
-    m_watcher.addPath(m_mediaPath);
+    QString diskLabel = rootDiskName;
 
-    QString diskLabel = getRootDiskName();
-
-    if (! QFile::exists(QDir::homePath() + "/Desktop/" + diskLabel)) {
-        QFile::link("/", QDir::homePath() + "/Desktop/" + diskLabel);
+    if (! QFile::exists(m_desktopPath + "/" + diskLabel)) {
+        QFile::link("/", m_desktopPath + "/" + diskLabel);
     }
 
     // Handle the Trash
-    if (! QFile::exists(QDir::homePath() + "/Desktop/" + tr("Trash"))) {
+    if (! QFile::exists(m_desktopPath + "/" + tr("Trash"))) {
         QString trashPath = TrashHandler::getTrashPath();
-        QFile::link(trashPath, QDir::homePath() + "/Desktop/" + tr("Trash"));
+        QFile::link(trashPath, m_desktopPath + "/" + tr("Trash"));
     }
 
     // Run initially
-    handleDirectoryChange(m_mediaPath);
+    synchronizeSymlinks();
 
-    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &VolumeWatcher::handleDirectoryChange);
-    // We also need to get notified when directories are deleted, so we monitor the parent directory like this:
-    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &VolumeWatcher::handleDirectoryChange);
+    // From now on, only the changes to the mount table are applied
+    connect(MountMonitor::instance(), &MountMonitor::mounted, this, &VolumeWatcher::handleMount);
+    connect(MountMonitor::instance(), &MountMonitor::unmounted, this, &VolumeWatcher::handleUnmount);
 }
 
-void VolumeWatcher::handleDirectoryChange(const QString &path)
+bool VolumeWatcher::isMediaVolume(const QString &mountPoint) const
 {
-    qDebug() << "Directory changed:" << path;
-    QDir mediaDir(path);
-    QStringList mediaDirectories = mediaDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-
-    // Construct a list of symlinks that we have already created
-    QString directoryPath = QDir::homePath() + "/Desktop"; // Change this to the directory you want to search
-
-    QDir directory(directoryPath);
-    QFileInfoList entries = directory.entryInfoList(QDir::NoDotAndDotDot | QDir::Files | QDir::Dirs | QDir::System | QDir::Hidden | QDir::NoSymLinks, QDir::DirsFirst);
-
-    QStringList symlinkPaths;
+    QFileInfo info(mountPoint);
+    if (info.absolutePath() != m_mediaPath) {
+        return false;
+    }
 
-            foreach (const QFileInfo &entryInfo, entries) {
-            if (entryInfo.isSymLink()) {
-                // If links to /media
-                if (entryInfo.symLinkTarget().startsWith(m_mediaPath + "/")) {
-                    symlinkPaths.append(entryInfo.fileName());
-                }
-            }
+    // Skip /media/LIVE if it is the same as /
+    if (mountPoint == "/media/LIVE") {
+        // Using the file COPYRIGHT, compare the creation date
+        QFileInfo fileInfo1("/COPYRIGHT");
+        QFileInfo fileInfo2("/media/LIVE/COPYRIGHT");
+        if (fileInfo1.created() == fileInfo2.created()) {
+            qDebug() << "Skipping" << mountPoint << "because it is the same as /";
+            return false;
         }
+    }
+    return true;
+}
 
-    qDebug() << "Symlink paths:" << symlinkPaths;
-
-    for (const QString &dirName : mediaDirectories) {
-        QString fullPath = mediaDir.absoluteFilePath(dirName);
-        QString symlinkPath = QDir::homePath() + "/Desktop/" + dirName;
-
-        // Skip /media/LIVE if it is the same as /
-        if (fullPath == "/media/LIVE") {
-            // Using the file COPYRIGHT, compare the creation date
-            QFileInfo fileInfo1("/COPYRIGHT");
-            QFileInfo fileInfo2("/media/LIVE/COPYRIGHT");
-            if (fileInfo1.created() == fileInfo2.created()) {
-                qDebug() << "Skipping" << fullPath << "because it is the same as /";
-                continue;
-            }
-        }
+void VolumeWatcher::handleMount(const QString &mountPoint)
+{
+    if (!isMediaVolume(mountPoint)) {
+        return;
+    }
+    QString symlinkPath = m_desktopPath + "/" + QFileInfo(mountPoint).fileName();
+    if (QFileInfo(symlinkPath).isSymLink() || QFile::exists(symlinkPath)) {
+        qDebug() << "Symlink already exists for" << mountPoint;
+        return;
+    }
+    QFile::link(mountPoint, symlinkPath);
+    qDebug() << "Symlink created for" << mountPoint;
+}
 
-        if (QFile::exists(fullPath)) {
-            if (!QFile::exists(symlinkPath)) {
-                // Wait until a mount point appears at the target or 5 seconds have passed
-                int counter = 0;
-                QStringList mountPoints;
-                while (true) {
-                    for (const QStorageInfo &storage : QStorageInfo::mountedVolumes()) {
-                        mountPoints << storage.rootPath();
-                    }
-                    if (mountPoints.contains(fullPath)) {
-                        break;
-                    }
-                    QThread::msleep(100);
-                    qApp->processEvents();
-                    qDebug() << "Waiting for mount point to appear at" << fullPath;
-                    // TODO: Replace this by an asynchronous approach
-                    counter++;
-                    if (counter > 20) {
-                        // Give up after 2 seconds
-                        break;
-                    }
-                }
-                if (mountPoints.contains(fullPath)) {
-                    QFile::link(fullPath, symlinkPath);
-                    qDebug() << "Symlink created for" << fullPath;
-                } else {
-                    qDebug() << "Giving up on" << fullPath;
-                }
-            } else {
-                qDebug() << "Symlink already exists for" << fullPath;
-            }
-        }
+void VolumeWatcher::handleUnmount(const QString &mountPoint)
+{
+    if (QFileInfo(mountPoint).absolutePath() != m_mediaPath) {
+        return;
+    }
+    // Only remove the symlink if it is ours
+    QFileInfo symlinkInfo(m_desktopPath + "/" + QFileInfo(mountPoint).fileName());
+    if (symlinkInfo.isSymLink() && symlinkInfo.symLinkTarget() == mountPoint) {
+        QFile::remove(symlinkInfo.absoluteFilePath());
+        qDebug() << "Symlink removed for" << mountPoint;
     }
+}
 
-    // Clean up symlinks for targets that no longer exist in /media/
-    for (const QString &symlinkPath : symlinkPaths) {
-        QString fullPath = m_mediaPath + "/" + symlinkPath;
-        if (!QFile::exists(fullPath)) {
-            QFile::remove(QDir::homePath() + "/Desktop/" + symlinkPath);
-            qDebug() << "Symlink removed for" << fullPath;
+void VolumeWatcher::synchronizeSymlinks()
+{
+    // Clean up symlinks to volumes that were unmounted while we were not running
+    QDir directory(m_desktopPath);
+    const QFileInfoList entries = directory.entryInfoList(QDir::NoDotAndDotDot | QDir::AllEntries | QDir::System | QDir::Hidden);
+    for (const QFileInfo &entryInfo : entries) {
+        if (entryInfo.isSymLink() && entryInfo.symLinkTarget().startsWith(m_mediaPath + "/")
+                && !MountMonitor::instance()->isMountPoint(entryInfo.symLinkTarget())) {
+            QFile::remove(entryInfo.absoluteFilePath());
+            qDebug() << "Symlink removed for" << entryInfo.symLinkTarget();
         }
     }
+
+    const QStringList mountPoints = MountMonitor::instance()->mountPoints();
+    for (const QString &mountPoint : mountPoints) {
+        handleMount(mountPoint);
+    }
 }
 
 QString VolumeWatcher::getMediaPath() {
@@ -175,7 +156,7 @@ QString VolumeWatcher::getMediaPath() {
     return mediaPath;
 }
 
-QString VolumeWatcher::getRootDiskName() {
+QString VolumeWatcher::probeRootDiskName() {
 
     // TODO: Make this generic and not only use it for the root disk; also use it for other disks
 
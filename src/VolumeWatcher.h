@@ -28,16 +28,15 @@
 #define VOLUMEWATCHER_H
 
 #include <QObject>
-#include <QFileSystemWatcher>
 
 /**
  * @file VolumeWatcher.h
  * @class VolumeWatcher
- * @brief The VolumeWatcher class monitors changes in a directory and manages symlinks to new directories.
+ * @brief The VolumeWatcher class manages symlinks on the Desktop to the volumes mounted below the media directory.
  *
- * This class uses QFileSystemWatcher to keep track of changes in the /media directory.
- * When a new subdirectory appears, it creates a symlink to that subdirectory on the user's desktop.
- * If a subdirectory disappears, the corresponding symlink is removed.
+ * This class follows the mounts and unmounts reported by MountMonitor.
+ * When a volume is mounted in the media directory, it creates a symlink to it on the user's desktop.
+ * When it is unmounted, the corresponding symlink is removed.
  * @Note This class should be replaced by a more appropriate solution, e.g., using a QProxyModel
  * to display the contents of the /media directory alongside the contents of the user's home directory
  * without the need to create symlinks.
@@ -49,24 +48,46 @@ Q_OBJECT
 public:
     /**
      * @brief Constructs a VolumeWatcher object.
+     * @param rootDiskName The name of the symlink to / on the Desktop, as probed by probeRootDiskName().
      * @param parent The parent QObject.
      */
-    explicit VolumeWatcher(QObject *parent = nullptr);
+    explicit VolumeWatcher(const QString &rootDiskName, QObject *parent = nullptr);
 
+    /**
+     * @brief Determines whether volumes are mounted in /media or /media/$USER.
+     * @note Runs an external command; use AppGlobals::mediaPath() instead.
+     */
     static QString getMediaPath();
 
-    static QString getRootDiskName();
+    /**
+     * @brief Determines the name of the root disk.
+     * @note Runs an external command; use AppGlobals::rootDiskName() instead.
+     */
+    static QString probeRootDiskName();
 
 private slots:
     /**
-     * @brief Handles changes in the monitored directory.
-     * @param path The path of the directory that has changed.
+     * @brief Creates the symlink on the Desktop for a volume mounted in the media directory.
+     * @param mountPoint The path at which the volume was mounted.
      */
-    void handleDirectoryChange(const QString &path);
+    void handleMount(const QString &mountPoint);
+
+    /**
+     * @brief Removes the symlink on the Desktop for a volume that was unmounted.
+     * @param mountPoint The path at which the volume was mounted.
+     */
+    void handleUnmount(const QString &mountPoint);
 
 private:
-    QFileSystemWatcher m_watcher; /**< The QFileSystemWatcher used to monitor changes. */
-    QString m_mediaPath; /**< The path of the directory to monitor. */
+    /**
+     * @brief Brings the symlinks on the Desktop in line with the mounted volumes once at startup.
+     */
+    void synchronizeSymlinks();
+
+    bool isMediaVolume(const QString &mountPoint) const;
+
+    QString m_mediaPath; /**< The directory in which volumes are mounted. */
+    QString m_desktopPath; /**< The directory in which the symlinks are created. */
 };
 
 #endif // VOLUMEWATCHER_H
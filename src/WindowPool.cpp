@@ -0,0 +1,64 @@
+#include "WindowPool.h"
+#include "FileManagerMainWindow.h"
+#include <QApplication>
+#include <QDebug>
+
+WindowPool* WindowPool::instance() {
+    static WindowPool* pool = new WindowPool(qApp);
+    return pool;
+}
+
+WindowPool::WindowPool(QObject* parent) : QObject(parent) {
+    m_refillTimer.setSingleShot(true);
+    connect(&m_refillTimer, &QTimer::timeout, this, &WindowPool::prepareWindow);
+
+    // The windows in the pool are never shown, so nothing else deletes them
+    connect(qApp, &QCoreApplication::aboutToQuit, this, [this]() {
+        m_refillTimer.stop();
+        for (const QPointer<FileManagerMainWindow>& window : m_windows) {
+            delete window.data();
+        }
+        m_windows.clear();
+    });
+}
+
+FileManagerMainWindow* WindowPool::take(const QString& directory) {
+    FileManagerMainWindow* window = nullptr;
+    while (!window && !m_windows.isEmpty()) {
+        window = m_windows.takeFirst().data();
+    }
+    if (window) {
+        qDebug() << "Taking a prepared window for" << directory;
+        window->bindDirectory(directory);
+    } else {
+        window = new FileManagerMainWindow(nullptr, directory);
+    }
+
+    m_refillTimer.start(RefillDelay);
+    return window;
+}
+
+void WindowPool::refill() {
+    if (m_windows.size() < m_capacity && !m_refillTimer.isActive()) {
+        m_refillTimer.start(0);
+    }
+}
+
+void WindowPool::prepareWindow() {
+    // The desktop has to be the first window
+    if (FileManagerMainWindow::instances().isEmpty() || m_windows.size() >= m_capacity) {
+        return;
+    }
+
+    FileManagerMainWindow* window = new FileManagerMainWindow(nullptr, QString());
+    // Create the native window and apply the style now rather than when the window is shown
+    window->create();
+    window->ensurePolished();
+    m_windows.append(window);
+    qDebug() << "Prepared a window," << m_windows.size() << "of" << m_capacity << "ready";
+
+    // One window per pass so that the event loop stays responsive
+    if (m_windows.size() < m_capacity) {
+        m_refillTimer.start(0);
+    }
+}
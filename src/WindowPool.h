@@ -0,0 +1,50 @@
+#ifndef WINDOWPOOL_H
+#define WINDOWPOOL_H
+
+#include <QObject>
+#include <QList>
+#include <QPointer>
+#include <QTimer>
+
+class FileManagerMainWindow;
+
+/**
+ * @file WindowPool.h
+ * @class WindowPool
+ * @brief Keeps a few hidden folder windows ready so that opening a folder does not have to build one.
+ *
+ * The windows in the pool have their views, models, delegate, menus and shortcuts set up already;
+ * opening a folder only binds the directory to one of them and shows it. The pool is refilled one
+ * window at a time when the application is idle after a window has been taken.
+ */
+class WindowPool : public QObject {
+    Q_OBJECT
+
+public:
+    static WindowPool* instance();
+
+    /**
+     * @brief Returns a window showing the directory, built on the spot if the pool is empty.
+     * @note The window is not shown yet.
+     */
+    FileManagerMainWindow* take(const QString& directory);
+
+public slots:
+    /**
+     * @brief Fills the pool up to its capacity in idle time.
+     */
+    void refill();
+
+private:
+    explicit WindowPool(QObject* parent = nullptr);
+
+    void prepareWindow();
+
+    static constexpr int RefillDelay = 500; /**< Milliseconds to wait after a window was taken so that it can paint first. */
+
+    QList<QPointer<FileManagerMainWindow>> m_windows;
+    QTimer m_refillTimer;
+    int m_capacity = 2; /**< Number of windows kept ready. */
+};
+
+#endif // WINDOWPOOL_H
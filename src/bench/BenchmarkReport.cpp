@@ -0,0 +1,75 @@
+#include "BenchmarkReport.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QJsonDocument>
+#include <algorithm>
+#include <stdio.h>
+
+void BenchmarkReport::print(const QString& benchmark, const QJsonObject& values) {
+    QJsonObject result = values;
+    result.insert("benchmark", benchmark);
+    QByteArray line = QJsonDocument(result).toJson(QJsonDocument::Compact);
+    fprintf(stdout, "%s\n", line.constData());
+    fflush(stdout);
+}
+
+QJsonObject BenchmarkReport::timing(QVector<double> seconds) {
+    QJsonObject result;
+    result.insert("iterations", seconds.size());
+    if (seconds.isEmpty()) {
+        return result;
+    }
+
+    std::sort(seconds.begin(), seconds.end());
+    double sum = 0.0;
+    for (double value : seconds) {
+        sum += value;
+    }
+    int middle = seconds.size() / 2;
+    double median = seconds.size() % 2 ? seconds.at(middle) : (seconds.at(middle - 1) + seconds.at(middle)) / 2.0;
+
+    result.insert("min_seconds", seconds.first());
+    result.insert("median_seconds", median);
+    result.insert("mean_seconds", sum / seconds.size());
+    return result;
+}
+
+QJsonObject BenchmarkReport::timingPerItem(const QVector<double>& seconds, int items) {
+    QJsonObject result = timing(seconds);
+    result.insert("items", items);
+    if (items > 0 && !seconds.isEmpty()) {
+        result.insert("nanoseconds_per_item", result.value("median_seconds").toDouble() * 1e9 / items);
+    }
+    return result;
+}
+
+QVector<double> BenchmarkReport::repeat(int iterations, const std::function<void(int iteration)>& run) {
+    QVector<double> seconds;
+    for (int i = 0; i < iterations; i++) {
+        QElapsedTimer timer;
+        timer.start();
+        run(i);
+        seconds << timer.nsecsElapsed() / 1e9;
+
+        // E.g., the icon provider defers deleting the bundles it constructs to the event loop
+        QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    }
+    return seconds;
+}
+
+QJsonObject BenchmarkReport::measure(const QStringList& paths, int iterations, const QString& countKey,
+                                     const std::function<bool(const QString& path)>& probe) {
+    int count = 0;
+    QVector<double> seconds = repeat(iterations, [&](int) {
+        count = 0;
+        for (const QString& path : paths) {
+            if (probe(path)) {
+                count++;
+            }
+        }
+    });
+    QJsonObject result = timingPerItem(seconds, paths.size());
+    result.insert(countKey, count);
+    return result;
+}
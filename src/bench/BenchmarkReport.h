@@ -0,0 +1,55 @@
+#ifndef BENCHMARKREPORT_H
+#define BENCHMARKREPORT_H
+
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+
+/**
+ * @file BenchmarkReport.h
+ * @class BenchmarkReport
+ * @brief Writes benchmark results in a machine-readable form.
+ *
+ * Every result is printed to standard output as one JSON object per line, so that the output
+ * of several runs can be concatenated and compared with standard tools.
+ */
+class BenchmarkReport {
+public:
+    /**
+     * @brief Prints one result.
+     * @param benchmark The name of the benchmark; stored under the key "benchmark".
+     * @param values The measured values and the parameters they were measured with.
+     */
+    static void print(const QString& benchmark, const QJsonObject& values);
+
+    /**
+     * @brief Summarizes a series of timings as iterations, min_seconds, median_seconds and mean_seconds.
+     */
+    static QJsonObject timing(QVector<double> seconds);
+
+    /**
+     * @brief Like timing(), for runs that each process the same number of items; adds items and
+     * nanoseconds_per_item.
+     */
+    static QJsonObject timingPerItem(const QVector<double>& seconds, int items);
+
+    /**
+     * @brief Times run for the given number of iterations.
+     *
+     * Objects whose deletion was deferred during a run are deleted after it, outside of the timing.
+     * @return The seconds taken by each run.
+     */
+    static QVector<double> repeat(int iterations, const std::function<void(int iteration)>& run);
+
+    /**
+     * @brief Times calling probe on each of the paths, and summarizes the runs like timingPerItem().
+     * @param countKey The key under which the number of paths is stored for which probe returned true
+     * in the last run.
+     */
+    static QJsonObject measure(const QStringList& paths, int iterations, const QString& countKey,
+                               const std::function<bool(const QString& path)>& probe);
+};
+
+#endif // BENCHMARKREPORT_H
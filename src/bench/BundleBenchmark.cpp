@@ -0,0 +1,34 @@
+#include "BundleBenchmark.h"
+#include "BenchmarkReport.h"
+#include "FixtureTree.h"
+#include "ApplicationBundle.h"
+#include <QCommandLineParser>
+
+int runBundleBenchmark(const QStringList& arguments) {
+    QCommandLineParser parser;
+    FixtureTree::addOptions(parser, "Number of items of each kind.", 1000, "Number of timed runs per kind.", 5);
+    parser.process(QStringList() << "filer-bench bundle" << arguments);
+    FixtureTree::Options options = FixtureTree::options(parser);
+
+    FixtureTree tree(options.dir);
+    if (!tree.isValid()) {
+        return 1;
+    }
+
+    for (FixtureTree::Kind kind : FixtureTree::kinds()) {
+        if (kind == FixtureTree::DeepTree) {
+            continue;
+        }
+        QStringList paths = tree.create(kind, options.items);
+        if (paths.isEmpty()) {
+            return 1;
+        }
+
+        QJsonObject result = BenchmarkReport::measure(paths, options.iterations, "valid_bundles", [](const QString& path) {
+            return ApplicationBundle(path).isValid();
+        });
+        result.insert("kind", FixtureTree::name(kind));
+        BenchmarkReport::print("bundle", result);
+    }
+    return 0;
+}
@@ -0,0 +1,19 @@
+#ifndef BUNDLEBENCHMARK_H
+#define BUNDLEBENCHMARK_H
+
+#include <QStringList>
+
+/**
+ * @file BundleBenchmark.h
+ * @brief Measures how long it takes to construct an ApplicationBundle for each kind of item.
+ *
+ * Filer constructs an ApplicationBundle for every item it shows, sorts or draws, so this is
+ * the cost of recognizing what an item is. Plain files are included as the common case of
+ * an item that is not a bundle at all.
+ *
+ * @param arguments The command line arguments following the name of the benchmark.
+ * @return The exit code.
+ */
+int runBundleBenchmark(const QStringList& arguments);
+
+#endif // BUNDLEBENCHMARK_H
@@ -0,0 +1,190 @@
+#include "CopyBenchmark.h"
+#include "BenchmarkReport.h"
+#include "CopyBackend.h"
+#include "CopyThread.h"
+#include "FixtureTree.h"
+#include "HashPipeline.h"
+#include "ProgressTelemetry.h"
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QDebug>
+
+namespace {
+
+class CountingObserver : public CopyObserver {
+public:
+    bool shouldContinue() override { return true; }
+    void fileStarted(int) override { }
+    void bytesCopied(qint64 bytes) override { bytesDone += bytes; }
+    void bytesSkipped(qint64) override { }
+    void fileSynced(int, qint64) override { }
+    void fileFinished(int, const QByteArray&) override { filesDone++; }
+
+    qint64 bytesDone = 0;
+    int filesDone = 0;
+};
+
+bool createFixture(const QString& folder, int fileCount, qint64 fileSize, QVector<FileCopyRequest>& files,
+                   const QString& targetFolder) {
+    QByteArray data(static_cast<int>(qMin<qint64>(fileSize, 1024 * 1024)), Qt::Uninitialized);
+    QRandomGenerator generator(42);
+    generator.fillRange(reinterpret_cast<quint32*>(data.data()), data.size() / sizeof(quint32));
+
+    for (int i = 0; i < fileCount; i++) {
+        // Spread the files over a few folders like a real tree
+        QString relativePath = QString("%1/file%2").arg(i % 16).arg(i);
+        QString sourcePath = folder + "/" + relativePath;
+        QDir().mkpath(QFileInfo(sourcePath).path());
+        QDir().mkpath(QFileInfo(targetFolder + "/" + relativePath).path());
+
+        QFile file(sourcePath);
+        if (!file.open(QIODevice::WriteOnly)) {
+            qWarning() << "Cannot create" << sourcePath;
+            return false;
+        }
+        for (qint64 written = 0; written < fileSize; written += data.size()) {
+            file.write(data.constData(), qMin<qint64>(data.size(), fileSize - written));
+        }
+        files.append({sourcePath, targetFolder + "/" + relativePath, fileSize});
+    }
+    return true;
+}
+
+}
+
+int runCopyBenchmark(const QStringList& arguments) {
+    QCommandLineParser parser;
+    parser.addOptions({
+        {"dir", "Scratch folder for the fixture (default: /dev/shm).", "path", FixtureTree::defaultScratchFolder()},
+        {"files", "Number of files to copy.", "count", "256"},
+        {"size", "Size of each file in KiB.", "kib", "1024"},
+        {"iterations", "Number of timed copies per backend.", "count", "5"},
+        {"backend", "Backend to measure; may be given more than once (default: sync and io_uring).", "name"},
+        {"hash", "Hash the data while copying, as verified copies do."},
+    });
+    parser.process(QStringList() << "filer-bench copy" << arguments);
+
+    int fileCount = parser.value("files").toInt();
+    qint64 fileSize = parser.value("size").toLongLong() * 1024;
+    int iterations = qMax(1, parser.value("iterations").toInt());
+    QStringList backends = parser.values("backend");
+    if (backends.isEmpty()) {
+        backends << "sync" << "io_uring";
+    }
+
+    QTemporaryDir scratch(parser.value("dir") + "/filer-bench-XXXXXX");
+    if (!scratch.isValid()) {
+        qWarning() << "Cannot create a scratch folder in" << parser.value("dir");
+        return 1;
+    }
+    QString sourceFolder = scratch.filePath("source");
+    QString targetFolder = scratch.filePath("target");
+    bool hash = parser.isSet("hash");
+    HashPipeline hashPipeline;
+    QVector<FileCopyRequest> files;
+    if (!createFixture(sourceFolder, fileCount, fileSize, files, targetFolder)) {
+        return 1;
+    }
+
+    for (const QString& backendName : backends) {
+        std::unique_ptr<CopyBackend> backend = CopyBackend::create(backendName);
+        if (backend->name() != backendName) {
+            qWarning() << "Skipping" << backendName << "because it is not available";
+            continue;
+        }
+        backend->setHashPipeline(hash ? &hashPipeline : nullptr);
+
+        QVector<double> seconds;
+        for (int i = 0; i < iterations; i++) {
+            CountingObserver observer;
+            QElapsedTimer timer;
+            timer.start();
+            if (!backend->copyFiles(files, &observer)) {
+                qWarning() << backendName << "failed:" << backend->errorString();
+                return 1;
+            }
+            seconds << timer.nsecsElapsed() / 1e9;
+
+            // Remove the copies but keep the folders for the next iteration
+            for (const FileCopyRequest& file : files) {
+                QFile::remove(file.targetPath);
+            }
+        }
+
+        QJsonObject result = BenchmarkReport::timing(seconds);
+        result.insert("backend", backendName);
+        result.insert("hash", hash ? HashPipeline::algorithm() : QString());
+        result.insert("folder", parser.value("dir"));
+        result.insert("files", fileCount);
+        result.insert("bytes", static_cast<double>(fileSize * fileCount));
+        result.insert("megabytes_per_second", fileSize * fileCount / result.value("median_seconds").toDouble() / 1e6);
+        BenchmarkReport::print("copy", result);
+    }
+    return 0;
+}
+
+int runCopyThreadBenchmark(const QStringList& arguments) {
+    QCommandLineParser parser;
+    parser.addOptions({
+        {"dir", "Scratch folder for the fixture (default: /dev/shm).", "path", FixtureTree::defaultScratchFolder()},
+        {"files", "Number of files to copy.", "count", "256"},
+        {"size", "Size of each file in KiB.", "kib", "1024"},
+        {"iterations", "Number of timed copies.", "count", "5"},
+        {"verify", "Check the copies against their sources afterwards, as fileoperation --verify does."},
+    });
+    parser.process(QStringList() << "filer-bench copy-thread" << arguments);
+
+    int fileCount = parser.value("files").toInt();
+    qint64 fileSize = parser.value("size").toLongLong() * 1024;
+    int iterations = qMax(1, parser.value("iterations").toInt());
+    bool verify = parser.isSet("verify");
+
+    QTemporaryDir scratch(parser.value("dir") + "/filer-bench-XXXXXX");
+    if (!scratch.isValid()) {
+        qWarning() << "Cannot create a scratch folder in" << parser.value("dir");
+        return 1;
+    }
+    QString sourceFolder = scratch.filePath("source");
+    QString targetFolder = scratch.filePath("target");
+    QVector<FileCopyRequest> files;
+    if (!createFixture(sourceFolder, fileCount, fileSize, files, scratch.filePath("unused"))) {
+        return 1;
+    }
+
+    QVector<double> seconds;
+    for (int i = 0; i < iterations; i++) {
+        ProgressTelemetry telemetry;
+        CopyThread thread(QStringList() << sourceFolder, targetFolder, &telemetry);
+        thread.setVerifyTargets(verify);
+        QString errorMessage;
+        QObject::connect(&thread, &OperationThread::error, [&errorMessage](const QString& message) {
+            errorMessage = message;
+        });
+
+        // Includes planning the copy and, with --verify, reading the copies back
+        QElapsedTimer timer;
+        timer.start();
+        thread.start();
+        thread.wait();
+        seconds << timer.nsecsElapsed() / 1e9;
+
+        if (!errorMessage.isEmpty()) {
+            qWarning() << "CopyThread failed:" << errorMessage;
+            return 1;
+        }
+        QDir(targetFolder).removeRecursively();
+    }
+
+    QJsonObject result = BenchmarkReport::timing(seconds);
+    result.insert("verify", verify);
+    result.insert("folder", parser.value("dir"));
+    result.insert("files", fileCount);
+    result.insert("bytes", static_cast<double>(fileSize * fileCount));
+    result.insert("megabytes_per_second", fileSize * fileCount / result.value("median_seconds").toDouble() / 1e6);
+    BenchmarkReport::print("copy-thread", result);
+    return 0;
+}
@@ -0,0 +1,27 @@
+#ifndef COPYBENCHMARK_H
+#define COPYBENCHMARK_H
+
+#include <QStringList>
+
+/**
+ * @file CopyBenchmark.h
+ * @brief Compares the copy backends of fileoperation.
+ *
+ * Creates a tree of files in a scratch folder, preferably on tmpfs so that the storage is not
+ * the bottleneck, and copies it with each available backend. Point --dir at a loopback mount
+ * to include a real file system in the measurement.
+ *
+ * @param arguments The command line arguments following the name of the benchmark.
+ * @return The exit code.
+ */
+int runCopyBenchmark(const QStringList& arguments);
+
+/**
+ * @brief Measures the throughput of CopyThread, as fileoperation runs it, on the same kind of tree.
+ *
+ * Unlike runCopyBenchmark(), this includes planning the copy, creating the folders, updating
+ * the progress telemetry and, with --verify, checking the copies.
+ */
+int runCopyThreadBenchmark(const QStringList& arguments);
+
+#endif // COPYBENCHMARK_H
@@ -0,0 +1,182 @@
+#include "FixtureTree.h"
+#include <QBuffer>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QDebug>
+
+namespace {
+
+QByteArray pngIcon() {
+    static QByteArray png;
+    if (png.isEmpty()) {
+        QImage image(32, 32, QImage::Format_ARGB32);
+        image.fill(Qt::darkCyan);
+        QBuffer buffer(&png);
+        buffer.open(QIODevice::WriteOnly);
+        image.save(&buffer, "PNG");
+    }
+    return png;
+}
+
+// A 64-bit ELF header without sections, so that the squashfs of the AppImage would start right after it
+QByteArray elfHeader() {
+    QByteArray header(64, '\0');
+    header[0] = 0x7f;
+    header[1] = 'E';
+    header[2] = 'L';
+    header[3] = 'F';
+    header[4] = 2;     // ELFCLASS64
+    header[5] = 1;     // ELFDATA2LSB
+    header[6] = 1;     // EV_CURRENT
+    header[8] = 'A';   // AppImage type 2 magic
+    header[9] = 'I';
+    header[10] = 2;
+    header[16] = 2;    // ET_EXEC
+    header[18] = 62;   // EM_X86_64
+    header[20] = 1;    // e_version
+    header[40] = 64;   // e_shoff
+    header[52] = 64;   // e_ehsize
+    header[58] = 64;   // e_shentsize
+    return header;
+}
+
+QByteArray desktopEntry(int i) {
+    return QString("[Desktop Entry]\nType=Application\nName=Application %1\nExec=application%1 %F\n"
+                   "Icon=application-x-executable\nTerminal=false\n").arg(i).toUtf8();
+}
+
+}
+
+FixtureTree::FixtureTree(const QString& scratchFolder) : m_dir(scratchFolder + "/filer-bench-XXXXXX") {
+    if (!m_dir.isValid()) {
+        qWarning() << "Cannot create a scratch folder in" << scratchFolder;
+    }
+}
+
+void FixtureTree::addOptions(QCommandLineParser& parser, const QString& itemsDescription, int items,
+                             const QString& iterationsDescription, int iterations) {
+    parser.addOptions({
+        {"dir", "Scratch folder for the fixture (default: /dev/shm).", "path", defaultScratchFolder()},
+        {"items", itemsDescription, "count", QString::number(items)},
+        {"iterations", iterationsDescription, "count", QString::number(iterations)},
+    });
+}
+
+FixtureTree::Options FixtureTree::options(const QCommandLineParser& parser, int minimumItems) {
+    Options options;
+    options.dir = parser.value("dir");
+    options.items = qMax(minimumItems, parser.value("items").toInt());
+    options.iterations = qMax(1, parser.value("iterations").toInt());
+    return options;
+}
+
+QString FixtureTree::name(Kind kind) {
+    switch (kind) {
+    case AppDirs:
+        return "appdir";
+    case AppBundles:
+        return "app-bundle";
+    case AppImages:
+        return "appimage";
+    case DesktopFiles:
+        return "desktop-file";
+    case PlainFiles:
+        return "plain-file";
+    case DeepTree:
+        return "deep-tree";
+    }
+    return QString();
+}
+
+QList<FixtureTree::Kind> FixtureTree::kinds() {
+    return {AppDirs, AppBundles, AppImages, DesktopFiles, PlainFiles, DeepTree};
+}
+
+QString FixtureTree::defaultScratchFolder() {
+    // tmpfs keeps the storage out of the measurement
+    if (QFileInfo("/dev/shm").isDir() && QFileInfo("/dev/shm").isWritable()) {
+        return "/dev/shm";
+    }
+    return QDir::tempPath();
+}
+
+bool FixtureTree::writeFile(const QString& path, const QByteArray& contents, bool executable) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(contents) != contents.size()) {
+        qWarning() << "Cannot create" << path;
+        return false;
+    }
+    if (executable) {
+        file.setPermissions(file.permissions() | QFile::ExeOwner | QFile::ExeGroup | QFile::ExeOther);
+    }
+    return true;
+}
+
+QStringList FixtureTree::create(Kind kind, int count) {
+    m_folder = m_dir.filePath(QString("%1-%2").arg(name(kind)).arg(m_folders++));
+    if (!QDir().mkpath(m_folder)) {
+        qWarning() << "Cannot create" << m_folder;
+        return QStringList();
+    }
+
+    // A few MIME types, so that lookups by type do not all hit the same entry
+    static const char* const suffixes[] = {"txt", "pdf", "png", "html", "tar.gz", "odt"};
+    static const char* const headers[] = {"Text\n", "%PDF-1.4\n", "\x89PNG\r\n\x1a\n", "<!DOCTYPE html>\n",
+                                          "\x1f\x8b\x08", "PK\x03\x04"};
+
+    QStringList paths;
+    for (int i = 0; i < count; i++) {
+        QString path;
+        bool ok = true;
+        switch (kind) {
+        case AppDirs: {
+            path = m_folder + QString("/Application%1.AppDir").arg(i);
+            ok = QDir().mkpath(path)
+                 && writeFile(path + "/AppRun", "#!/bin/sh\nexit 0\n", true)
+                 && writeFile(path + "/.DirIcon", pngIcon())
+                 && writeFile(path + QString("/application%1.desktop").arg(i), desktopEntry(i));
+            break;
+        }
+        case AppBundles: {
+            QString bundleName = QString("Application%1").arg(i);
+            path = m_folder + "/" + bundleName + ".app";
+            ok = QDir().mkpath(path + "/Resources")
+                 && writeFile(path + "/" + bundleName, "#!/bin/sh\nexit 0\n", true)
+                 && writeFile(path + "/Resources/" + bundleName + ".png", pngIcon());
+            break;
+        }
+        case AppImages:
+            path = m_folder + QString("/Application%1.AppImage").arg(i);
+            ok = writeFile(path, elfHeader() + QByteArray(4096, '\0'), true);
+            break;
+        case DesktopFiles:
+            path = m_folder + QString("/application%1.desktop").arg(i);
+            ok = writeFile(path, desktopEntry(i));
+            break;
+        case PlainFiles: {
+            int type = i % (sizeof(suffixes) / sizeof(suffixes[0]));
+            path = m_folder + QString("/document%1.%2").arg(i).arg(suffixes[type]);
+            ok = writeFile(path, QByteArray(headers[type]) + QByteArray(256, 'x'));
+            break;
+        }
+        case DeepTree: {
+            // Every level holds a file and the next level
+            QString level = m_folder;
+            for (int depth = 0; depth <= i; depth++) {
+                level += QString("/level%1").arg(depth);
+            }
+            path = level + "/file.txt";
+            ok = QDir().mkpath(level) && writeFile(path, "Text\n");
+            break;
+        }
+        }
+        if (!ok) {
+            return QStringList();
+        }
+        paths << path;
+    }
+    return paths;
+}
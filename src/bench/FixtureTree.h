@@ -0,0 +1,85 @@
+#ifndef FIXTURETREE_H
+#define FIXTURETREE_H
+
+#include <QStringList>
+#include <QTemporaryDir>
+
+class QCommandLineParser;
+
+/**
+ * @file FixtureTree.h
+ * @class FixtureTree
+ * @brief Creates synthetic items of the kinds that Filer treats specially in a scratch folder.
+ *
+ * Each call to create() makes a folder of its own holding the items, so that a benchmark can
+ * list or sort one kind at a time. The scratch folder is removed when the tree is destroyed.
+ */
+class FixtureTree {
+public:
+    enum Kind {
+        AppDirs,      /**< Folders with an executable AppRun, a .DirIcon and a .desktop file. */
+        AppBundles,   /**< Name.app folders with an executable Name and Resources/Name.png. */
+        AppImages,    /**< Name.AppImage files holding an ELF header only, without a squashfs. */
+        DesktopFiles, /**< Application .desktop files. */
+        PlainFiles,   /**< Small documents of a few MIME types. */
+        DeepTree      /**< A chain of nested folders, each holding a few files. */
+    };
+
+    /**
+     * @brief The options that the benchmarks on a fixture have in common.
+     */
+    struct Options {
+        QString dir;        /**< The scratch folder. */
+        int items = 0;
+        int iterations = 0;
+    };
+
+    /**
+     * @brief Adds the options --dir, --items and --iterations to parser.
+     */
+    static void addOptions(QCommandLineParser& parser, const QString& itemsDescription, int items,
+                           const QString& iterationsDescription, int iterations);
+
+    /**
+     * @brief Returns the options added by addOptions() from a processed parser.
+     */
+    static Options options(const QCommandLineParser& parser, int minimumItems = 1);
+
+    /**
+     * @param scratchFolder The folder in which the tree is created, preferably on tmpfs; a warning
+     * is printed if it cannot be created there.
+     */
+    explicit FixtureTree(const QString& scratchFolder);
+
+    bool isValid() const { return m_dir.isValid(); }
+
+    /**
+     * @brief Creates items of one kind.
+     * @param count The number of items; for DeepTree, the depth.
+     * @return The paths of the items, or an empty list if they could not be created. For DeepTree,
+     * the files at every level.
+     */
+    QStringList create(Kind kind, int count);
+
+    /**
+     * @brief Returns the folder that holds the items created by the last call to create().
+     */
+    QString folder() const { return m_folder; }
+
+    static QString name(Kind kind);
+    static QList<Kind> kinds();
+
+    /**
+     * @brief Returns /dev/shm if it is writable, so that the storage is not measured, or else the temporary folder.
+     */
+    static QString defaultScratchFolder();
+
+private:
+    bool writeFile(const QString& path, const QByteArray& contents, bool executable = false);
+
+    QTemporaryDir m_dir;
+    QString m_folder;
+    int m_folders = 0;
+};
+
+#endif // FIXTURETREE_H
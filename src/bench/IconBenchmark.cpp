@@ -0,0 +1,48 @@
+#include "IconBenchmark.h"
+#include "BenchmarkReport.h"
+#include "FixtureTree.h"
+#include "CustomFileSystemModel.h"
+#include "CustomFileIconProvider.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QEvent>
+
+int runIconBenchmark(const QStringList& arguments) {
+    QCommandLineParser parser;
+    FixtureTree::addOptions(parser, "Number of items of each kind.", 500, "Number of timed runs per kind.", 5);
+    parser.addOption({"size", "Size in pixels at which each icon is rendered.", "pixels", "32"});
+    parser.process(QStringList() << "filer-bench icon" << arguments);
+    FixtureTree::Options options = FixtureTree::options(parser);
+    int size = qMax(1, parser.value("size").toInt());
+
+    FixtureTree tree(options.dir);
+    if (!tree.isValid()) {
+        return 1;
+    }
+
+    CustomFileSystemModel* model = CustomFileSystemModel::acquire();
+    CustomFileIconProvider* provider = model->customIconProvider();
+
+    int exitCode = 0;
+    for (FixtureTree::Kind kind : FixtureTree::kinds()) {
+        if (kind == FixtureTree::DeepTree) {
+            continue;
+        }
+        QStringList paths = tree.create(kind, options.items);
+        if (paths.isEmpty()) {
+            exitCode = 1;
+            break;
+        }
+
+        QJsonObject result = BenchmarkReport::measure(paths, options.iterations, "null_icons", [&](const QString& path) {
+            return provider->icon(QFileInfo(path)).pixmap(size, size).isNull();
+        });
+        result.insert("kind", FixtureTree::name(kind));
+        result.insert("size", size);
+        BenchmarkReport::print("icon", result);
+    }
+
+    CustomFileSystemModel::release(model);
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    return exitCode;
+}
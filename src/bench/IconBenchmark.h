@@ -0,0 +1,19 @@
+#ifndef ICONBENCHMARK_H
+#define ICONBENCHMARK_H
+
+#include <QStringList>
+
+/**
+ * @file IconBenchmark.h
+ * @brief Measures CustomFileIconProvider::icon() for each kind of item.
+ *
+ * Uses the icon provider of the shared CustomFileSystemModel, as the views do, so that the
+ * "open-with" lookups for plain files are included. Every icon is also rendered at the size
+ * of the icon view, because QIcon loads its pixmaps lazily.
+ *
+ * @param arguments The command line arguments following the name of the benchmark.
+ * @return The exit code.
+ */
+int runIconBenchmark(const QStringList& arguments);
+
+#endif // ICONBENCHMARK_H
@@ -0,0 +1,35 @@
+#include "LaunchDBBenchmark.h"
+#include "BenchmarkReport.h"
+#include "FixtureTree.h"
+#include "LaunchDB.h"
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+
+int runLaunchDBBenchmark(const QStringList& arguments) {
+    QCommandLineParser parser;
+    FixtureTree::addOptions(parser, "Number of documents to look up.", 1000, "Number of timed runs.", 5);
+    parser.process(QStringList() << "filer-bench launchdb" << arguments);
+    FixtureTree::Options options = FixtureTree::options(parser);
+
+    FixtureTree tree(options.dir);
+    if (!tree.isValid()) {
+        return 1;
+    }
+    QStringList paths = tree.create(FixtureTree::PlainFiles, options.items);
+    if (paths.isEmpty()) {
+        return 1;
+    }
+
+    // Constructing the database is part of what a cold lookup costs, so it is reported on its own
+    QElapsedTimer constructionTimer;
+    constructionTimer.start();
+    LaunchDB launchDB;
+    double constructionSeconds = constructionTimer.nsecsElapsed() / 1e9;
+
+    QJsonObject result = BenchmarkReport::measure(paths, options.iterations, "applications_found", [&](const QString& path) {
+        return !launchDB.applicationForFile(QFileInfo(path)).isEmpty();
+    });
+    result.insert("construction_seconds", constructionSeconds);
+    BenchmarkReport::print("launchdb", result);
+    return 0;
+}
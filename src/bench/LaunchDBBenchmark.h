@@ -0,0 +1,18 @@
+#ifndef LAUNCHDBBENCHMARK_H
+#define LAUNCHDBBENCHMARK_H
+
+#include <QStringList>
+
+/**
+ * @file LaunchDBBenchmark.h
+ * @brief Measures LaunchDB::applicationForFile() for documents of a few MIME types.
+ *
+ * The result depends on the launch database of the user running the benchmark; the number
+ * of documents for which an application was found is reported along with the timing.
+ *
+ * @param arguments The command line arguments following the name of the benchmark.
+ * @return The exit code.
+ */
+int runLaunchDBBenchmark(const QStringList& arguments);
+
+#endif // LAUNCHDBBENCHMARK_H
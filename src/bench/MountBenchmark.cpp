@@ -0,0 +1,97 @@
+#include "MountBenchmark.h"
+#include "BenchmarkReport.h"
+#include "Mountpoints.h"
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QStorageInfo>
+#include <QDebug>
+
+namespace {
+
+// What Mountpoints::isMountpoint() used to do for every call
+bool isMountpointByEnumerating(const QString& path) {
+    QFileInfo fileInfo(path);
+
+    QStringList mountpoints;
+    for (const QStorageInfo& storage : QStorageInfo::mountedVolumes()) {
+        mountpoints << storage.rootPath();
+    }
+
+    QString absoluteFilePathWithSymlinksResolved = fileInfo.absoluteFilePath();
+    if (fileInfo.isSymLink()) {
+        absoluteFilePathWithSymlinksResolved = fileInfo.symLinkTarget();
+    }
+    return mountpoints.contains(absoluteFilePathWithSymlinksResolved);
+}
+
+QJsonObject measure(const QStringList& paths, int calls, int iterations, bool (*isMountpoint)(const QString&),
+                    int& mountpointsFound) {
+    QVector<double> seconds;
+    for (int i = 0; i < iterations; i++) {
+        mountpointsFound = 0;
+        QElapsedTimer timer;
+        timer.start();
+        for (int call = 0; call < calls; call++) {
+            if (isMountpoint(paths.at(call % paths.size()))) {
+                mountpointsFound++;
+            }
+        }
+        seconds << timer.nsecsElapsed() / 1e9;
+    }
+    QJsonObject result = BenchmarkReport::timing(seconds);
+    result.insert("calls", calls);
+    result.insert("nanoseconds_per_call", result.value("median_seconds").toDouble() * 1e9 / calls);
+    return result;
+}
+
+}
+
+int runMountBenchmark(const QStringList& arguments) {
+    QCommandLineParser parser;
+    parser.addOptions({
+        {"calls", "Number of calls per timed run of the cached lookup.", "count", "1000000"},
+        {"legacy-calls", "Number of calls per timed run of the enumeration.", "count", "1000"},
+        {"iterations", "Number of timed runs per approach.", "count", "5"},
+        {"path", "Path to ask for; may be given more than once (default: a mix of typical paths).", "path"},
+    });
+    parser.process(QStringList() << "filer-bench mount" << arguments);
+
+    QStringList paths = parser.values("path");
+    if (paths.isEmpty()) {
+        paths << "/" << QDir::homePath() << QDir::homePath() + "/Desktop" << QDir::tempPath()
+              << "/etc/hosts" << QDir::homePath() + "/does-not-exist";
+        for (const QStorageInfo& storage : QStorageInfo::mountedVolumes()) {
+            if (storage.rootPath() != "/") {
+                paths << storage.rootPath();
+                break;
+            }
+        }
+    }
+    int iterations = qMax(1, parser.value("iterations").toInt());
+
+    int legacyFound = 0;
+    int cachedFound = 0;
+    QJsonObject legacy = measure(paths, qMax(1, parser.value("legacy-calls").toInt()), iterations,
+                                 isMountpointByEnumerating, legacyFound);
+    QJsonObject cached = measure(paths, qMax(1, parser.value("calls").toInt()), iterations,
+                                 Mountpoints::isMountpoint, cachedFound);
+
+    legacy.insert("approach", "enumerate");
+    legacy.insert("paths", paths.size());
+    BenchmarkReport::print("mount", legacy);
+    cached.insert("approach", "cached");
+    cached.insert("paths", paths.size());
+    cached.insert("speedup", legacy.value("nanoseconds_per_call").toDouble()
+                             / cached.value("nanoseconds_per_call").toDouble());
+    BenchmarkReport::print("mount", cached);
+
+    // Both approaches must agree on which paths are mount points
+    for (const QString& path : qAsConst(paths)) {
+        if (isMountpointByEnumerating(path) != Mountpoints::isMountpoint(path)) {
+            qWarning() << "The approaches disagree about" << path;
+            return 1;
+        }
+    }
+    return 0;
+}
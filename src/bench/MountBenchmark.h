@@ -0,0 +1,18 @@
+#ifndef MOUNTBENCHMARK_H
+#define MOUNTBENCHMARK_H
+
+#include <QStringList>
+
+/**
+ * @file MountBenchmark.h
+ * @brief Measures Mountpoints::isMountpoint() against enumerating the mounted volumes on every call.
+ *
+ * Asks for a mix of mount points, ordinary directories, files and missing paths, as the icon
+ * provider and the sorting of the Desktop do, and reports the time per call for both approaches.
+ *
+ * @param arguments The command line arguments following the name of the benchmark.
+ * @return The exit code.
+ */
+int runMountBenchmark(const QStringList& arguments);
+
+#endif // MOUNTBENCHMARK_H
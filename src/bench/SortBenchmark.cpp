@@ -0,0 +1,95 @@
+#include "SortBenchmark.h"
+#include "BenchmarkReport.h"
+#include "FixtureTree.h"
+#include "CustomFileSystemModel.h"
+#include "CustomProxyModel.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QDebug>
+
+namespace {
+
+constexpr int LoadTimeout = 120000; // Milliseconds
+
+// directoryLoaded() is emitted when the listing is complete, but the rows are inserted in batches afterwards
+bool waitForRows(CustomFileSystemModel* model, const QString& folder, int rows, double& seconds) {
+    QElapsedTimer timer;
+    timer.start();
+    model->loadDirectory(folder);
+    while (model->rowCount(model->index(folder)) < rows || !model->isDirectoryLoaded(folder)) {
+        if (timer.elapsed() > LoadTimeout) {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 50);
+    }
+    seconds = timer.nsecsElapsed() / 1e9;
+    return true;
+}
+
+}
+
+int runSortBenchmark(const QStringList& arguments) {
+    QCommandLineParser parser;
+    FixtureTree::addOptions(parser, "Number of items in the folder.", 10000, "Number of timed sorts.", 6);
+    parser.addOptions({
+        {"kind", "Kind of the items: appdir, app-bundle, appimage, desktop-file or plain-file.", "kind", "plain-file"},
+        {"role", "Role to sort by: decoration, as Filer does, or display.", "role", "decoration"},
+    });
+    parser.process(QStringList() << "filer-bench sort" << arguments);
+    FixtureTree::Options options = FixtureTree::options(parser);
+    int items = options.items;
+    bool byDecoration = (parser.value("role") != "display");
+
+    FixtureTree::Kind kind = FixtureTree::PlainFiles;
+    bool kindFound = false;
+    for (FixtureTree::Kind candidate : FixtureTree::kinds()) {
+        if (FixtureTree::name(candidate) == parser.value("kind") && candidate != FixtureTree::DeepTree) {
+            kind = candidate;
+            kindFound = true;
+        }
+    }
+    if (!kindFound) {
+        qWarning() << "Unknown kind" << parser.value("kind");
+        return 1;
+    }
+
+    FixtureTree tree(options.dir);
+    if (!tree.isValid()) {
+        return 1;
+    }
+    if (tree.create(kind, items).isEmpty()) {
+        return 1;
+    }
+
+    CustomFileSystemModel* model = CustomFileSystemModel::acquire();
+    int exitCode = 0;
+    double loadSeconds = 0.0;
+    if (!waitForRows(model, tree.folder(), items, loadSeconds)) {
+        qWarning() << "Timed out loading" << tree.folder();
+        exitCode = 1;
+    } else {
+        CustomProxyModel proxyModel;
+        proxyModel.setSourceModel(model);
+        proxyModel.setDynamicSortFilter(false);
+        proxyModel.setSortCaseSensitivity(Qt::CaseInsensitive);
+        proxyModel.setSortRole(byDecoration ? Qt::DecorationRole : Qt::DisplayRole);
+        // Build the mapping of the folder before the first timed sort
+        proxyModel.rowCount(proxyModel.mapFromSource(model->index(tree.folder())));
+
+        QVector<double> seconds = BenchmarkReport::repeat(options.iterations, [&](int i) {
+            proxyModel.sort(0, i % 2 ? Qt::DescendingOrder : Qt::AscendingOrder);
+        });
+
+        QJsonObject result = BenchmarkReport::timingPerItem(seconds, items);
+        result.insert("kind", FixtureTree::name(kind));
+        result.insert("role", byDecoration ? "decoration" : "display");
+        result.insert("load_seconds", loadSeconds);
+        BenchmarkReport::print("sort", result);
+    }
+
+    CustomFileSystemModel::release(model);
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    return exitCode;
+}
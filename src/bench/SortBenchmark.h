@@ -0,0 +1,23 @@
+#ifndef SORTBENCHMARK_H
+#define SORTBENCHMARK_H
+
+#include <QStringList>
+
+/**
+ * @file SortBenchmark.h
+ * @brief Measures how long CustomProxyModel takes to sort a loaded folder.
+ *
+ * Loads a folder of items of one kind into the shared CustomFileSystemModel and sorts it
+ * through a CustomProxyModel configured like the one of FileManagerMainWindow, which sorts
+ * by Qt::DecorationRole, alternating the order so that every run has to move rows. With
+ * --role display, the names are compared instead for reference.
+ *
+ * @note CustomProxyModel compares the more expensive way only on the Desktop; the fixture
+ * is not placed there, so that the Desktop of the user running the benchmark is left alone.
+ *
+ * @param arguments The command line arguments following the name of the benchmark.
+ * @return The exit code.
+ */
+int runSortBenchmark(const QStringList& arguments);
+
+#endif // SORTBENCHMARK_H
@@ -0,0 +1,263 @@
+#include "WindowBenchmark.h"
+#include "BenchmarkReport.h"
+#include "FixtureTree.h"
+#include "FileManagerMainWindow.h"
+#include "CustomFileSystemModel.h"
+#include "DirectorySnapshot.h"
+#include <QAbstractItemView>
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QHash>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <QDebug>
+#include <sys/resource.h>
+#include <dlfcn.h>
+
+namespace {
+
+constexpr int PollInterval = 20; // Milliseconds
+constexpr int SettleTimeout = 600000; // Milliseconds
+
+// /proc/self/io only counts reads and writes; the calls that listing a folder makes are counted
+// by libfiler.so if it is preloaded
+const char* const CountedCalls[] = {"stat", "lstat", "statx", "open", "getdents", "readdir", "getxattr"};
+
+using SyscallCount = quint64 (*)(const char*);
+const SyscallCount syscallCount = reinterpret_cast<SyscallCount>(dlsym(RTLD_DEFAULT, "filer_syscalls_count"));
+
+struct ProcessCounters {
+    qint64 readCalls = 0;
+    qint64 writeCalls = 0;
+    long voluntarySwitches = 0;
+    long involuntarySwitches = 0;
+    QHash<QString, qint64> systemCalls; /**< By the names of CountedCalls; empty without libfiler.so. */
+};
+
+// Counted for all threads, because most of the work happens outside the GUI thread
+ProcessCounters readCounters() {
+    ProcessCounters counters;
+    QFile io("/proc/self/io");
+    if (io.open(QIODevice::ReadOnly)) {
+        for (const QByteArray& line : io.readAll().split('\n')) {
+            if (line.startsWith("syscr:")) {
+                counters.readCalls = line.mid(6).trimmed().toLongLong();
+            } else if (line.startsWith("syscw:")) {
+                counters.writeCalls = line.mid(6).trimmed().toLongLong();
+            }
+        }
+    }
+    struct rusage usage = {};
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        counters.voluntarySwitches = usage.ru_nvcsw;
+        counters.involuntarySwitches = usage.ru_nivcsw;
+    }
+    if (syscallCount) {
+        for (const char* call : CountedCalls) {
+            counters.systemCalls.insert(call, static_cast<qint64>(syscallCount(call)));
+        }
+    }
+    return counters;
+}
+
+// Writing 5 to clear_refs resets the peak of the resident set size (Linux 4.0 and later)
+bool resetPeakRss() {
+    QFile clearRefs("/proc/self/clear_refs");
+    return clearRefs.open(QIODevice::WriteOnly) && clearRefs.write("5") == 1;
+}
+
+qint64 peakRssKib() {
+    QFile status("/proc/self/status");
+    if (status.open(QIODevice::ReadOnly)) {
+        for (const QByteArray& line : status.readAll().split('\n')) {
+            if (line.startsWith("VmHWM:")) {
+                return line.mid(6).trimmed().split(' ').first().toLongLong();
+            }
+        }
+    }
+    // The peak of the whole process; in kilobytes on Linux and FreeBSD
+    struct rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/*
+ * Records when frames that show items have been painted, and when the window last changed.
+ * Frames are timed once the paint event and the rest of the update have been processed.
+ */
+class WindowRecorder : public QObject {
+public:
+    WindowRecorder(QWidget* window, const QElapsedTimer& clock) : m_window(window), m_clock(clock) { }
+
+    bool eventFilter(QObject* watched, QEvent* event) override {
+        if (event->type() == QEvent::Paint && watched->isWidgetType() && showsItems(static_cast<QWidget*>(watched))) {
+            QMetaObject::invokeMethod(this, [this]() {
+                qint64 now = m_clock.nsecsElapsed();
+                if (firstPaint < 0) {
+                    firstPaint = now;
+                }
+                lastPaint = now;
+                lastChange = now;
+                paints++;
+            }, Qt::QueuedConnection);
+        }
+        return false;
+    }
+
+    void changed() { lastChange = m_clock.nsecsElapsed(); }
+
+    qint64 firstPaint = -1;
+    qint64 lastPaint = -1;
+    qint64 lastChange = 0;
+    int paints = 0;
+
+private:
+    // The viewport of one of the item views of the window, including the snapshot view
+    bool showsItems(QWidget* widget) const {
+        QAbstractItemView* view = qobject_cast<QAbstractItemView*>(widget->parentWidget());
+        return view && view->viewport() == widget && m_window->isAncestorOf(view) && view->model()
+               && view->model()->rowCount(view->rootIndex()) > 0;
+    }
+
+    QWidget* m_window;
+    const QElapsedTimer& m_clock;
+};
+
+QJsonObject openWindow(const QString& folder, int items, int quietPeriod, bool& settled) {
+    DirectorySnapshot snapshot(folder);
+    bool hadSnapshot = snapshot.load() && !snapshot.isEmpty();
+    bool peakRssReset = resetPeakRss();
+    ProcessCounters before = readCounters();
+
+    QElapsedTimer clock;
+    clock.start();
+
+    // Without an initial directory, the window does not become the desktop
+    FileManagerMainWindow* window = new FileManagerMainWindow(nullptr, QString());
+    WindowRecorder recorder(window, clock);
+    qApp->installEventFilter(&recorder);
+
+    CustomFileSystemModel* model = window->m_fileSystemModel;
+    QSortFilterProxyModel* proxyModel = window->m_proxyModel;
+    qint64 loaded = -1;
+    QObject::connect(model, &QFileSystemModel::directoryLoaded, &recorder, [&](const QString& path) {
+        if (path == folder && loaded < 0) {
+            loaded = clock.nsecsElapsed();
+        }
+    });
+    QObject::connect(proxyModel, &QAbstractItemModel::rowsInserted, &recorder, [&]() { recorder.changed(); });
+    QObject::connect(proxyModel, &QAbstractItemModel::dataChanged, &recorder, [&]() { recorder.changed(); });
+    QObject::connect(proxyModel, &QAbstractItemModel::layoutChanged, &recorder, [&]() { recorder.changed(); });
+
+    window->bindDirectory(folder);
+    window->show();
+    qint64 shown = clock.nsecsElapsed();
+
+    settled = false;
+    while (clock.elapsed() < SettleTimeout) {
+        QEventLoop loop;
+        QTimer::singleShot(PollInterval, &loop, &QEventLoop::quit);
+        loop.exec();
+
+        QModelIndex root = proxyModel->mapFromSource(model->index(folder));
+        bool complete = loaded >= 0 && recorder.firstPaint >= 0 && proxyModel->rowCount(root) >= items;
+        if (complete && clock.nsecsElapsed() - recorder.lastChange >= quietPeriod * 1000000LL) {
+            settled = true;
+            break;
+        }
+    }
+
+    ProcessCounters after = readCounters();
+    QJsonObject result;
+    result.insert("items", items);
+    result.insert("had_snapshot", hadSnapshot);
+    result.insert("window_seconds", shown / 1e9);
+    result.insert("first_paint_seconds", recorder.firstPaint / 1e9);
+    result.insert("loaded_seconds", loaded / 1e9);
+    result.insert("settled_seconds", settled ? recorder.lastPaint / 1e9 : -1.0);
+    result.insert("settled", settled);
+    result.insert("paints", recorder.paints);
+    result.insert("peak_rss_kib", peakRssKib());
+    result.insert("peak_rss_of_process", !peakRssReset);
+    result.insert("read_syscalls", after.readCalls - before.readCalls);
+    result.insert("write_syscalls", after.writeCalls - before.writeCalls);
+    result.insert("voluntary_context_switches", static_cast<double>(after.voluntarySwitches - before.voluntarySwitches));
+    result.insert("involuntary_context_switches", static_cast<double>(after.involuntarySwitches - before.involuntarySwitches));
+    result.insert("syscalls_counted", syscallCount != nullptr);
+    for (const char* call : CountedCalls) {
+        if (after.systemCalls.contains(call)) {
+            result.insert(QString("%1_syscalls").arg(call), after.systemCalls.value(call) - before.systemCalls.value(call));
+        }
+    }
+
+    qApp->removeEventFilter(&recorder);
+    // Saves the snapshot for the next opening and releases the model, which is destroyed with the window
+    window->close();
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+    DirectorySnapshot::waitForBackgroundSaves();
+    return result;
+}
+
+}
+
+int runWindowBenchmark(const QStringList& arguments) {
+    QCommandLineParser parser;
+    parser.addOptions({
+        {"dir", "Scratch folder for the fixture (default: /dev/shm).", "path", FixtureTree::defaultScratchFolder()},
+        {"items", "Number of files in the folder; may be given more than once (default: 1000, 10000 and 100000).", "count"},
+        {"iterations", "Number of times each folder is opened.", "count", "3"},
+        {"quiet", "Milliseconds without changes after which the window counts as settled.", "ms", "500"},
+    });
+    parser.process(QStringList() << "filer-bench window" << arguments);
+
+    QList<int> sizes;
+    for (const QString& value : parser.values("items")) {
+        sizes << qMax(1, value.toInt());
+    }
+    if (sizes.isEmpty()) {
+        sizes << 1000 << 10000 << 100000;
+    }
+    int iterations = qMax(1, parser.value("iterations").toInt());
+    int quietPeriod = qMax(PollInterval, parser.value("quiet").toInt());
+
+    if (!syscallCount) {
+        qWarning() << "Preload libfiler.so to count the stat, getdents and getxattr calls of the window";
+    }
+
+    // The windows of the benchmark must not end it
+    qApp->setQuitOnLastWindowClosed(false);
+
+    FixtureTree tree(parser.value("dir"));
+    QTemporaryDir cache(parser.value("dir") + "/filer-bench-cache-XXXXXX");
+    if (!tree.isValid()) {
+        return 1;
+    }
+    if (!cache.isValid()) {
+        qWarning() << "Cannot create a scratch folder in" << parser.value("dir");
+        return 1;
+    }
+    // Keep the snapshots of the fixture out of the cache of the user
+    qputenv("XDG_CACHE_HOME", QFile::encodeName(cache.path()));
+
+    for (int items : qAsConst(sizes)) {
+        if (tree.create(FixtureTree::PlainFiles, items).isEmpty()) {
+            return 1;
+        }
+        for (int i = 0; i < iterations; i++) {
+            bool settled = false;
+            QJsonObject result = openWindow(tree.folder(), items, quietPeriod, settled);
+            result.insert("iteration", i);
+            result.insert("quiet_milliseconds", quietPeriod);
+            BenchmarkReport::print("window", result);
+            if (!settled) {
+                qWarning() << "The window on" << items << "items did not settle";
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
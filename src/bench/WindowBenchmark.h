@@ -0,0 +1,28 @@
+#ifndef WINDOWBENCHMARK_H
+#define WINDOWBENCHMARK_H
+
+#include <QStringList>
+
+/**
+ * @file WindowBenchmark.h
+ * @brief Measures how long a FileManagerMainWindow takes to show a large folder, as the user sees it.
+ *
+ * Opens a window on folders of 1k, 10k and 100k files and reports, per opening:
+ *
+ * - first_paint_seconds: until the first frame that shows items has been painted
+ * - loaded_seconds: until the model has listed the folder
+ * - settled_seconds: until the last frame before the window stops changing, that is, before
+ *   neither the model nor the view changed for the quiet period; by then every visible
+ *   icon is final
+ * - peak_rss_kib: the peak resident set size while the window was opened
+ * - read_syscalls, write_syscalls and the context switches of the whole process
+ *
+ * The first opening of each folder starts without a snapshot; later ones show the snapshot
+ * that the previous window saved, as Filer does when a folder is opened again.
+ *
+ * @param arguments The command line arguments following the name of the benchmark.
+ * @return The exit code.
+ */
+int runWindowBenchmark(const QStringList& arguments);
+
+#endif // WINDOWBENCHMARK_H
@@ -0,0 +1,55 @@
+#include "XattrBenchmark.h"
+#include "BenchmarkReport.h"
+#include "FixtureTree.h"
+#include "ExtendedAttributes.h"
+#include <QCommandLineParser>
+#include <QDebug>
+
+namespace {
+
+QJsonObject measure(const QStringList& paths, int iterations) {
+    return BenchmarkReport::measure(paths, iterations, "attributes_found", [](const QString& path) {
+        return !ExtendedAttributes(path).read("open-with").isEmpty();
+    });
+}
+
+}
+
+int runXattrBenchmark(const QStringList& arguments) {
+    QCommandLineParser parser;
+    FixtureTree::addOptions(parser, "Number of files to read from; half of them get the attribute.", 200,
+                            "Number of timed runs.", 3);
+    parser.process(QStringList() << "filer-bench xattr" << arguments);
+    FixtureTree::Options options = FixtureTree::options(parser, 2);
+
+    FixtureTree tree(options.dir);
+    if (!tree.isValid()) {
+        return 1;
+    }
+    QStringList paths = tree.create(FixtureTree::PlainFiles, options.items);
+    if (paths.isEmpty()) {
+        return 1;
+    }
+
+    QStringList withAttribute = paths.mid(0, options.items / 2);
+    QStringList withoutAttribute = paths.mid(options.items / 2);
+    for (const QString& path : qAsConst(withAttribute)) {
+        ExtendedAttributes(path).write("open-with", "/Applications/TextEdit.app");
+    }
+
+    QJsonObject hits = measure(withAttribute, options.iterations);
+    bool supported = (hits.value("attributes_found").toInt() > 0);
+    hits.insert("files", "with-attribute");
+    hits.insert("supported", supported);
+    BenchmarkReport::print("xattr", hits);
+
+    QJsonObject misses = measure(withoutAttribute, options.iterations);
+    misses.insert("files", "without-attribute");
+    misses.insert("supported", supported);
+    BenchmarkReport::print("xattr", misses);
+
+    if (!supported) {
+        qWarning() << "Extended attributes seem to be unsupported in" << options.dir;
+    }
+    return 0;
+}
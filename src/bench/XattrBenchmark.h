@@ -0,0 +1,20 @@
+#ifndef XATTRBENCHMARK_H
+#define XATTRBENCHMARK_H
+
+#include <QStringList>
+
+/**
+ * @file XattrBenchmark.h
+ * @brief Measures ExtendedAttributes::read() on files that have the attribute and files that do not.
+ *
+ * Half of the files get an "open-with" attribute first, as Filer stores it. If the scratch
+ * folder does not support extended attributes (tmpfs before Linux 6.6 does not support the
+ * "user" namespace), the result says so and only the misses are meaningful; point --dir at
+ * another file system in that case.
+ *
+ * @param arguments The command line arguments following the name of the benchmark.
+ * @return The exit code.
+ */
+int runXattrBenchmark(const QStringList& arguments);
+
+#endif // XATTRBENCHMARK_H
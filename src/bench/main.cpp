@@ -0,0 +1,85 @@
+#include <QApplication>
+#include <QLoggingCategory>
+#include <QStringList>
+#include <stdio.h>
+#include "BundleBenchmark.h"
+#include "CopyBenchmark.h"
+#include "IconBenchmark.h"
+#include "LaunchDBBenchmark.h"
+#include "MountBenchmark.h"
+#include "MountMonitor.h"
+#include "SortBenchmark.h"
+#include "TrashIndex.h"
+#include "WindowBenchmark.h"
+#include "XattrBenchmark.h"
+
+/*
+ * filer-bench runs micro- and macro-benchmarks for Filer and fileoperation.
+ *
+ * Usage: filer-bench [benchmark [options]]
+ *
+ * Without arguments, all benchmarks run with their default options. Results are printed
+ * to standard output as one JSON object per line; diagnostics go to standard error.
+ * Benchmarks that need a GUI run on the offscreen platform unless QT_QPA_PLATFORM is set.
+ * FILER_VFS_LATENCY and FILER_VFS_BANDWIDTH run them against simulated slow media; see LatencyVfs.h.
+ */
+
+struct Benchmark {
+    const char* name;
+    int (*run)(const QStringList& arguments);
+};
+
+static const Benchmark benchmarks[] = {
+    {"bundle", runBundleBenchmark},
+    {"icon", runIconBenchmark},
+    {"launchdb", runLaunchDBBenchmark},
+    {"xattr", runXattrBenchmark},
+    {"sort", runSortBenchmark},
+    {"window", runWindowBenchmark},
+    {"mount", runMountBenchmark},
+    {"copy", runCopyBenchmark},
+    {"copy-thread", runCopyThreadBenchmark},
+};
+
+int main(int argc, char *argv[]) {
+    // Icons and models need a QApplication, but no display
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    // The code under measurement logs every item at debug level, which would dominate the timings
+    if (!qEnvironmentVariableIsSet("QT_LOGGING_RULES")) {
+        QLoggingCategory::setFilterRules("*.debug=false");
+    }
+
+    // As in Filer, created on this thread before any code under measurement asks them from others
+    MountMonitor::create();
+    TrashIndex::create();
+
+    QStringList arguments = app.arguments().mid(1);
+
+    if (arguments.isEmpty()) {
+        for (const Benchmark& benchmark : benchmarks) {
+            int result = benchmark.run(QStringList());
+            if (result != 0) {
+                return result;
+            }
+        }
+        return 0;
+    }
+
+    QString name = arguments.takeFirst();
+    for (const Benchmark& benchmark : benchmarks) {
+        if (name == QLatin1String(benchmark.name)) {
+            return benchmark.run(arguments);
+        }
+    }
+
+    fprintf(stderr, "Usage: filer-bench [benchmark [options]]\nBenchmarks:");
+    for (const Benchmark& benchmark : benchmarks) {
+        fprintf(stderr, " %s", benchmark.name);
+    }
+    fprintf(stderr, "\n");
+    return 1;
+}
@@ -0,0 +1,98 @@
+#include "CopyBackend.h"
+#include "SyncCopyBackend.h"
+#include "UringCopyBackend.h"
+#include "HashPipeline.h"
+#include "Vfs.h"
+#include <QDebug>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+std::unique_ptr<CopyBackend> CopyBackend::create(const QString& preferred) {
+    QString name = preferred;
+    if (name.isEmpty()) {
+        name = qEnvironmentVariable("FILEOPERATION_COPY_BACKEND");
+    }
+
+    // Requests in flight on the ring would not go through the Vfs
+    if (name != QLatin1String("sync") && Vfs::instance()->isSimulated()) {
+        qDebug() << "CopyBackend: Simulated file system, using synchronous copying";
+        name = QStringLiteral("sync");
+    }
+
+    if (name != QLatin1String("sync")) {
+#ifdef HAVE_LIBURING
+        if (UringCopyBackend::isSupported()) {
+            std::unique_ptr<UringCopyBackend> backend(new UringCopyBackend);
+            if (backend->isValid()) {
+                return backend;
+            }
+        }
+#endif
+        if (!name.isEmpty()) {
+            qDebug() << "CopyBackend:" << name << "is not available, falling back to synchronous copying";
+        }
+    }
+    return std::unique_ptr<CopyBackend>(new SyncCopyBackend);
+}
+
+qint64 CopyBackend::truncateForResume(int targetFd, qint64 resumeOffset) {
+    struct stat targetStat;
+    if (resumeOffset > 0 && (::fstat(targetFd, &targetStat) != 0 || targetStat.st_size < resumeOffset)) {
+        qDebug() << "CopyBackend: Partial target is shorter than expected, copying from the start";
+        resumeOffset = 0;
+    }
+    if (::ftruncate(targetFd, resumeOffset) == 0) {
+        return resumeOffset;
+    }
+    int error = errno;
+    if (resumeOffset > 0) {
+        qDebug() << "CopyBackend: Cannot cut the partial target back, copying from the start:" << strerror(error);
+        if (::ftruncate(targetFd, 0) == 0) {
+            return 0;
+        }
+        error = errno;
+    }
+    errno = error;
+    return -1;
+}
+
+qint64 CopyBackend::nextDataRange(int fd, qint64 offset, qint64 size, qint64* dataEnd) {
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+    off_t dataStart = ::lseek(fd, offset, SEEK_DATA);
+    if (dataStart < 0) {
+        // ENXIO means that there is no data beyond offset; on other errors, copy everything
+        *dataEnd = size;
+        return errno == ENXIO ? size : offset;
+    }
+    off_t holeStart = ::lseek(fd, dataStart, SEEK_HOLE);
+    *dataEnd = holeStart < 0 ? size : qMin<qint64>(holeStart, size);
+    return qMin<qint64>(dataStart, size);
+#else
+    Q_UNUSED(fd);
+    *dataEnd = size;
+    return offset;
+#endif
+}
+
+void CopyBackend::skipHole(int index, qint64 from, qint64 to, CopyObserver* observer) {
+    if (m_hashPipeline) {
+        for (qint64 offset = from; offset < to; offset += HashPipeline::BlockSize) {
+            m_hashPipeline->submitZeros(index, offset, qMin(HashPipeline::BlockSize, to - offset));
+        }
+    }
+    observer->bytesCopied(to - from);
+}
+
+bool CopyBackend::flushTarget(int targetFd, qint64 completeUpTo) {
+    // The synced offset must not be recorded unless the target really reaches it
+    struct stat targetStat;
+    if (::fstat(targetFd, &targetStat) != 0) {
+        return false;
+    }
+    if (targetStat.st_size < completeUpTo && ::ftruncate(targetFd, completeUpTo) != 0) {
+        return false;
+    }
+    return ::fdatasync(targetFd) == 0;
+}
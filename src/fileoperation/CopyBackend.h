@@ -0,0 +1,159 @@
+#ifndef COPYBACKEND_H
+#define COPYBACKEND_H
+
+#include <QString>
+#include <QVector>
+#include <memory>
+
+class HashPipeline;
+
+/**
+ * @brief A regular file whose contents are to be copied.
+ */
+struct FileCopyRequest {
+    QString sourcePath;
+    QString targetPath;
+    qint64 size;
+    qint64 resumeOffset = 0; /**< Continue a partial target that is known to be good up to here. */
+};
+
+/**
+ * @file CopyBackend.h
+ * @class CopyObserver
+ * @brief Receives progress from a CopyBackend and tells it whether to go on.
+ * @note The methods are called on the thread that runs the backend.
+ */
+class CopyObserver {
+public:
+    virtual ~CopyObserver() = default;
+
+    /**
+     * @brief Called regularly; may block while the operation is paused.
+     * @return false if the backend should stop as soon as possible.
+     */
+    virtual bool shouldContinue() = 0;
+
+    virtual void fileStarted(int index) = 0;
+    virtual void bytesCopied(qint64 bytes) = 0;
+
+    /**
+     * @brief Called when a partial target is continued instead of being copied from the start.
+     * @param bytes The number of bytes that were already in the target.
+     */
+    virtual void bytesSkipped(qint64 bytes) = 0;
+
+    /**
+     * @brief Called after the target has been flushed to the disk up to the given offset.
+     * @note Only called if a sync interval is set.
+     */
+    virtual void fileSynced(int index, qint64 offset) = 0;
+
+    /**
+     * @brief Called when a file has been copied completely.
+     * @param hash The hash of the data that was read from the source; empty unless a hash pipeline is set.
+     */
+    virtual void fileFinished(int index, const QByteArray& hash) = 0;
+};
+
+/**
+ * @class CopyBackend
+ * @brief Copies the contents of regular files.
+ *
+ * The engine that copies the data is chosen at runtime: an io_uring based engine that keeps many
+ * reads and writes in flight across files where the kernel supports it, and a synchronous
+ * read/write engine everywhere else.
+ */
+class CopyBackend {
+public:
+    virtual ~CopyBackend() = default;
+
+    /**
+     * @brief Returns the name of the backend, e.g., "sync" or "io_uring".
+     */
+    virtual QString name() const = 0;
+
+    /**
+     * @brief Copies the contents and permissions of the given files; the target folders must exist.
+     * @return false if an error occurred or the observer asked to stop. In case of an error,
+     * errorString() describes it; if the observer asked to stop, errorString() is empty.
+     */
+    virtual bool copyFiles(const QVector<FileCopyRequest>& files, CopyObserver* observer) = 0;
+
+    QString errorString() const { return m_errorString; }
+
+    /**
+     * @brief Flushes targets to the disk every time this many bytes have been written to them.
+     *
+     * Targets are also flushed before they are reported as finished, so that a journal never
+     * records a file as copied while its data may still be lost.
+     * @param bytes The interval; 0 disables flushing, which is the default.
+     */
+    void setSyncInterval(qint64 bytes) { m_syncInterval = bytes; }
+
+    /**
+     * @brief Keeps partially written targets on errors and interruptions so that they can be continued.
+     */
+    void setKeepPartialFiles(bool keep) { m_keepPartialFiles = keep; }
+
+    /**
+     * @brief Hashes the data while it is being copied, in the same pass.
+     * @param pipeline The pipeline to hash with, or nullptr to disable hashing, which is the default.
+     * Files are identified by their index; partial targets are not continued while hashing.
+     */
+    void setHashPipeline(HashPipeline* pipeline) { m_hashPipeline = pipeline; }
+
+    /**
+     * @brief Creates the best backend that works on this system.
+     * @param preferred The name of the backend to use if it is available; if empty,
+     * the environment variable FILEOPERATION_COPY_BACKEND is consulted.
+     */
+    static std::unique_ptr<CopyBackend> create(const QString& preferred = QString());
+
+protected:
+    /**
+     * @brief Cuts an opened target back to the offset from which copying continues.
+     * @param targetFd The target, opened for writing without truncating it.
+     * @param resumeOffset The last offset known to be good, or 0.
+     * @return The offset from which to copy; 0 if the target is shorter than expected or cannot be
+     * cut back to resumeOffset, and -1 with errno set if it cannot be emptied either.
+     */
+    static qint64 truncateForResume(int targetFd, qint64 resumeOffset);
+
+    /**
+     * @brief Returns whether a file has fewer blocks allocated than its size needs, so that it may have holes.
+     * @param blocks The number of 512-byte blocks allocated to the file.
+     */
+    static bool isSparse(qint64 size, qint64 blocks) { return blocks * 512 < size; }
+
+    /**
+     * @brief Finds the next range of a file that holds data.
+     * @param fd The file.
+     * @param offset Where to start looking.
+     * @param size The size of the file.
+     * @param dataEnd Set to the end of the range.
+     * @return The start of the range, or size if there is no more data.
+     */
+    static qint64 nextDataRange(int fd, qint64 offset, qint64 size, qint64* dataEnd);
+
+    /**
+     * @brief Accounts for a range of the source that is a hole and is not written to the target.
+     *
+     * The range counts as copied for the progress, which is measured in logical bytes, and is hashed as zeros.
+     */
+    void skipHole(int index, qint64 from, qint64 to, CopyObserver* observer);
+
+    /**
+     * @brief Flushes a target to the disk.
+     * @param completeUpTo The target is extended to at least this size first, so that a
+     * hole that has not been written yet is there when the copy is continued later.
+     * @return false if extending or flushing failed; the offset must not be recorded as synced then.
+     */
+    static bool flushTarget(int targetFd, qint64 completeUpTo);
+
+    QString m_errorString;
+    qint64 m_syncInterval = 0;
+    bool m_keepPartialFiles = false;
+    HashPipeline* m_hashPipeline = nullptr;
+};
+
+#endif // COPYBACKEND_H
@@ -0,0 +1,215 @@
+#include "CopyJournal.h"
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QDebug>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+CopyJournal::~CopyJournal() {
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+}
+
+QString CopyJournal::journalFolder() {
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/fileoperation/journals";
+}
+
+QString CopyJournal::newJournalPath() {
+    QDir folder(journalFolder());
+    folder.mkpath(".");
+
+    // Journals of copies that were never resumed would pile up otherwise
+    QDateTime oldest = QDateTime::currentDateTime().addDays(-MaxAgeDays);
+    QDirIterator it(folder.path(), QStringList() << "*.journal", QDir::Files);
+    while (it.hasNext()) {
+        it.next();
+        if (it.fileInfo().lastModified() < oldest) {
+            qDebug() << "CopyJournal: Removing stale journal" << it.filePath();
+            QFile::remove(it.filePath());
+        }
+    }
+
+    static int counter = 0;
+    return folder.filePath(QString("%1-%2-%3.journal")
+                                   .arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"))
+                                   .arg(QCoreApplication::applicationPid())
+                                   .arg(++counter));
+}
+
+bool CopyJournal::create(const QString& path, const QString& operation, const QStringList& sourcePaths,
+                         const QString& targetPath) {
+    m_fd = ::open(QFile::encodeName(path).constData(), O_WRONLY | O_CREAT | O_EXCL | O_APPEND | O_CLOEXEC, 0600);
+    if (m_fd < 0) {
+        qDebug() << "CopyJournal: Cannot create" << path << strerror(errno);
+        return false;
+    }
+    m_path = path;
+    m_operation = operation;
+    m_sourcePaths = sourcePaths;
+    m_targetPath = targetPath;
+
+    QByteArray header;
+    QDataStream stream(&header, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << Magic << Version << operation << sourcePaths << targetPath;
+    return append(header);
+}
+
+bool CopyJournal::load(const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "CopyJournal: Cannot read" << path;
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version;
+    if (magic != Magic || version != Version) {
+        qDebug() << "CopyJournal:" << path << "is not a journal";
+        return false;
+    }
+    stream >> m_operation >> m_sourcePaths >> m_targetPath;
+    if (stream.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    // Read records until the end; a torn record at the end is cut off before appending to the journal
+    qint64 validSize = file.pos();
+    while (!stream.atEnd()) {
+        quint8 type = 0;
+        stream >> type;
+        if (type == PlanRecord) {
+            qint32 count = 0;
+            stream >> count;
+            QVector<CopyEntry> plan;
+            plan.reserve(qBound(0, count, 1 << 20));
+            for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++) {
+                quint8 kind = 0;
+                CopyEntry entry;
+                stream >> kind >> entry.sourcePath >> entry.targetPath >> entry.size >> entry.modified;
+                entry.kind = static_cast<CopyEntry::Kind>(kind);
+                plan.append(entry);
+            }
+            if (stream.status() != QDataStream::Ok) {
+                break;
+            }
+            m_plan = plan;
+            m_hasPlan = true;
+        } else if (type == CompletionRecord) {
+            qint32 index = 0;
+            Completion completion;
+            stream >> index >> completion.size >> completion.modified >> completion.hash;
+            if (stream.status() != QDataStream::Ok) {
+                break;
+            }
+            m_completions.insert(index, completion);
+        } else if (type == OffsetRecord) {
+            qint32 index = 0;
+            qint64 offset = 0;
+            stream >> index >> offset;
+            if (stream.status() != QDataStream::Ok) {
+                break;
+            }
+            m_syncedOffsets.insert(index, offset);
+        } else {
+            break;
+        }
+        validSize = file.pos();
+    }
+    file.close();
+
+    if (validSize < QFileInfo(path).size()) {
+        qDebug() << "CopyJournal: Ignoring the incomplete record at the end of" << path;
+    }
+
+    m_fd = ::open(QFile::encodeName(path).constData(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (m_fd < 0 || ::ftruncate(m_fd, validSize) != 0) {
+        qDebug() << "CopyJournal: Cannot open" << path << "for writing";
+        return false;
+    }
+    m_path = path;
+    return true;
+}
+
+const CopyJournal::Completion* CopyJournal::completion(int index) const {
+    auto it = m_completions.constFind(index);
+    return it == m_completions.constEnd() ? nullptr : &it.value();
+}
+
+void CopyJournal::writePlan(const QVector<CopyEntry>& plan) {
+    QByteArray record;
+    QDataStream stream(&record, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << static_cast<quint8>(PlanRecord) << static_cast<qint32>(plan.size());
+    for (const CopyEntry& entry : plan) {
+        stream << static_cast<quint8>(entry.kind) << entry.sourcePath << entry.targetPath << entry.size << entry.modified;
+    }
+    if (append(record)) {
+        m_plan = plan;
+        m_hasPlan = true;
+    }
+}
+
+void CopyJournal::writeCompletion(int index, const Completion& completion) {
+    QByteArray record;
+    QDataStream stream(&record, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << static_cast<quint8>(CompletionRecord) << static_cast<qint32>(index)
+           << completion.size << completion.modified << completion.hash;
+    append(record);
+}
+
+void CopyJournal::writeSyncedOffset(int index, qint64 offset) {
+    QByteArray record;
+    QDataStream stream(&record, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << static_cast<quint8>(OffsetRecord) << static_cast<qint32>(index) << offset;
+    // The data the record refers to has just been flushed; make the record durable as well
+    if (append(record)) {
+        ::fdatasync(m_fd);
+    }
+}
+
+void CopyJournal::remove() {
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    if (!m_path.isEmpty()) {
+        QFile::remove(m_path);
+    }
+}
+
+// Writes a whole record with a single write() so that a crash leaves at most one torn record
+bool CopyJournal::append(const QByteArray& record) {
+    if (m_fd < 0) {
+        return false;
+    }
+    const char* data = record.constData();
+    qint64 remaining = record.size();
+    while (remaining > 0) {
+        ssize_t written = ::write(m_fd, data, remaining);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0) {
+            qDebug() << "CopyJournal: Cannot write to" << m_path << strerror(errno);
+            return false;
+        }
+        data += written;
+        remaining -= written;
+    }
+    return true;
+}
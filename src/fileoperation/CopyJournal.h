@@ -0,0 +1,132 @@
+#ifndef COPYJOURNAL_H
+#define COPYJOURNAL_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @brief One entry of a copy plan.
+ */
+struct CopyEntry {
+    enum Kind {
+        File,
+        Directory,
+        SymLink,
+        Special /**< A socket, FIFO or device node; recreated from the type and device number of the source. */
+    };
+    Kind kind;
+    QString sourcePath;
+    QString targetPath;
+    qint64 size;
+    qint64 modified; /**< Modification time of the source in milliseconds since the epoch. */
+};
+
+/**
+ * @file CopyJournal.h
+ * @class CopyJournal
+ * @brief Append-only on-disk record of the progress of a copy, so that it can be resumed.
+ *
+ * The journal starts with the operation and its paths, followed by the copy plan. While the copy
+ * is running, a record is appended for each file that has been copied completely, and for each
+ * time a partial target has been flushed to the disk. A record that was cut short by a crash is
+ * ignored when the journal is read back.
+ *
+ * The journal is written by the worker thread only; it does not use QObject-based file I/O.
+ */
+class CopyJournal {
+public:
+    /**
+     * @brief What the journal knows about a file that was copied completely.
+     */
+    struct Completion {
+        qint64 size;
+        qint64 modified;
+        QByteArray hash; /**< Hash of the contents if it was computed while copying, otherwise empty. */
+    };
+
+    CopyJournal() = default;
+    ~CopyJournal();
+    CopyJournal(const CopyJournal&) = delete;
+    CopyJournal& operator=(const CopyJournal&) = delete;
+
+    /**
+     * @brief Returns the folder that holds the journals, ~/.cache/fileoperation/journals.
+     */
+    static QString journalFolder();
+
+    /**
+     * @brief Returns a path for a new journal and removes journals that have been lying around for a long time.
+     */
+    static QString newJournalPath();
+
+    /**
+     * @brief Creates a new journal.
+     * @param operation "copy" or "move".
+     * @return false if the journal could not be written.
+     */
+    bool create(const QString& path, const QString& operation, const QStringList& sourcePaths, const QString& targetPath);
+
+    /**
+     * @brief Reads an existing journal and opens it for appending.
+     * @return false if the file is not a readable journal.
+     */
+    bool load(const QString& path);
+
+    QString path() const { return m_path; }
+    QString operation() const { return m_operation; }
+    QStringList sourcePaths() const { return m_sourcePaths; }
+    QString targetPath() const { return m_targetPath; }
+
+    bool hasPlan() const { return m_hasPlan; }
+    const QVector<CopyEntry>& plan() const { return m_plan; }
+
+    /**
+     * @brief Returns the completion record of the plan entry with the given index, or nullptr.
+     */
+    const Completion* completion(int index) const;
+
+    /**
+     * @brief Returns the offset up to which the target of the given plan entry is known to be on the disk.
+     */
+    qint64 syncedOffset(int index) const { return m_syncedOffsets.value(index, 0); }
+
+    /**
+     * @brief Whether files listed as completed are confirmed by their contents rather than by size and modification time.
+     */
+    bool verifiesCompletedFiles() const { return m_verifyCompleted; }
+    void setVerifiesCompletedFiles(bool verify) { m_verifyCompleted = verify; }
+
+    void writePlan(const QVector<CopyEntry>& plan);
+    void writeCompletion(int index, const Completion& completion);
+    void writeSyncedOffset(int index, qint64 offset);
+
+    /**
+     * @brief Closes and deletes the journal, e.g., because the copy has finished.
+     */
+    void remove();
+
+private:
+    enum RecordType : quint8 { PlanRecord = 1, CompletionRecord = 2, OffsetRecord = 3 };
+
+    static const quint32 Magic = 0x464f4a31; // "FOJ1"
+    static const quint32 Version = 1;
+    static const int MaxAgeDays = 30;
+
+    bool append(const QByteArray& record);
+
+    int m_fd = -1;
+    QString m_path;
+    QString m_operation;
+    QStringList m_sourcePaths;
+    QString m_targetPath;
+    bool m_hasPlan = false;
+    bool m_verifyCompleted = false;
+    QVector<CopyEntry> m_plan;
+    QHash<int, Completion> m_completions;
+    QHash<int, qint64> m_syncedOffsets;
+};
+
+#endif // COPYJOURNAL_H
@@ -2,195 +2,425 @@
 #include <QFile>
 #include <QDir>
 #include <QDebug>
-#include <QDirIterator>
 #include <QProcess>
+#include <QDateTime>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "FileTreeWalker.h"
+#include "Trace.h"
+
+// Partial targets are flushed to the disk and recorded in the journal this often
+static const qint64 JournalSyncInterval = 64 * 1024 * 1024;
+
+// Sockets, FIFOs and device nodes cannot be copied by reading them; creates a node of the same kind
+static bool recreateSpecialFile(const CopyEntry& entry) {
+    struct stat sourceStat;
+    if (::lstat(QFile::encodeName(entry.sourcePath).constData(), &sourceStat) != 0) {
+        return false;
+    }
+    QByteArray target = QFile::encodeName(entry.targetPath);
+    mode_t mode = sourceStat.st_mode & (S_IFMT | 07777);
+    int result = S_ISFIFO(mode) ? ::mkfifoat(AT_FDCWD, target.constData(), mode & 07777)
+                                : ::mknodat(AT_FDCWD, target.constData(), mode, sourceStat.st_rdev);
+    if (result != 0) {
+        // Device nodes can only be created by root
+        qDebug() << "CopyThread: Cannot recreate" << entry.sourcePath << ":" << strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+CopyThread::CopyThread(const QStringList& fromPaths, const QString& toPath, ProgressTelemetry* telemetry,
+                       CopyJournal* journal, QObject* parent)
+        : OperationThread(telemetry, parent), fromPaths(fromPaths), toPath(toPath), m_journal(journal) {
 
-CopyThread::CopyThread(const QStringList& fromPaths, const QString& toPath, QObject* parent)
-        : QThread(parent), fromPaths(fromPaths), toPath(toPath) {
-    connect(this, &CopyThread::cancelCopyRequested, this, &CopyThread::requestInterruption);
 }
 
 void CopyThread::run() {
-    qint64 totalSize = calculateTotalSize();
-    qint64 copiedSize = 0;
+    if (m_verifyTargets) {
+        m_hashPipeline.reset(new HashPipeline);
+    }
+
+    qint64 totalSize = 0;
+    bool resuming = m_journal && m_journal->hasPlan();
+    if (resuming) {
+        qDebug() << "CopyThread: Resuming from" << m_journal->path();
+        m_plan = m_journal->plan();
+        for (const CopyEntry& entry : m_plan) {
+            totalSize += entry.size;
+        }
+    } else {
+        if (!buildPlan(m_plan, totalSize)) {
+            return;
+        }
+        if (m_journal) {
+            m_journal->writePlan(m_plan);
+        }
+    }
+
+    // Hand only the files that still need to be copied to the backend
+    QVector<FileCopyRequest> files;
+    QStringList plannedFiles;
+    qint64 skippedSize = 0;
+    qint64 copySize = 0;
+    for (int i = 0; i < m_plan.size(); i++) {
+        const CopyEntry& entry = m_plan.at(i);
+        if (entry.kind != CopyEntry::File) {
+            continue;
+        }
+        if (resuming && isCompleted(i, entry)) {
+            skippedSize += entry.size;
+            continue;
+        }
+        FileCopyRequest request{entry.sourcePath, entry.targetPath, entry.size};
+        if (resuming && isUnchanged(entry)) {
+            request.resumeOffset = m_journal->syncedOffset(i);
+        }
+        files.append(request);
+        plannedFiles << entry.sourcePath;
+        m_planIndexes.append(i);
+        copySize += entry.size;
+    }
+    m_hashes.resize(files.size());
+    // Reading the targets back takes about as long as copying them
+    m_telemetry->setPlan(plannedFiles, m_verifyTargets ? totalSize + copySize : totalSize);
+    if (skippedSize > 0) {
+        qDebug() << "CopyThread: Skipping" << skippedSize << "bytes that were copied before";
+        m_telemetry->skipBytes(skippedSize);
+    }
+
+    // Create the folders and links first so that the backend can copy the files in any order
+    qint64 linksStarted = Trace::now();
+    QStringList notRecreated;
+    for (const CopyEntry& entry : qAsConst(m_plan)) {
+        if (!checkpoint()) {
+            qDebug() << "CopyThread: Interruption requested. Exiting...";
+            return;
+        }
+
+        switch (entry.kind) {
+        case CopyEntry::Directory:
+            qDebug() << "Creating target subdirectory" << entry.targetPath;
+            if (!QDir(entry.targetPath).mkpath(".")) {
+                emit error(tr("Cannot create the target subdirectory."));
+                return;
+            }
+            break;
+        case CopyEntry::SymLink:
+            if (resuming && QFileInfo(entry.targetPath).isSymLink()) {
+                break;
+            }
+            // We must not write into the symlink target, so we only recreate the link
+            if (!QFile::link(QFileInfo(entry.sourcePath).symLinkTarget(), entry.targetPath)) {
+                emit error(tr("Failed to copy symbolic link."));
+                return;
+            }
+            break;
+        case CopyEntry::Special: {
+            struct stat targetStat;
+            if (resuming && ::lstat(QFile::encodeName(entry.targetPath).constData(), &targetStat) == 0) {
+                break;
+            }
+            if (!recreateSpecialFile(entry)) {
+                notRecreated << entry.sourcePath;
+            }
+            break;
+        }
+        case CopyEntry::File:
+            break;
+        }
+    }
+    FILER_TRACE_COMPLETE("copy-create-directories", linksStarted);
+
+    std::unique_ptr<CopyBackend> backend = CopyBackend::create();
+    if (m_journal) {
+        backend->setSyncInterval(JournalSyncInterval);
+        backend->setKeepPartialFiles(true);
+    }
+    backend->setHashPipeline(m_hashPipeline.get());
+    qDebug() << "CopyThread: Copying" << files.size() << "files with the" << backend->name() << "backend";
+    bool copied;
+    {
+        FILER_TRACE_SCOPE("copy-files");
+        copied = backend->copyFiles(files, this);
+    }
+    if (!copied) {
+        if (!backend->errorString().isEmpty()) {
+            emit error(backend->errorString());
+        }
+        return;
+    }
+    if (m_verifyTargets && !verifyTargets(files)) {
+        return;
+    }
+    // Failing keeps the sources of a move, which would otherwise be deleted with these files
+    if (!notRecreated.isEmpty()) {
+        emit error(tr("These special files could not be recreated at the destination:\n%1").arg(notRecreated.join("\n")));
+        return;
+    }
+
+    m_telemetry->finish();
+    emit operationFinished();
+
+    // Touch the parent directory so that the file manager updates the view
+    // after the whole copy operation is completely finished and bundles have their contents;
+    // otherwise, the file manager will show a normal directory icon instead of
+    // a bundle icon because at the time when the directory was created, it was empty
+    // and the file manager at that time didn't know that it was a bundle.
+    QProcess p;
+    p.start("touch", QStringList() << toPath);
+    p.waitForFinished(-1);
+}
+
+/**
+ * @brief Adds the contents of a source directory to the plan, parents before their children.
+ */
+class PlanVisitor : public FileTreeVisitor {
+public:
+    PlanVisitor(const QString& sourceRoot, const QString& targetRoot, QVector<CopyEntry>& plan, qint64& totalSize)
+            : m_sourceRoot(QDir::cleanPath(sourceRoot)), m_targetRoot(targetRoot), m_plan(plan), m_totalSize(totalSize) {
+    }
+
+    Action enter(const FileTreeEntry& entry) override {
+        // The directory itself is already in the plan
+        if (entry.depth == 0) {
+            return Continue;
+        }
+        QString sourcePath = entry.filePath();
+        QString targetPath = m_targetRoot + sourcePath.mid(m_sourceRoot.size());
+
+        switch (entry.type) {
+        case FileTreeEntry::SymLink:
+            m_plan.append({CopyEntry::SymLink, sourcePath, targetPath, 0, 0});
+            break;
+        case FileTreeEntry::Directory:
+            m_plan.append({CopyEntry::Directory, sourcePath, targetPath, 0, 0});
+            break;
+        case FileTreeEntry::File: {
+            qint64 modified = qint64(entry.stat.st_mtim.tv_sec) * 1000 + entry.stat.st_mtim.tv_nsec / 1000000;
+            m_plan.append({CopyEntry::File, sourcePath, targetPath, entry.stat.st_size, modified});
+            m_totalSize += entry.stat.st_size;
+            break;
+        }
+        case FileTreeEntry::Other:
+            m_plan.append({CopyEntry::Special, sourcePath, targetPath, 0, 0});
+            break;
+        }
+        return Continue;
+    }
+
+    Action failed(const QByteArray& path, int error) override {
+        qDebug() << "CopyThread: Cannot read" << path << ":" << strerror(error);
+        failedPath = QFile::decodeName(path);
+        return Stop;
+    }
+
+    QString failedPath;
+
+private:
+    const QString m_sourceRoot;
+    const QString m_targetRoot;
+    QVector<CopyEntry>& m_plan;
+    qint64& m_totalSize;
+};
+
+// Checks the source and target paths and lists everything that needs to be created at the target,
+// parents before their children
+bool CopyThread::buildPlan(QVector<CopyEntry>& plan, qint64& totalSize) {
+    FILER_TRACE_SCOPE("copy-plan");
+    QFileInfo toInfo(toPath);
+    QDir toDir(toPath);
 
     for (const QString& fromPath : fromPaths) {
         QFileInfo fromInfo(fromPath);
-        QFileInfo toInfo(toPath);
-        QDir toDir(toPath);
 
         // Check if source is readable
         if (!fromInfo.exists() || !fromInfo.isReadable()) {
             emit error(tr("Source path does not exist or is not accessible."));
-            return;
+            return false;
         }
 
         // Check if source is a directory
         if (toInfo.exists() && !toInfo.isDir()) {
             emit error(tr("Target path must be a directory."));
-            return;
+            return false;
         }
 
         // Check if destination is writable
         if (!toInfo.isWritable()) {
             emit error(tr("Target path is not writable."));
-            return;
+            return false;
         }
 
         // Check if destination is a subdirectory of the source
         if (toInfo.absoluteFilePath().startsWith(fromInfo.absoluteFilePath())) {
             emit error(tr("Target path is a subdirectory of the source."));
-            return;
+            return false;
         }
 
         // Check if destination already exists
-        QString toPath = toInfo.absoluteFilePath() + QDir::separator() + fromInfo.fileName();
-        if (QFileInfo(toPath).exists()) {
+        QString targetPath = toInfo.absoluteFilePath() + QDir::separator() + fromInfo.fileName();
+        if (QFileInfo(targetPath).exists()) {
             emit error(tr("Target already exists at the destination."));
-            return;
+            return false;
         }
 
         if (!toDir.exists() && !toDir.mkpath(".")) {
             qDebug() << "Creating target directory" << toDir.absolutePath();
             emit error(tr("Cannot create the target directory."));
-            return;
+            return false;
         }
 
-        // Handle symlinks
         if (fromInfo.isSymLink()) {
-            QString symlinkTarget = fromInfo.symLinkTarget();
-            if (!QFile::link(symlinkTarget, toPath)) {
-                emit error(tr("Failed to copy symbolic link."));
-                return;
-            } else {
-                // We must not write into the symlink target, so we skip it
-                continue;
-            }
-        }
-
-        QString toSubdir = toDir.filePath(fromInfo.fileName());
-        if (fromInfo.isDir()) {
-            qDebug() << "Creating target subdirectory" << toSubdir;
-            if (!toDir.mkpath(toSubdir)) {
-                emit error(tr("Cannot create the target subdirectory."));
-                return;
-            }
+            plan.append({CopyEntry::SymLink, fromPath, targetPath, 0, 0});
+            continue;
         }
 
         if (fromInfo.isFile()) {
-            QString toFilePath = toInfo.absoluteFilePath() + QDir::separator() + fromInfo.fileName();
+            plan.append({CopyEntry::File, fromPath, targetPath, fromInfo.size(), fromInfo.lastModified().toMSecsSinceEpoch()});
+            totalSize += fromInfo.size();
+            continue;
+        }
 
-            if (QFileInfo(toFilePath).exists()) {
-                emit error(tr("%1 already exists at the destination.").arg(fromInfo.fileName()));
-                return;
+        if (fromInfo.isDir()) {
+            plan.append({CopyEntry::Directory, fromPath, targetPath, 0, 0});
+
+            PlanVisitor visitor(fromInfo.absoluteFilePath(), targetPath, plan, totalSize);
+            FileTreeWalker walker(&visitor);
+            walker.setStatMode(FileTreeWalker::StatFiles);
+            if (!walker.walk(fromPath)) {
+                emit error(tr("Cannot read %1.").arg(visitor.failedPath.isEmpty() ? fromPath : visitor.failedPath));
+                return false;
             }
+            continue;
+        }
 
-            QFile sourceFile(fromPath);
-            QFile targetFile(toFilePath);
+        plan.append({CopyEntry::Special, fromPath, targetPath, 0, 0});
+    }
 
-            if (sourceFile.open(QIODevice::ReadOnly) && targetFile.open(QIODevice::WriteOnly)) {
-                char buffer[4096];
+    return true;
+}
 
-                while (qint64 bytesRead = sourceFile.read(buffer, sizeof(buffer))) {
-                    qint64 bytesWritten = targetFile.write(buffer, bytesRead);
-                    copiedSize += bytesWritten;
+// Reads the targets back from the disk, bypassing the page cache, and compares them with the
+// hashes of the sources that were taken while copying
+bool CopyThread::verifyTargets(const QVector<FileCopyRequest>& files) {
+    FILER_TRACE_SCOPE("copy-verify");
+    auto progress = [this](qint64 bytes) {
+        m_telemetry->addBytes(bytes);
+        return checkpoint();
+    };
+
+    for (int i = 0; i < files.size(); i++) {
+        if (!checkpoint()) {
+            qDebug() << "CopyThread: Interruption requested. Exiting...";
+            return false;
+        }
+        m_telemetry->beginFile(i);
+        QByteArray targetHash = m_hashPipeline->hashFile(files.at(i).targetPath, true, progress);
+        if (targetHash.isEmpty()) {
+            if (isInterruptionRequested()) {
+                return false;
+            }
+            emit error(tr("Cannot read %1 to verify it.").arg(files.at(i).targetPath));
+            return false;
+        }
+        if (targetHash != m_hashes.at(i)) {
+            qDebug() << "CopyThread: Hash mismatch" << files.at(i).targetPath << targetHash << m_hashes.at(i);
+            emit error(tr("%1 does not match its source after copying.").arg(files.at(i).targetPath));
+            return false;
+        }
+    }
+    qDebug() << "CopyThread: Verified" << files.size() << "files";
+    return true;
+}
 
-                    int percentage = static_cast<int>((copiedSize * 100) / totalSize);
-                    emit progress(percentage);
+// Returns whether the journal lists the plan entry as copied and the target can be trusted
+bool CopyThread::isCompleted(int index, const CopyEntry& entry) {
+    const CopyJournal::Completion* completion = m_journal->completion(index);
+    if (!completion) {
+        return false;
+    }
+    QFileInfo sourceInfo(entry.sourcePath);
+    QFileInfo targetInfo(entry.targetPath);
+    if (sourceInfo.size() != completion->size
+        || sourceInfo.lastModified().toMSecsSinceEpoch() != completion->modified
+        || !targetInfo.isFile() || targetInfo.size() != completion->size) {
+        return false;
+    }
+    // A move deletes the source afterwards, so the target must be known to be good even then
+    if (!m_journal->verifiesCompletedFiles() && !m_verifyTargets) {
+        return true;
+    }
 
-                    if (isInterruptionRequested()) {
-                        qDebug() << "CopyThread: Interruption requested. Cleaning up and exiting...";
-                        targetFile.remove();
-                        return;
-                    }
-                }
+    // If the source was hashed while it was copied, reading the target is enough
+    if (completion->hash.startsWith(HashPipeline::algorithm().toLatin1() + ":")) {
+        if (!m_hashPipeline) {
+            m_hashPipeline.reset(new HashPipeline);
+        }
+        return m_hashPipeline->hashFile(entry.targetPath, false, nullptr) == completion->hash;
+    }
+    return haveSameContents(entry.sourcePath, entry.targetPath);
+}
 
-                sourceFile.close();
-                targetFile.close();
+// Returns whether the source still is the file that the plan was made for
+bool CopyThread::isUnchanged(const CopyEntry& entry) {
+    QFileInfo sourceInfo(entry.sourcePath);
+    return sourceInfo.size() == entry.size && sourceInfo.lastModified().toMSecsSinceEpoch() == entry.modified;
+}
 
-                // Set permissions
-                targetFile.setPermissions(sourceFile.permissions());
-            }
-        } else if (fromInfo.isDir()) {
-            QDirIterator it(fromPath, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
-
-            while (it.hasNext()) {
-                it.next();
-                QString relativePath = it.filePath().mid(fromPath.size() + 1);
-                QString targetFilePath = toSubdir + QDir::separator() + relativePath;
-
-                if (it.fileInfo().isSymLink()) {
-                    // Handle symbolic link within subdirectory
-                    QString symlinkTarget = it.fileInfo().symLinkTarget();
-                    if (!QFile::link(symlinkTarget, targetFilePath)) {
-                        emit error(tr("Failed to copy symbolic link."));
-                        return;
-                    } else {
-                        // We must not write into the symlink target, so we skip it
-                        continue;
-                    }
-                } else if (QFileInfo(it.fileInfo()).isDir()) {
-                    QDir(targetFilePath).mkpath(".");
-                } else {
-                    QFile sourceFile(it.filePath());
-                    QFile targetFile(targetFilePath);
-
-                    if (sourceFile.open(QIODevice::ReadOnly) && targetFile.open(QIODevice::WriteOnly)) {
-                        char buffer[4096];
-
-                        while (qint64 bytesRead = sourceFile.read(buffer, sizeof(buffer))) {
-                            qint64 bytesWritten = targetFile.write(buffer, bytesRead);
-                            copiedSize += bytesWritten;
-
-                            int percentage = static_cast<int>((copiedSize * 100) / totalSize);
-                            emit progress(percentage);
-
-                            if (isInterruptionRequested()) {
-                                qDebug() << "CopyThread: Interruption requested. Cleaning up and exiting...";
-                                targetFile.remove();
-                                return;
-                            }
-                        }
-
-                        sourceFile.close();
-                        targetFile.close();
-
-                        // Set permissions
-                        targetFile.setPermissions(sourceFile.permissions());
-                    }
-                }
-            }
+bool CopyThread::haveSameContents(const QString& path1, const QString& path2) {
+    QFile file1(path1);
+    QFile file2(path2);
+    if (!file1.open(QIODevice::ReadOnly) || !file2.open(QIODevice::ReadOnly) || file1.size() != file2.size()) {
+        return false;
+    }
+    QByteArray buffer1(256 * 1024, Qt::Uninitialized);
+    QByteArray buffer2(256 * 1024, Qt::Uninitialized);
+    for (;;) {
+        qint64 bytesRead1 = file1.read(buffer1.data(), buffer1.size());
+        qint64 bytesRead2 = file2.read(buffer2.data(), buffer2.size());
+        if (bytesRead1 != bytesRead2 || bytesRead1 < 0) {
+            return false;
+        }
+        if (bytesRead1 == 0) {
+            return true;
+        }
+        if (memcmp(buffer1.constData(), buffer2.constData(), bytesRead1) != 0) {
+            return false;
         }
     }
+}
 
-    emit progress(100);
-    emit copyFinished();
+bool CopyThread::shouldContinue() {
+    return checkpoint();
+}
 
-    // Touch the parent directory so that the file manager updates the view
-    // after the whole copy operation is completely finished and bundles have their contents;
-    // otherwise, the file manager will show a normal directory icon instead of
-    // a bundle icon because at the time when the directory was created, it was empty
-    // and the file manager at that time didn't know that it was a bundle.
-    QProcess p;
-    p.start("touch", QStringList() << toPath);
-    p.waitForFinished(-1);
+void CopyThread::fileStarted(int index) {
+    m_telemetry->beginFile(index);
 }
 
-qint64 CopyThread::calculateTotalSize() {
-    qint64 totalSize = 0;
+void CopyThread::bytesCopied(qint64 bytes) {
+    m_telemetry->addBytes(bytes);
+}
 
-    for (const QString& fromPath : fromPaths) {
-        QFileInfo fromInfo(fromPath);
-        if (fromInfo.isFile()) {
-            totalSize += fromInfo.size();
-        } else if (fromInfo.isDir()) {
-            QDirIterator it(fromPath, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
-            while (it.hasNext()) {
-                it.next();
-                totalSize += QFileInfo(it.fileInfo()).size();
-            }
-        }
+void CopyThread::bytesSkipped(qint64 bytes) {
+    m_telemetry->skipBytes(bytes);
+}
+
+void CopyThread::fileSynced(int index, qint64 offset) {
+    if (m_journal) {
+        m_journal->writeSyncedOffset(m_planIndexes.at(index), offset);
     }
+}
 
-    return totalSize;
-}
\ No newline at end of file
+void CopyThread::fileFinished(int index, const QByteArray& hash) {
+    m_telemetry->finishFile();
+    m_hashes[index] = hash;
+    if (m_journal) {
+        int planIndex = m_planIndexes.at(index);
+        const CopyEntry& entry = m_plan.at(planIndex);
+        m_journal->writeCompletion(planIndex, {entry.size, entry.modified, hash});
+    }
+}
@@ -1,30 +1,64 @@
 #ifndef COPYTHREAD_H
 #define COPYTHREAD_H
 
-#include <QThread>
+#include <QStringList>
+#include <QVector>
+#include "OperationThread.h"
+#include "CopyBackend.h"
+#include "CopyJournal.h"
+#include "HashPipeline.h"
+#include <memory>
 
-class CopyThread : public QThread {
+class CopyThread : public OperationThread, private CopyObserver {
     Q_OBJECT
 
 public:
-    CopyThread(const QStringList& fromPaths, const QString& toPath, QObject* parent = nullptr);
+    /**
+     * @brief Constructs a CopyThread.
+     * @param journal Records the progress so that the copy can be resumed; may be nullptr. If the journal
+     * already holds a plan, the copy is resumed from it and fromPaths and toPath are not checked again.
+     * Must outlive the thread.
+     */
+    CopyThread(const QStringList& fromPaths, const QString& toPath, ProgressTelemetry* telemetry,
+               CopyJournal* journal = nullptr, QObject* parent = nullptr);
 
-    signals:
-        void progress(int value);
-        void copyFinished();
-        void cancelCopyRequested();
-        void error(const QString& errorMessage);
+    /**
+     * @brief Hashes the data while copying and afterwards checks the targets against the hashes
+     * by reading them back from the disk; the copy fails if they do not match.
+     *
+     * When a copy is resumed, a hash cannot continue where the partial target ends, so partial
+     * targets are copied again from the start. Targets that the journal lists as completed are
+     * read back and checked against their recorded hashes before they are skipped.
+     * @note Must be called before the thread is started.
+     */
+    void setVerifyTargets(bool verify) { m_verifyTargets = verify; }
 
 protected:
     void run() override;
 
 private:
-    qint64 calculateTotalSize();
-
-    const QStringList& fromPaths;
-    const QString& toPath;
+    bool buildPlan(QVector<CopyEntry>& plan, qint64& totalSize);
+    bool verifyTargets(const QVector<FileCopyRequest>& files);
+    bool isCompleted(int index, const CopyEntry& entry);
+    static bool isUnchanged(const CopyEntry& entry);
+    static bool haveSameContents(const QString& path1, const QString& path2);
 
+    // CopyObserver
+    bool shouldContinue() override;
+    void fileStarted(int index) override;
+    void bytesCopied(qint64 bytes) override;
+    void bytesSkipped(qint64 bytes) override;
+    void fileSynced(int index, qint64 offset) override;
+    void fileFinished(int index, const QByteArray& hash) override;
 
+    const QStringList fromPaths;
+    const QString toPath;
+    CopyJournal* m_journal;
+    QVector<int> m_planIndexes; /**< The plan entry of each file handed to the backend. */
+    QVector<CopyEntry> m_plan;
+    bool m_verifyTargets = false;
+    std::unique_ptr<HashPipeline> m_hashPipeline;
+    QVector<QByteArray> m_hashes; /**< Hash of the source of each file handed to the backend. */
 };
 
-#endif // COPYTHREAD_H
\ No newline at end of file
+#endif // COPYTHREAD_H
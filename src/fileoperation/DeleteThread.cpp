@@ -0,0 +1,157 @@
+#include "DeleteThread.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QDebug>
+#include <atomic>
+#include <functional>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "FileTreeWalker.h"
+
+// Directories near the top of a tree are handed to other threads down to this depth
+static const int SplitDepth = 2;
+
+// The walker threads check for pausing only this often, since checkpoint() takes a lock
+static const int CheckpointInterval = 256;
+
+/**
+ * @brief Counts the entries of a tree so that the deletion can report progress.
+ */
+class CountingVisitor : public FileTreeVisitor {
+public:
+    explicit CountingVisitor(QThread* thread) : m_thread(thread) {
+    }
+
+    Action enter(const FileTreeEntry& entry) override {
+        Q_UNUSED(entry);
+        count.fetch_add(1, std::memory_order_relaxed);
+        return m_thread->isInterruptionRequested() ? Stop : Continue;
+    }
+
+    Action failed(const QByteArray& path, int error) override {
+        // Reported by the deletion
+        Q_UNUSED(path);
+        Q_UNUSED(error);
+        return Continue;
+    }
+
+    std::atomic<int> count{0};
+
+private:
+    QThread* m_thread;
+};
+
+/**
+ * @brief Removes the entries of a tree with unlinkat(), children before their parents.
+ * @note Called from several walker threads at once.
+ */
+class DeletingVisitor : public FileTreeVisitor {
+public:
+    DeletingVisitor(ProgressTelemetry* telemetry, const std::function<bool()>& checkpoint)
+            : m_telemetry(telemetry), m_checkpoint(checkpoint) {
+    }
+
+    Action enter(const FileTreeEntry& entry) override {
+        if (m_entries.fetch_add(1, std::memory_order_relaxed) % CheckpointInterval == 0 && !m_checkpoint()) {
+            return Stop;
+        }
+        // The walker never descends into symlinks, so the directories they point to are left alone
+        if (entry.type == FileTreeEntry::Directory) {
+            return Continue;
+        }
+        return remove(entry, 0) ? Continue : Stop;
+    }
+
+    bool leave(const FileTreeEntry& entry) override {
+        return remove(entry, AT_REMOVEDIR);
+    }
+
+    Action failed(const QByteArray& path, int error) override {
+        qDebug() << "DeleteThread: Cannot read" << path << ":" << strerror(error);
+        setFailedPath(QFile::decodeName(path));
+        return Stop;
+    }
+
+    QString failedPath() const {
+        QMutexLocker locker(&m_mutex);
+        return m_failedPath;
+    }
+
+private:
+    bool remove(const FileTreeEntry& entry, int flags) {
+        if (unlinkat(entry.parentFd, entry.name, flags) != 0 && errno != ENOENT) {
+            qDebug() << "DeleteThread: Cannot remove" << entry.path() << ":" << strerror(errno);
+            setFailedPath(entry.filePath());
+            return false;
+        }
+        m_telemetry->finishFile();
+        return true;
+    }
+
+    void setFailedPath(const QString& path) {
+        QMutexLocker locker(&m_mutex);
+        if (m_failedPath.isEmpty()) {
+            m_failedPath = path;
+        }
+    }
+
+    ProgressTelemetry* m_telemetry;
+    std::function<bool()> m_checkpoint;
+    std::atomic<int> m_entries{0};
+    mutable QMutex m_mutex;
+    QString m_failedPath;
+};
+
+DeleteThread::DeleteThread(const QStringList& paths, ProgressTelemetry* telemetry, QObject* parent)
+        : OperationThread(telemetry, parent), paths(paths) {
+
+}
+
+void DeleteThread::run() {
+    int threadCount = qBound(1, QThread::idealThreadCount(), 8);
+
+    // Count everything that needs to be removed; this only reads the directories, since the
+    // types in the directory entries tell which of them to descend into
+    QStringList plan;
+    CountingVisitor counter(this);
+    for (const QString& path : paths) {
+        QFileInfo info(path);
+        if (!info.exists() && !info.isSymLink()) {
+            continue;
+        }
+        plan << path;
+        FileTreeWalker walker(&counter);
+        walker.setThreadCount(threadCount);
+        walker.setSplitDepth(SplitDepth);
+        walker.walk(path);
+        if (!checkpoint()) {
+            qDebug() << "DeleteThread: Interruption requested. Exiting...";
+            return;
+        }
+    }
+    m_telemetry->setPlan(plan, 0, counter.count.load());
+
+    DeletingVisitor visitor(m_telemetry, [this]() { return checkpoint(); });
+    for (int i = 0; i < plan.size(); i++) {
+        m_telemetry->beginFile(i);
+
+        FileTreeWalker walker(&visitor);
+        walker.setThreadCount(threadCount);
+        walker.setSplitDepth(SplitDepth);
+        if (!walker.walk(plan.at(i))) {
+            if (!checkpoint()) {
+                qDebug() << "DeleteThread: Interruption requested. Exiting...";
+                return;
+            }
+            QString failedPath = visitor.failedPath().isEmpty() ? plan.at(i) : visitor.failedPath();
+            emit error(tr("Failed to delete %1. Please check its permissions.").arg(failedPath));
+            return;
+        }
+    }
+
+    m_telemetry->finish();
+    emit operationFinished();
+}
@@ -0,0 +1,28 @@
+#ifndef DELETETHREAD_H
+#define DELETETHREAD_H
+
+#include <QStringList>
+#include "OperationThread.h"
+
+/**
+ * @file DeleteThread.h
+ * @class DeleteThread
+ * @brief Permanently deletes files and directory trees in a worker thread.
+ *
+ * Trees are removed with unlinkat() relative to their directories, and independent subtrees
+ * are removed by several threads in parallel.
+ */
+class DeleteThread : public OperationThread {
+    Q_OBJECT
+
+public:
+    DeleteThread(const QStringList& paths, ProgressTelemetry* telemetry, QObject* parent = nullptr);
+
+protected:
+    void run() override;
+
+private:
+    const QStringList paths;
+};
+
+#endif // DELETETHREAD_H
@@ -0,0 +1,88 @@
+#include "FileOperationService.h"
+#include "JobQueue.h"
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDebug>
+
+const QString FileOperationService::serviceName = QStringLiteral("org.helloSystem.FileOperation");
+const QString FileOperationService::objectPath = QStringLiteral("/org/helloSystem/FileOperation");
+
+FileOperationService::FileOperationService(JobQueue* queue, QObject* parent) : QObject(parent), m_queue(queue) {
+    connect(m_queue, &JobQueue::jobChanged, this, &FileOperationService::reportJob);
+
+    // Progress of running jobs is broadcast a few times per second; state changes are broadcast right away
+    m_reportTimer.setInterval(250);
+    connect(&m_reportTimer, &QTimer::timeout, this, &FileOperationService::reportRunningJobs);
+    m_reportTimer.start();
+}
+
+bool FileOperationService::registerService() {
+    QDBusConnection connection = QDBusConnection::sessionBus();
+    if (!connection.isConnected()) {
+        qWarning() << "FileOperationService: Not connected to the session bus";
+        return false;
+    }
+    if (!connection.registerObject(objectPath, this,
+                                   QDBusConnection::ExportScriptableContents)) {
+        qWarning() << "FileOperationService: Could not register" << objectPath;
+        return false;
+    }
+    if (!connection.registerService(serviceName)) {
+        qDebug() << "FileOperationService:" << serviceName << "is already running";
+        connection.unregisterObject(objectPath);
+        return false;
+    }
+    return true;
+}
+
+int FileOperationService::Copy(const QStringList& sourcePaths, const QString& targetPath) {
+    return m_queue->enqueue(JobQueue::Copy, sourcePaths, targetPath);
+}
+
+int FileOperationService::Move(const QStringList& sourcePaths, const QString& targetPath) {
+    return m_queue->enqueue(JobQueue::Move, sourcePaths, targetPath);
+}
+
+int FileOperationService::Delete(const QStringList& paths) {
+    return m_queue->enqueue(JobQueue::Delete, paths);
+}
+
+void FileOperationService::Pause(int id) {
+    m_queue->pause(id);
+}
+
+void FileOperationService::Resume(int id) {
+    m_queue->resume(id);
+}
+
+void FileOperationService::Cancel(int id) {
+    m_queue->cancel(id);
+}
+
+void FileOperationService::ReportJobs() {
+    for (int id : m_queue->jobIds()) {
+        reportJob(id);
+    }
+}
+
+void FileOperationService::reportJob(int id) {
+    const JobQueue::Job* job = m_queue->job(id);
+    if (!job) {
+        return;
+    }
+    static const char* const stateNames[] = {"queued", "running", "paused", "awaiting-confirmation", "finished", "failed", "canceled"};
+    static const char* const typeNames[] = {"copy", "move", "delete"};
+    const ProgressTelemetry* telemetry = job->telemetry.get();
+    emit JobChanged(id, QString::fromLatin1(typeNames[job->type]), QString::fromLatin1(stateNames[job->state]),
+                    job->targetPath, telemetry->bytesDone(), telemetry->totalBytes(),
+                    telemetry->filesDone(), telemetry->totalFiles());
+}
+
+void FileOperationService::reportRunningJobs() {
+    for (int id : m_queue->jobIds()) {
+        const JobQueue::Job* job = m_queue->job(id);
+        if (job->state == JobQueue::Running) {
+            reportJob(id);
+        }
+    }
+}
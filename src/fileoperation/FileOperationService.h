@@ -0,0 +1,64 @@
+#ifndef FILEOPERATIONSERVICE_H
+#define FILEOPERATIONSERVICE_H
+
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+
+class JobQueue;
+
+/**
+ * @file FileOperationService.h
+ * @class FileOperationService
+ * @brief Exposes a JobQueue on the session bus so that fileoperation can run as a persistent service.
+ *
+ * Filer windows submit jobs to the running service instead of starting a new fileoperation
+ * process for each request. All jobs share one queue, and job state is broadcast to every
+ * Filer window with the JobChanged signal.
+ */
+class FileOperationService : public QObject {
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.helloSystem.FileOperation")
+
+public:
+    static const QString serviceName;
+    static const QString objectPath;
+
+    explicit FileOperationService(JobQueue* queue, QObject* parent = nullptr);
+
+    /**
+     * @brief Registers the service on the session bus.
+     * @return false if the service could not be registered, e.g., because it is already running.
+     */
+    bool registerService();
+
+    Q_SCRIPTABLE int Copy(const QStringList& sourcePaths, const QString& targetPath);
+    Q_SCRIPTABLE int Move(const QStringList& sourcePaths, const QString& targetPath);
+    Q_SCRIPTABLE int Delete(const QStringList& paths);
+    Q_SCRIPTABLE void Pause(int id);
+    Q_SCRIPTABLE void Resume(int id);
+    Q_SCRIPTABLE void Cancel(int id);
+
+    /**
+     * @brief Sends JobChanged for every job in the queue, e.g., for a Filer window that was just opened.
+     */
+    Q_SCRIPTABLE void ReportJobs();
+
+    signals:
+        /**
+         * @brief Broadcasts the state of a job to every Filer window.
+         * @param state One of "queued", "running", "paused", "awaiting-confirmation", "finished", "failed", "canceled".
+         */
+        Q_SCRIPTABLE void JobChanged(int id, const QString& type, const QString& state,
+                                     const QString& targetPath, qlonglong bytesDone, qlonglong totalBytes,
+                                     int filesDone, int totalFiles);
+
+private:
+    void reportJob(int id);
+    void reportRunningJobs();
+
+    JobQueue* m_queue;
+    QTimer m_reportTimer; /**< Broadcasts the progress of running jobs at a low, fixed rate. */
+};
+
+#endif // FILEOPERATIONSERVICE_H
@@ -0,0 +1,187 @@
+#include "HashPipeline.h"
+#include <QFile>
+#include <QDebug>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <xxhash.h>
+
+HashPipeline::HashPipeline() : m_thread(&HashPipeline::work, this) {
+
+}
+
+HashPipeline::~HashPipeline() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_queued.notify_all();
+    m_thread.join();
+}
+
+void HashPipeline::submit(int file, qint64 offset, const char* data, qint64 length, int tag) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_files[file].outstanding++;
+        m_queue.push_back({file, offset / BlockSize, data, length, tag});
+    }
+    m_queued.notify_one();
+}
+
+void HashPipeline::submitZeros(int file, qint64 offset, qint64 length) {
+    static const QByteArray zeros(BlockSize, '\0');
+    submit(file, offset, zeros.constData(), length, -1);
+}
+
+QVector<int> HashPipeline::takeReleased() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    QVector<int> released;
+    released.swap(m_released);
+    return released;
+}
+
+void HashPipeline::waitForReleased() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_hashed.wait(lock, [this]() {
+        return !m_released.isEmpty() || (m_queue.empty() && m_working == 0);
+    });
+}
+
+bool HashPipeline::isBusy() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return !m_queue.empty() || m_working > 0;
+}
+
+QByteArray HashPipeline::result(int file) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_hashed.wait(lock, [this, file]() {
+        return m_files.value(file).outstanding == 0;
+    });
+    QVector<quint64> blocks = m_files.take(file).blocks;
+    lock.unlock();
+
+    quint64 hash = hashBlock(reinterpret_cast<const char*>(blocks.constData()), blocks.size() * sizeof(quint64));
+    return algorithm().toLatin1() + ":" + QByteArray::number(hash, 16).rightJustified(16, '0');
+}
+
+void HashPipeline::clear() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_hashed.wait(lock, [this]() {
+        return m_queue.empty() && m_working == 0;
+    });
+    m_files.clear();
+    m_released.clear();
+}
+
+QByteArray HashPipeline::hashFile(const QString& path, bool uncached, const std::function<bool(qint64)>& progress) {
+    // Not a valid index into any plan, so it cannot collide with the files of a copy
+    static const int FileKey = -1;
+    static const int BufferCount = 4;
+
+    int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        qDebug() << "HashPipeline: Cannot read" << path << strerror(errno);
+        return QByteArray();
+    }
+    if (uncached) {
+        // Only clean pages can be dropped, so flush the file first
+        ::fdatasync(fd);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    QByteArray buffers(BufferCount * BlockSize, Qt::Uninitialized);
+    bool busy[BufferCount] = {};
+    bool succeeded = true;
+    qint64 offset = 0;
+    for (int buffer = 0; succeeded; buffer = (buffer + 1) % BufferCount) {
+        while (busy[buffer]) {
+            for (int released : takeReleased()) {
+                busy[released] = false;
+            }
+            if (busy[buffer]) {
+                waitForReleased();
+            }
+        }
+
+        // Read a whole block; blocks must start at multiples of BlockSize
+        char* data = buffers.data() + buffer * BlockSize;
+        qint64 length = 0;
+        while (length < BlockSize) {
+            ssize_t bytesRead = ::pread(fd, data + length, BlockSize - length, offset + length);
+            if (bytesRead < 0 && errno == EINTR) {
+                continue;
+            }
+            if (bytesRead < 0) {
+                qDebug() << "HashPipeline: Failed to read" << path << strerror(errno);
+                succeeded = false;
+            }
+            if (bytesRead <= 0) {
+                break;
+            }
+            length += bytesRead;
+        }
+        if (!succeeded || length == 0) {
+            break;
+        }
+
+        busy[buffer] = true;
+        submit(FileKey, offset, data, length, buffer);
+        offset += length;
+        if (progress && !progress(length)) {
+            succeeded = false;
+        }
+        if (length < BlockSize) {
+            break;
+        }
+    }
+
+    // Wait for the blocks in flight before the buffers go away
+    QByteArray hash = result(FileKey);
+    takeReleased();
+    if (uncached) {
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+    ::close(fd);
+    return succeeded ? hash : QByteArray();
+}
+
+QString HashPipeline::algorithm() {
+    return QStringLiteral("xxh3");
+}
+
+quint64 HashPipeline::hashBlock(const char* data, qint64 length) {
+    return XXH3_64bits(data, static_cast<size_t>(length));
+}
+
+void HashPipeline::work() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_queued.wait(lock, [this]() {
+            return m_quit || !m_queue.empty();
+        });
+        if (m_quit) {
+            return;
+        }
+        Block block = m_queue.front();
+        m_queue.pop_front();
+        m_working++;
+        lock.unlock();
+
+        quint64 hash = hashBlock(block.data, block.length);
+
+        lock.lock();
+        m_working--;
+        FileHashes& file = m_files[block.file];
+        if (file.blocks.size() <= block.index) {
+            file.blocks.resize(block.index + 1);
+        }
+        file.blocks[block.index] = hash;
+        file.outstanding--;
+        if (block.tag >= 0) {
+            m_released.append(block.tag);
+        }
+        m_hashed.notify_all();
+    }
+}
@@ -0,0 +1,119 @@
+#ifndef HASHPIPELINE_H
+#define HASHPIPELINE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+/**
+ * @file HashPipeline.h
+ * @class HashPipeline
+ * @brief Hashes file contents on a separate thread while the copier keeps doing I/O.
+ *
+ * Files are hashed in blocks of BlockSize bytes at offsets that are multiples of BlockSize.
+ * Each block is hashed on its own and the hash of a file is the hash of its block hashes in order,
+ * so blocks can be submitted in any order, e.g., as io_uring completes them.
+ *
+ * The hash is XXH3 from libxxhash. The algorithm is part of the result, so hashes recorded with
+ * another algorithm, e.g., in an older journal, never compare equal.
+ */
+class HashPipeline {
+public:
+    static const qint64 BlockSize = 256 * 1024;
+
+    HashPipeline();
+    ~HashPipeline();
+    HashPipeline(const HashPipeline&) = delete;
+    HashPipeline& operator=(const HashPipeline&) = delete;
+
+    /**
+     * @brief Queues a block for hashing.
+     * @param file Identifies the file the block belongs to.
+     * @param offset Offset of the block in the file; must be a multiple of BlockSize.
+     * @param data The contents of the block; must stay valid until the tag has been released.
+     * @param length The length of the block; less than BlockSize only for the last block.
+     * @param tag Returned by takeReleased() once the data is no longer needed, e.g., a buffer index;
+     * negative tags are not returned.
+     */
+    void submit(int file, qint64 offset, const char* data, qint64 length, int tag);
+
+    /**
+     * @brief Queues a block of zeros, e.g., for a hole in a sparse file.
+     */
+    void submitZeros(int file, qint64 offset, qint64 length);
+
+    /**
+     * @brief Returns the tags of the blocks that have been hashed since the last call.
+     */
+    QVector<int> takeReleased();
+
+    /**
+     * @brief Blocks until a submitted block has been hashed; returns immediately if nothing is queued.
+     */
+    void waitForReleased();
+
+    /**
+     * @brief Returns whether blocks are queued or being hashed.
+     */
+    bool isBusy() const;
+
+    /**
+     * @brief Waits for the blocks of a file and returns the hash of the file.
+     * @note The file is forgotten afterwards.
+     */
+    QByteArray result(int file);
+
+    /**
+     * @brief Waits until nothing is queued and forgets all files.
+     */
+    void clear();
+
+    /**
+     * @brief Reads a file and hashes it, reading ahead while the previous block is being hashed.
+     * @param path The file to hash.
+     * @param uncached Flush the file and drop it from the page cache first, so that what is on the disk is read.
+     * @param progress Called with the number of bytes read after each block; returning false aborts.
+     * @return The hash, or an empty QByteArray on error or abort.
+     */
+    QByteArray hashFile(const QString& path, bool uncached, const std::function<bool(qint64)>& progress);
+
+    /**
+     * @brief Returns the name of the hash algorithm, e.g., "xxh3".
+     */
+    static QString algorithm();
+
+private:
+    struct Block {
+        int file;
+        qint64 index;
+        const char* data;
+        qint64 length;
+        int tag;
+    };
+
+    struct FileHashes {
+        QVector<quint64> blocks;
+        int outstanding = 0;
+    };
+
+    static quint64 hashBlock(const char* data, qint64 length);
+    void work();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_queued;
+    std::condition_variable m_hashed;
+    std::deque<Block> m_queue;
+    int m_working = 0;
+    QVector<int> m_released;
+    QHash<int, FileHashes> m_files;
+    bool m_quit = false;
+    std::thread m_thread;
+};
+
+#endif // HASHPIPELINE_H
@@ -0,0 +1,129 @@
+#include "JobProgressWidget.h"
+#include "JobQueue.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFileInfo>
+#include <QLocale>
+
+JobProgressWidget::JobProgressWidget(JobQueue* queue, int jobId, QWidget* parent)
+        : QWidget(parent), m_queue(queue), m_jobId(jobId) {
+
+    titleLabel = new QLabel(this);
+    currentFileLabel = new QLabel(this);
+    progressBar = new QProgressBar(this);
+    itemsLabel = new QLabel(this);
+    throughputLabel = new QLabel(this);
+
+    pauseButton = new QToolButton(this);
+    pauseButton->setText(tr("Pause"));
+    upButton = new QToolButton(this);
+    upButton->setText(tr("Up"));
+    upButton->setToolTip(tr("Run this job earlier"));
+    downButton = new QToolButton(this);
+    downButton->setText(tr("Down"));
+    downButton->setToolTip(tr("Run this job later"));
+    cancelButton = new QToolButton(this);
+    cancelButton->setText(tr("Cancel"));
+
+    connect(pauseButton, &QToolButton::clicked, this, [this]() {
+        const JobQueue::Job* job = m_queue->job(m_jobId);
+        if (job && job->state == JobQueue::Paused) {
+            m_queue->resume(m_jobId);
+        } else {
+            m_queue->pause(m_jobId);
+        }
+    });
+    connect(upButton, &QToolButton::clicked, this, [this]() { m_queue->move(m_jobId, -1); });
+    connect(downButton, &QToolButton::clicked, this, [this]() { m_queue->move(m_jobId, 1); });
+    connect(cancelButton, &QToolButton::clicked, this, [this]() { m_queue->cancel(m_jobId); });
+
+    QHBoxLayout* progressLayout = new QHBoxLayout;
+    progressLayout->addWidget(progressBar);
+    progressLayout->addWidget(pauseButton);
+    progressLayout->addWidget(upButton);
+    progressLayout->addWidget(downButton);
+    progressLayout->addWidget(cancelButton);
+
+    QVBoxLayout* mainLayout = new QVBoxLayout;
+    mainLayout->addWidget(titleLabel);
+    mainLayout->addWidget(currentFileLabel);
+    mainLayout->addLayout(progressLayout);
+    mainLayout->addWidget(itemsLabel);
+    mainLayout->addWidget(throughputLabel);
+    setLayout(mainLayout);
+
+    if (const JobQueue::Job* job = m_queue->job(m_jobId)) {
+        QString sources = job->sourcePaths.size() == 1 ? QFileInfo(job->sourcePaths.first()).fileName()
+                                                       : tr("%1 items").arg(job->sourcePaths.size());
+        if (job->type == JobQueue::Delete) {
+            titleLabel->setText(tr("Delete %1").arg(sources));
+        } else {
+            titleLabel->setText(tr("%1 %2 to %3").arg(JobQueue::typeName(job->type), sources, job->targetPath));
+        }
+    }
+
+    sample();
+}
+
+void JobProgressWidget::sample() {
+    const JobQueue::Job* job = m_queue->job(m_jobId);
+    if (!job) {
+        return;
+    }
+    const ProgressTelemetry* telemetry = job->telemetry.get();
+
+    bool waiting = job->state == JobQueue::Queued || (job->state == JobQueue::Paused && !job->thread);
+    bool active = job->state == JobQueue::Queued || job->state == JobQueue::Running || job->state == JobQueue::Paused;
+    pauseButton->setText(job->state == JobQueue::Paused ? tr("Resume") : tr("Pause"));
+    pauseButton->setEnabled(active);
+    upButton->setEnabled(waiting);
+    downButton->setEnabled(waiting);
+    // Canceling a move that awaits confirmation keeps its sources
+    cancelButton->setEnabled(active || job->state == JobQueue::AwaitingConfirmation);
+
+    progressBar->setValue(telemetry->percentage());
+
+    QString currentFile = telemetry->currentFile();
+    if (job->state == JobQueue::AwaitingConfirmation) {
+        currentFileLabel->setText(JobQueue::stateName(job->state));
+    } else if (job->deletingSources) {
+        currentFileLabel->setText(tr("Deleting: %1").arg(QFileInfo(currentFile).fileName()));
+    } else if (!currentFile.isEmpty()) {
+        currentFileLabel->setText(tr("%1: %2").arg(JobQueue::typeName(job->type), QFileInfo(currentFile).fileName()));
+    } else {
+        currentFileLabel->setText(JobQueue::stateName(job->state));
+    }
+
+    if (!job->errorMessage.isEmpty()) {
+        itemsLabel->setText(job->errorMessage);
+        throughputLabel->clear();
+        return;
+    }
+
+    QLocale locale;
+    if (telemetry->totalBytes() > 0) {
+        itemsLabel->setText(tr("%1 of %2 items, %3 of %4")
+                                    .arg(telemetry->filesDone())
+                                    .arg(telemetry->totalFiles())
+                                    .arg(locale.formattedDataSize(telemetry->bytesDone()))
+                                    .arg(locale.formattedDataSize(telemetry->totalBytes())));
+    } else {
+        itemsLabel->setText(tr("%1 of %2 items").arg(telemetry->filesDone()).arg(telemetry->totalFiles()));
+    }
+
+    double rate = telemetry->bytesPerSecond();
+    qint64 remaining = telemetry->secondsRemaining();
+    if (job->state != JobQueue::Running || telemetry->totalBytes() <= 0) {
+        throughputLabel->clear();
+    } else if (rate <= 0.0 || remaining < 0) {
+        throughputLabel->setText(tr("Estimating time remaining..."));
+    } else if (remaining < 60) {
+        throughputLabel->setText(tr("%1/s, about %2 seconds remaining")
+                                         .arg(locale.formattedDataSize(static_cast<qint64>(rate)))
+                                         .arg(remaining));
+    } else {
+        throughputLabel->setText(tr("%1/s, about %2 minutes remaining")
+                                         .arg(locale.formattedDataSize(static_cast<qint64>(rate)))
+                                         .arg((remaining + 59) / 60));
+    }
+}
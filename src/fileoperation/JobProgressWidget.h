@@ -0,0 +1,45 @@
+#ifndef JOBPROGRESSWIDGET_H
+#define JOBPROGRESSWIDGET_H
+
+#include <QWidget>
+#include <QLabel>
+#include <QProgressBar>
+#include <QToolButton>
+
+class JobQueue;
+
+/**
+ * @file JobProgressWidget.h
+ * @class JobProgressWidget
+ * @brief Shows the progress of a single job of a JobQueue and lets the user control it.
+ */
+class JobProgressWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    JobProgressWidget(JobQueue* queue, int jobId, QWidget* parent = nullptr);
+
+    int jobId() const { return m_jobId; }
+
+public slots:
+    /**
+     * @brief Updates the widget from the state and progress counters of the job.
+     */
+    void sample();
+
+private:
+    JobQueue* m_queue;
+    int m_jobId;
+
+    QLabel* titleLabel;
+    QLabel* currentFileLabel;
+    QProgressBar* progressBar;
+    QLabel* itemsLabel;
+    QLabel* throughputLabel;
+    QToolButton* pauseButton;
+    QToolButton* upButton;
+    QToolButton* downButton;
+    QToolButton* cancelButton;
+};
+
+#endif // JOBPROGRESSWIDGET_H
@@ -0,0 +1,465 @@
+#include "JobQueue.h"
+#include "CopyThread.h"
+#include "DeleteThread.h"
+#include "RenameNoReplace.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDebug>
+#include <QHash>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <fcntl.h>
+#ifdef __linux__
+#include <sys/sysmacros.h>
+#endif
+
+JobQueue::JobQueue(QObject* parent) : QObject(parent) {
+
+}
+
+JobQueue::~JobQueue() {
+    for (Job* job : m_jobs) {
+        if (job->thread) {
+            job->thread->cancel();
+            job->thread->wait();
+            delete job->thread;
+        }
+        delete job;
+    }
+}
+
+int JobQueue::enqueue(JobType type, const QStringList& sourcePaths, const QString& targetPath) {
+    return enqueue(type, sourcePaths, targetPath, nullptr);
+}
+
+int JobQueue::enqueueResume(const QString& journalPath, bool verifyCompleted) {
+    std::unique_ptr<CopyJournal> journal(new CopyJournal);
+    if (!journal->load(journalPath) || !journal->hasPlan()) {
+        qDebug() << "JobQueue: Cannot resume from" << journalPath;
+        return -1;
+    }
+    journal->setVerifiesCompletedFiles(verifyCompleted);
+    JobType type = journal->operation() == QLatin1String("move") ? Move : Copy;
+    QStringList sourcePaths = journal->sourcePaths();
+    QString targetPath = journal->targetPath();
+    return enqueue(type, sourcePaths, targetPath, std::move(journal));
+}
+
+int JobQueue::enqueue(JobType type, const QStringList& sourcePaths, const QString& targetPath,
+                      std::unique_ptr<CopyJournal> journal) {
+    Job* job = new Job;
+    job->id = m_nextId++;
+    job->type = type;
+    job->state = Queued;
+    job->sourcePaths = sourcePaths;
+    job->targetPath = targetPath;
+    job->telemetry.reset(new ProgressTelemetry);
+    job->journal = std::move(journal);
+
+    for (const QString& sourcePath : sourcePaths) {
+        job->devices.insert(deviceKey(sourcePath));
+    }
+    if (type != Delete) {
+        job->devices.insert(deviceKey(targetPath));
+    }
+    job->devices.remove(QString());
+
+    qDebug() << "JobQueue: Enqueued" << typeName(type) << "job" << job->id << "on devices" << job->devices;
+
+    m_jobs.append(job);
+    emit jobAdded(job->id);
+    schedule();
+    return job->id;
+}
+
+const JobQueue::Job* JobQueue::job(int id) const {
+    return findJob(id);
+}
+
+QList<int> JobQueue::jobIds() const {
+    QList<int> ids;
+    for (const Job* job : m_jobs) {
+        ids << job->id;
+    }
+    return ids;
+}
+
+bool JobQueue::hasActiveJobs() const {
+    for (const Job* job : m_jobs) {
+        if (job->state == Queued || job->state == Running || job->state == Paused
+            || job->state == AwaitingConfirmation) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobQueue::setSourceDeletionConfirmation(const std::function<void(int, const QStringList&)>& confirmation) {
+    m_confirmSourceDeletion = confirmation;
+}
+
+QString JobQueue::deviceKey(const QString& path) {
+    // The target folder might not exist yet, so use the nearest existing ancestor
+    QString existingPath = QFileInfo(path).absoluteFilePath();
+    struct stat st;
+    while (::stat(QFile::encodeName(existingPath).constData(), &st) != 0) {
+        QString parentPath = QFileInfo(existingPath).path();
+        if (parentPath == existingPath) {
+            return QString();
+        }
+        existingPath = parentPath;
+    }
+
+    // Resolving the physical device is comparatively expensive, so remember it for the lifetime
+    // of the process; this pays off when fileoperation runs as a service
+    static QHash<qulonglong, QString> cache;
+    auto cached = cache.constFind(static_cast<qulonglong>(st.st_dev));
+    if (cached != cache.constEnd()) {
+        return cached.value();
+    }
+
+    QString key = QString("dev:%1").arg(static_cast<qulonglong>(st.st_dev));
+#ifdef __linux__
+    // /sys/dev/block/<major>:<minor> links to the block device; for a partition,
+    // the parent directory is the whole disk, which is what we want to serialize on
+    QString sysPath = QString("/sys/dev/block/%1:%2").arg(major(st.st_dev)).arg(minor(st.st_dev));
+    QString devicePath = QFileInfo(sysPath).canonicalFilePath();
+    if (!devicePath.isEmpty()) {
+        if (QFile::exists(devicePath + "/partition")) {
+            devicePath = QFileInfo(devicePath).path();
+        }
+        key = QFileInfo(devicePath).fileName();
+    }
+#endif
+
+    cache.insert(static_cast<qulonglong>(st.st_dev), key);
+    return key;
+}
+
+QString JobQueue::typeName(JobType type) {
+    switch (type) {
+    case Copy:
+        return tr("Copy");
+    case Move:
+        return tr("Move");
+    case Delete:
+        return tr("Delete");
+    }
+    return QString();
+}
+
+QString JobQueue::stateName(JobState state) {
+    switch (state) {
+    case Queued:
+        return tr("Waiting");
+    case Running:
+        return tr("Running");
+    case Paused:
+        return tr("Paused");
+    case AwaitingConfirmation:
+        return tr("Waiting for confirmation");
+    case Finished:
+        return tr("Finished");
+    case Failed:
+        return tr("Failed");
+    case Canceled:
+        return tr("Canceled");
+    }
+    return QString();
+}
+
+void JobQueue::pause(int id) {
+    Job* job = findJob(id);
+    if (!job || (job->state != Queued && job->state != Running)) {
+        return;
+    }
+    if (job->thread) {
+        job->thread->setPaused(true);
+    }
+    job->state = Paused;
+    emit jobChanged(id);
+    // A paused job that has not started yet no longer holds back later jobs on its devices
+    schedule();
+}
+
+void JobQueue::resume(int id) {
+    Job* job = findJob(id);
+    if (!job || job->state != Paused) {
+        return;
+    }
+    if (job->thread) {
+        job->thread->setPaused(false);
+        job->state = Running;
+    } else {
+        job->state = Queued;
+    }
+    emit jobChanged(id);
+    schedule();
+}
+
+void JobQueue::cancel(int id) {
+    Job* job = findJob(id);
+    if (!job) {
+        return;
+    }
+    job->cancelRequested = true;
+    if (job->thread) {
+        // The job becomes Canceled once its worker thread has noticed
+        job->thread->cancel();
+        return;
+    }
+    if (job->state == Queued || job->state == Paused || job->state == AwaitingConfirmation) {
+        // A move that awaits confirmation has copied everything, so its sources are simply kept
+        job->sourcesToDelete.clear();
+        job->state = Canceled;
+        emit jobChanged(id);
+        schedule();
+        if (!hasActiveJobs()) {
+            emit allJobsFinished();
+        }
+    }
+}
+
+void JobQueue::move(int id, int delta) {
+    Job* job = findJob(id);
+    if (!job || job->thread || (job->state != Queued && job->state != Paused)) {
+        return;
+    }
+    int from = m_jobs.indexOf(job);
+    int to = qBound(0, from + delta, m_jobs.size() - 1);
+    if (from == to) {
+        return;
+    }
+    m_jobs.move(from, to);
+    emit jobsReordered();
+    schedule();
+}
+
+void JobQueue::clearCompleted() {
+    for (int i = m_jobs.size() - 1; i >= 0; i--) {
+        Job* job = m_jobs.at(i);
+        if (job->state == Finished || job->state == Failed || job->state == Canceled) {
+            m_jobs.removeAt(i);
+            int id = job->id;
+            delete job;
+            emit jobRemoved(id);
+        }
+    }
+}
+
+JobQueue::Job* JobQueue::findJob(int id) const {
+    for (Job* job : m_jobs) {
+        if (job->id == id) {
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+// Starts every waiting job whose devices are not in use. Devices of jobs that are still
+// waiting are reserved as well, so that jobs on the same device run in queue order.
+void JobQueue::schedule() {
+    QSet<QString> busyDevices;
+    for (const Job* job : m_jobs) {
+        if (job->state == Running || job->state == AwaitingConfirmation || (job->state == Paused && job->thread)) {
+            busyDevices.unite(job->devices);
+        }
+    }
+
+    // Iterate over a copy; starting a job emits signals that may add jobs to the queue
+    const QList<Job*> jobs = m_jobs;
+    for (Job* job : jobs) {
+        if (job->state != Queued) {
+            continue;
+        }
+        if (!busyDevices.intersects(job->devices)) {
+            startJob(job);
+        }
+        busyDevices.unite(job->devices);
+    }
+}
+
+void JobQueue::startJob(Job* job) {
+    qDebug() << "JobQueue: Starting" << typeName(job->type) << "job" << job->id;
+
+    switch (job->type) {
+    case Copy:
+        startThread(job, createCopyThread(job));
+        break;
+    case Move:
+        // A resumed move has already copied some of its sources, which must not be renamed now
+        if (!job->journal && moveByRenaming(job)) {
+            job->telemetry->setPlan(QStringList(), 0);
+            job->telemetry->finish();
+            job->state = Finished;
+            emit jobChanged(job->id);
+            if (!hasActiveJobs()) {
+                emit allJobsFinished();
+            }
+            return;
+        }
+        startThread(job, createCopyThread(job));
+        break;
+    case Delete:
+        startThread(job, new DeleteThread(job->sourcePaths, job->telemetry.get()));
+        break;
+    }
+}
+
+void JobQueue::startThread(Job* job, OperationThread* thread) {
+    int id = job->id;
+    job->thread = thread;
+    job->state = Running;
+    job->succeeded = false;
+
+    connect(thread, &OperationThread::operationFinished, this, [this, id]() {
+        if (Job* job = findJob(id)) {
+            job->succeeded = true;
+        }
+    });
+    connect(thread, &OperationThread::error, this, [this, id](const QString& errorMessage) {
+        if (Job* job = findJob(id)) {
+            job->errorMessage = errorMessage;
+        }
+    });
+    connect(thread, &QThread::finished, this, [this, id]() {
+        onThreadFinished(id);
+    });
+
+    thread->start();
+    emit jobChanged(id);
+}
+
+OperationThread* JobQueue::createCopyThread(Job* job) {
+    CopyThread* thread = new CopyThread(job->sourcePaths, job->targetPath, job->telemetry.get(), journalFor(job));
+    // A move deletes the sources afterwards, so the targets must be known to be good
+    thread->setVerifyTargets(job->type == Move || m_verifyCopies);
+    return thread;
+}
+
+// Returns the journal of a copy or move job, creating it for a job that is not resumed
+CopyJournal* JobQueue::journalFor(Job* job) {
+    if (!job->journal) {
+        job->journal.reset(new CopyJournal);
+        if (!job->journal->create(CopyJournal::newJournalPath(), job->type == Move ? "move" : "copy",
+                                  job->sourcePaths, job->targetPath)) {
+            // Copy anyway, just without the possibility to resume
+            job->journal.reset();
+        }
+    }
+    return job->journal.get();
+}
+
+void JobQueue::onThreadFinished(int id) {
+    Job* job = findJob(id);
+    if (!job) {
+        return;
+    }
+    job->thread->deleteLater();
+    job->thread = nullptr;
+
+    if (job->journal) {
+        if (job->succeeded && !job->cancelRequested) {
+            job->journal->remove();
+            job->journal.reset();
+        } else {
+            qDebug() << "JobQueue: Job" << id << "can be resumed with: fileoperation --resume" << job->journal->path();
+            if (!job->cancelRequested) {
+                job->errorMessage += "\n\n" + tr("The operation can be resumed with:\nfileoperation --resume %1")
+                                                        .arg(job->journal->path());
+            }
+        }
+    }
+
+    if (job->cancelRequested) {
+        job->state = Canceled;
+    } else if (!job->succeeded) {
+        job->state = Failed;
+    } else if (job->type == Move && !job->deletingSources) {
+        // The sources were copied; now delete the ones that were not moved by renaming
+        QStringList remainingSources;
+        for (const QString& sourcePath : job->sourcePaths) {
+            if (QFileInfo::exists(sourcePath)) {
+                remainingSources << sourcePath;
+            }
+        }
+        if (!remainingSources.isEmpty() && m_confirmSourceDeletion) {
+            // Ask without nesting an event loop here, in which, e.g., a cancel from D-Bus would be lost
+            job->state = AwaitingConfirmation;
+            job->sourcesToDelete = remainingSources;
+            emit jobChanged(id);
+            m_confirmSourceDeletion(id, remainingSources);
+            return;
+        }
+        if (!remainingSources.isEmpty()) {
+            job->deletingSources = true;
+            job->telemetry.reset(new ProgressTelemetry);
+            startThread(job, new DeleteThread(remainingSources, job->telemetry.get()));
+            return;
+        }
+        job->state = Finished;
+    } else {
+        job->state = Finished;
+    }
+
+    finishJob(job);
+}
+
+void JobQueue::confirmSourceDeletion(int id, bool confirmed) {
+    Job* job = findJob(id);
+    // The job may have been canceled while the question was open
+    if (!job || job->state != AwaitingConfirmation) {
+        return;
+    }
+    QStringList sourcesToDelete = job->sourcesToDelete;
+    job->sourcesToDelete.clear();
+    if (confirmed) {
+        job->deletingSources = true;
+        job->telemetry.reset(new ProgressTelemetry);
+        startThread(job, new DeleteThread(sourcesToDelete, job->telemetry.get()));
+        return;
+    }
+    job->state = Finished;
+    finishJob(job);
+}
+
+void JobQueue::finishJob(Job* job) {
+    qDebug() << "JobQueue:" << typeName(job->type) << "job" << job->id << stateName(job->state) << job->errorMessage;
+
+    emit jobChanged(job->id);
+    schedule();
+    if (!hasActiveJobs()) {
+        emit allJobsFinished();
+    }
+}
+
+// Moves the sources that are on the same file system as the target folder by renaming them,
+// which is instantaneous. Returns true if nothing is left to copy. A source whose name is taken
+// in the target folder, even by a dangling symbolic link, or that cannot be renamed without
+// replacing on this file system, is left to the copy, which asks what to do.
+bool JobQueue::moveByRenaming(Job* job) {
+    struct stat targetStat;
+    if (::stat(QFile::encodeName(job->targetPath).constData(), &targetStat) != 0) {
+        return false;
+    }
+
+    QStringList remainingSources;
+    for (const QString& sourcePath : job->sourcePaths) {
+        QFileInfo sourceInfo(sourcePath);
+        QString newPath = QDir(job->targetPath).filePath(sourceInfo.fileName());
+        struct stat sourceStat;
+        if (::lstat(QFile::encodeName(sourcePath).constData(), &sourceStat) == 0
+            && sourceStat.st_dev == targetStat.st_dev
+            && renameNoReplace(AT_FDCWD, QFile::encodeName(sourcePath).constData(),
+                               AT_FDCWD, QFile::encodeName(newPath).constData()) == 0) {
+            qDebug() << "JobQueue: Moved" << sourcePath << "by renaming";
+            continue;
+        }
+        remainingSources << sourcePath;
+    }
+
+    job->sourcePaths = remainingSources;
+    return remainingSources.isEmpty();
+}
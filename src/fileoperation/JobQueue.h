@@ -0,0 +1,160 @@
+#ifndef JOBQUEUE_H
+#define JOBQUEUE_H
+
+#include <QObject>
+#include <QList>
+#include <QSet>
+#include <QStringList>
+#include <functional>
+#include <memory>
+#include "ProgressTelemetry.h"
+#include "CopyJournal.h"
+
+class OperationThread;
+
+/**
+ * @file JobQueue.h
+ * @class JobQueue
+ * @brief Queues copy, move and delete jobs and runs them with per-device scheduling.
+ *
+ * Jobs that touch disjoint physical devices run in parallel. Jobs that touch the same device
+ * (e.g., the same spinning disk or USB stick) run one after another in queue order to avoid
+ * seek thrashing. Jobs can be paused, reordered while they are waiting, and canceled.
+ */
+class JobQueue : public QObject {
+    Q_OBJECT
+
+public:
+    enum JobType { Copy, Move, Delete };
+    enum JobState { Queued, Running, Paused, AwaitingConfirmation, Finished, Failed, Canceled };
+
+    /**
+     * @brief A single file operation in the queue.
+     */
+    struct Job {
+        int id;
+        JobType type;
+        JobState state;
+        QStringList sourcePaths;
+        QString targetPath;
+        QString errorMessage;
+        QSet<QString> devices; /**< Physical devices touched by the job. */
+        std::unique_ptr<ProgressTelemetry> telemetry; /**< Progress of the current stage of the job. */
+        OperationThread* thread = nullptr; /**< The worker thread while the job is running or paused. */
+        bool cancelRequested = false;
+        bool succeeded = false; /**< Set by the worker thread of the current stage. */
+        bool deletingSources = false; /**< Set when a move job has copied its sources and is deleting them. */
+        QStringList sourcesToDelete; /**< What a move job asks to delete while it is AwaitingConfirmation. */
+        std::unique_ptr<CopyJournal> journal; /**< Records the progress of the copy stage so that it can be resumed. */
+    };
+
+    explicit JobQueue(QObject* parent = nullptr);
+    ~JobQueue();
+
+    /**
+     * @brief Adds a job to the end of the queue and starts it as soon as its devices are free.
+     * @param type The kind of operation.
+     * @param sourcePaths The paths to copy, move or delete.
+     * @param targetPath The destination folder; ignored for Delete.
+     * @return The id of the new job.
+     */
+    int enqueue(JobType type, const QStringList& sourcePaths, const QString& targetPath = QString());
+
+    /**
+     * @brief Adds a job that continues an interrupted copy or move.
+     * @param journalPath The journal that the interrupted job left behind.
+     * @param verifyCompleted Whether files that were copied completely are confirmed by comparing
+     * their contents instead of their size and modification time.
+     * @return The id of the new job, or -1 if the journal cannot be read.
+     */
+    int enqueueResume(const QString& journalPath, bool verifyCompleted = false);
+
+    /**
+     * @brief Returns the job with the given id, or nullptr.
+     */
+    const Job* job(int id) const;
+
+    /**
+     * @brief Returns the ids of all jobs in queue order.
+     */
+    QList<int> jobIds() const;
+
+    /**
+     * @brief Returns whether there are jobs that are neither finished, failed nor canceled.
+     */
+    bool hasActiveJobs() const;
+
+    /**
+     * @brief Sets the function that is called before a move job deletes its sources.
+     *
+     * The job is AwaitingConfirmation until confirmSourceDeletion() is called with the answer,
+     * which may happen later from the event loop; the function must not block. Meanwhile, the
+     * job can still be canceled, which keeps the sources.
+     * @note If not set, sources are deleted without asking.
+     */
+    void setSourceDeletionConfirmation(const std::function<void(int id, const QStringList&)>& confirmation);
+
+    /**
+     * @brief Sets whether copy jobs check their targets against hashes of the sources.
+     * @note Move jobs always do, since they delete the sources afterwards.
+     */
+    void setVerifyCopies(bool verify) { m_verifyCopies = verify; }
+
+    /**
+     * @brief Returns a key that identifies the physical device holding the given path.
+     * @note Partitions of the same disk map to the same key where the operating system tells us so.
+     */
+    static QString deviceKey(const QString& path);
+
+    static QString typeName(JobType type);
+    static QString stateName(JobState state);
+
+public slots:
+    void pause(int id);
+    void resume(int id);
+    void cancel(int id);
+
+    /**
+     * @brief Answers the confirmation asked for a move job; ignored unless the job is still AwaitingConfirmation.
+     */
+    void confirmSourceDeletion(int id, bool confirmed);
+
+    /**
+     * @brief Moves a waiting job up or down in the queue.
+     * @param id The job to move.
+     * @param delta Negative values move the job towards the front of the queue.
+     */
+    void move(int id, int delta);
+
+    /**
+     * @brief Removes finished, failed and canceled jobs from the queue.
+     */
+    void clearCompleted();
+
+    signals:
+        void jobAdded(int id);
+        void jobChanged(int id);
+        void jobRemoved(int id);
+        void jobsReordered();
+        void allJobsFinished();
+
+private:
+    int enqueue(JobType type, const QStringList& sourcePaths, const QString& targetPath,
+                std::unique_ptr<CopyJournal> journal);
+    Job* findJob(int id) const;
+    void schedule();
+    void startJob(Job* job);
+    void startThread(Job* job, OperationThread* thread);
+    CopyJournal* journalFor(Job* job);
+    OperationThread* createCopyThread(Job* job);
+    void onThreadFinished(int id);
+    void finishJob(Job* job);
+    bool moveByRenaming(Job* job);
+
+    QList<Job*> m_jobs;
+    int m_nextId = 1;
+    std::function<void(int, const QStringList&)> m_confirmSourceDeletion;
+    bool m_verifyCopies = false;
+};
+
+#endif // JOBQUEUE_H
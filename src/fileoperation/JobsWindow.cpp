@@ -0,0 +1,118 @@
+#include "JobsWindow.h"
+#include "JobQueue.h"
+#include "JobProgressWidget.h"
+#include <QScrollArea>
+#include <QFrame>
+#include <QKeyEvent>
+#include <QDebug>
+
+JobsWindow::JobsWindow(JobQueue* queue, QWidget* parent) : QWidget(parent), m_queue(queue) {
+
+    QWidget* jobsContainer = new QWidget;
+    m_jobsLayout = new QVBoxLayout;
+    m_jobsLayout->addStretch();
+    jobsContainer->setLayout(m_jobsLayout);
+
+    QScrollArea* scrollArea = new QScrollArea(this);
+    scrollArea->setWidgetResizable(true);
+    scrollArea->setFrameShape(QFrame::NoFrame);
+    scrollArea->setWidget(jobsContainer);
+
+    QVBoxLayout* mainLayout = new QVBoxLayout;
+    mainLayout->setContentsMargins(0, 0, 0, 0);
+    mainLayout->addWidget(scrollArea);
+    setLayout(mainLayout);
+
+    connect(m_queue, &JobQueue::jobAdded, this, &JobsWindow::onJobAdded);
+    connect(m_queue, &JobQueue::jobRemoved, this, &JobsWindow::onJobRemoved);
+    connect(m_queue, &JobQueue::jobsReordered, this, &JobsWindow::onJobsReordered);
+    connect(m_queue, &JobQueue::jobChanged, this, [this](int id) {
+        if (m_jobWidgets.contains(id)) {
+            m_jobWidgets.value(id)->sample();
+        }
+        updateWindowTitle();
+    });
+
+    // Sample the progress counters about 20 times per second, regardless of how fast the jobs are
+    m_sampleTimer.setInterval(50);
+    connect(&m_sampleTimer, &QTimer::timeout, this, &JobsWindow::sampleJobs);
+    m_sampleTimer.start();
+
+    for (int id : m_queue->jobIds()) {
+        onJobAdded(id);
+    }
+
+    resize(460, 190);
+    updateWindowTitle();
+}
+
+void JobsWindow::onJobAdded(int id) {
+    JobProgressWidget* widget = new JobProgressWidget(m_queue, id, this);
+    m_jobWidgets.insert(id, widget);
+    // Keep the stretch at the end
+    m_jobsLayout->insertWidget(m_jobsLayout->count() - 1, widget);
+    updateWindowTitle();
+}
+
+void JobsWindow::onJobRemoved(int id) {
+    JobProgressWidget* widget = m_jobWidgets.take(id);
+    if (widget) {
+        m_jobsLayout->removeWidget(widget);
+        widget->deleteLater();
+    }
+    updateWindowTitle();
+}
+
+void JobsWindow::onJobsReordered() {
+    int position = 0;
+    for (int id : m_queue->jobIds()) {
+        if (JobProgressWidget* widget = m_jobWidgets.value(id)) {
+            m_jobsLayout->removeWidget(widget);
+            m_jobsLayout->insertWidget(position++, widget);
+        }
+    }
+}
+
+void JobsWindow::sampleJobs() {
+    for (JobProgressWidget* widget : m_jobWidgets) {
+        const JobQueue::Job* job = m_queue->job(widget->jobId());
+        if (job && job->state == JobQueue::Running) {
+            widget->sample();
+        }
+    }
+}
+
+void JobsWindow::updateWindowTitle() {
+    int active = 0;
+    for (int id : m_queue->jobIds()) {
+        const JobQueue::Job* job = m_queue->job(id);
+        if (job->state == JobQueue::Queued || job->state == JobQueue::Running || job->state == JobQueue::Paused
+            || job->state == JobQueue::AwaitingConfirmation) {
+            active++;
+        }
+    }
+    if (active == 1) {
+        setWindowTitle(tr("1 File Operation"));
+    } else {
+        setWindowTitle(tr("%1 File Operations").arg(active));
+    }
+}
+
+// This event is called when the user presses a key; we use it to detect the Escape key
+void JobsWindow::keyPressEvent(QKeyEvent* event) {
+    if (event->key() == Qt::Key_Escape) {
+        close();
+        event->accept();
+    } else {
+        QWidget::keyPressEvent(event);
+    }
+}
+
+// Closing the window cancels all jobs that have not completed yet
+void JobsWindow::closeEvent(QCloseEvent* event) {
+    qDebug() << "JobsWindow::closeEvent";
+    for (int id : m_queue->jobIds()) {
+        m_queue->cancel(id);
+    }
+    event->accept();
+}
@@ -0,0 +1,46 @@
+#ifndef JOBSWINDOW_H
+#define JOBSWINDOW_H
+
+#include <QWidget>
+#include <QMap>
+#include <QTimer>
+#include <QVBoxLayout>
+#include <QCloseEvent>
+
+class JobQueue;
+class JobProgressWidget;
+
+/**
+ * @file JobsWindow.h
+ * @class JobsWindow
+ * @brief A single window that shows all jobs of a JobQueue.
+ *
+ * The progress of all jobs is sampled at a fixed rate, independent of how many
+ * jobs there are and how fast they progress.
+ */
+class JobsWindow : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit JobsWindow(JobQueue* queue, QWidget* parent = nullptr);
+
+protected:
+    void keyPressEvent(QKeyEvent* event) override;
+    void closeEvent(QCloseEvent* event) override;
+
+private slots:
+    void onJobAdded(int id);
+    void onJobRemoved(int id);
+    void onJobsReordered();
+    void sampleJobs();
+
+private:
+    void updateWindowTitle();
+
+    JobQueue* m_queue;
+    QVBoxLayout* m_jobsLayout;
+    QMap<int, JobProgressWidget*> m_jobWidgets;
+    QTimer m_sampleTimer;
+};
+
+#endif // JOBSWINDOW_H
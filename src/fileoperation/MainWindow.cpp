@@ -1,7 +1,9 @@
 #include "MainWindow.h"
+#include "JobsWindow.h"
 #include <QDebug>
 #include <QApplication>
 #include <QMessageBox>
+#include <QTimer>
 
 MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
 
@@ -10,33 +12,111 @@ MainWindow::MainWindow(QWidget* parent) : QMainWindow(parent) {
     // Apparently every Qt application needs a MainWindow
     // but we don't need to show it
     // show();
+
+    // One window shows all jobs
+    m_jobsWindow = new JobsWindow(&m_jobQueue, this);
+    m_jobsWindow->setWindowFlags(Qt::Window);
+
+    // Ask before a move deletes its sources; by then, every target has been read back
+    // from the disk and found to match the hash of its source. The question is not modal, so that
+    // the service keeps handling D-Bus calls, e.g., a cancel of the very same job
+    m_jobQueue.setSourceDeletionConfirmation([this](int id, const QStringList& sourcePaths) {
+        QMessageBox* question = new QMessageBox(QMessageBox::Question, "Delete source files?",
+                                                "Do you want to delete the following?\n\n" + sourcePaths.join("\n"),
+                                                QMessageBox::Yes | QMessageBox::No, m_jobsWindow);
+        question->setAttribute(Qt::WA_DeleteOnClose);
+        connect(question, &QMessageBox::finished, this, [this, id, question]() {
+            disconnect(&m_jobQueue, nullptr, question, nullptr);
+            m_jobQueue.confirmSourceDeletion(id, question->clickedButton() == question->button(QMessageBox::Yes));
+        });
+        // Withdraw the question once the job no longer awaits the answer
+        connect(&m_jobQueue, &JobQueue::jobChanged, question, [this, id, question](int changedId) {
+            const JobQueue::Job* job = m_jobQueue.job(changedId);
+            if (changedId == id && (!job || job->state != JobQueue::AwaitingConfirmation)) {
+                question->reject();
+            }
+        });
+        connect(&m_jobQueue, &JobQueue::jobRemoved, question, [id, question](int removedId) {
+            if (removedId == id) {
+                question->reject();
+            }
+        });
+        question->open();
+    });
+
+    connect(&m_jobQueue, &JobQueue::jobChanged, this, &MainWindow::onJobChanged);
+    connect(&m_jobQueue, &JobQueue::allJobsFinished, this, &MainWindow::onAllJobsFinished);
 }
 
-void MainWindow::startCopyWithProgress(const QStringList& fromPaths, const QString& toPath) {
-    copyManager.copyWithProgress(fromPaths, toPath);
+void MainWindow::setDaemonMode(int idleTimeout) {
+    m_daemonMode = true;
+    m_idleTimer.setSingleShot(true);
+    m_idleTimer.setInterval(idleTimeout);
+    connect(&m_idleTimer, &QTimer::timeout, this, []() {
+        qDebug() << "MainWindow: Idle for too long, quitting";
+        QCoreApplication::quit();
+    });
+    connect(&m_jobQueue, &JobQueue::jobAdded, this, [this]() {
+        m_idleTimer.stop();
+        m_jobsWindow->show();
+    });
+    m_idleTimer.start();
+}
 
-    // Register a callback to know when the copy is finished
-    connect(&copyManager, &CopyManager::copyFinished, this, &MainWindow::onCopyFinished);
-    // Register a callback to know when the copy was cancelled or an error occurred
-    connect(&copyManager, &CopyManager::copyCanceled, this, &MainWindow::onCopyCanceled);
-    // Register a callback to know when an error occurred
-    connect(&copyManager, &CopyManager::errorOccured, this, &MainWindow::onErrorOccurred);
+void MainWindow::startJob(JobQueue::JobType type, const QStringList& fromPaths, const QString& toPath) {
+    m_jobQueue.enqueue(type, fromPaths, toPath);
+    m_jobsWindow->show();
 }
 
-void MainWindow::onCopyFinished() {
-    qDebug() << "MainWindow: Copy finished!";
-    QCoreApplication::quit();
+bool MainWindow::resumeJob(const QString& journalPath, bool verifyCompleted) {
+    if (m_jobQueue.enqueueResume(journalPath, verifyCompleted) < 0) {
+        return false;
+    }
+    m_jobsWindow->show();
+    return true;
 }
 
-void MainWindow::onCopyCanceled() {
-    qDebug() << "MainWindow: Copy canceled!";
-    // Exit with an error code
-    QCoreApplication::exit(1);
+void MainWindow::onJobChanged(int id) {
+    const JobQueue::Job* job = m_jobQueue.job(id);
+    if (job && job->state == JobQueue::Failed) {
+        qDebug() << "MainWindow: Error occurred: " << job->errorMessage;
+        if (m_daemonMode) {
+            // A modal dialog would handle D-Bus calls in a nested event loop
+            QMessageBox* message = new QMessageBox(QMessageBox::Critical, tr("Error"), job->errorMessage,
+                                                   QMessageBox::Ok, m_jobsWindow);
+            message->setAttribute(Qt::WA_DeleteOnClose);
+            message->open();
+        } else {
+            // The process exits once all jobs are done, so the error must be acknowledged first
+            QMessageBox::critical(m_jobsWindow, tr("Error"), job->errorMessage);
+        }
+    }
 }
 
-void MainWindow::onErrorOccurred(const QString& errorMessage) {
-    qDebug() << "MainWindow: Error occurred: " << errorMessage;
-    QMessageBox::critical(this, tr("Error"), errorMessage);
-    // Exit with an error code
-    QCoreApplication::exit(1);
-}
\ No newline at end of file
+void MainWindow::onAllJobsFinished() {
+    if (m_daemonMode) {
+        // Keep running so that the next job starts without delay; forget about the completed jobs
+        // after a moment so that the user can see that they have finished
+        QTimer::singleShot(2000, this, [this]() {
+            if (!m_jobQueue.hasActiveJobs()) {
+                m_jobQueue.clearCompleted();
+                m_jobsWindow->hide();
+                m_idleTimer.start();
+            }
+        });
+        return;
+    }
+
+    // Exit with an error code if any of the jobs did not finish
+    int exitCode = 0;
+    for (int id : m_jobQueue.jobIds()) {
+        if (m_jobQueue.job(id)->state != JobQueue::Finished) {
+            exitCode = 1;
+        }
+    }
+    qDebug() << "MainWindow: All jobs finished with exit code" << exitCode;
+    // Jobs can finish before the event loop is running, e.g., moves within the same file system
+    QTimer::singleShot(0, this, [exitCode]() {
+        QCoreApplication::exit(exitCode);
+    });
+}
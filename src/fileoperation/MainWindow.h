@@ -2,20 +2,40 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include "CopyManager.h"
+#include <QTimer>
+#include "JobQueue.h"
+
+class JobsWindow;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
 
 public:
     MainWindow(QWidget* parent = nullptr);
-    void startCopyWithProgress(const QStringList& fromPaths, const QString& toPath);
+    void startJob(JobQueue::JobType type, const QStringList& fromPaths, const QString& toPath = QString());
+
+    /**
+     * @brief Continues an interrupted copy or move from its journal.
+     * @return false if the journal cannot be read.
+     */
+    bool resumeJob(const QString& journalPath, bool verifyCompleted);
+
+    JobsWindow* jobsWindow() const { return m_jobsWindow; }
+    JobQueue* jobQueue() { return &m_jobQueue; }
+
+    /**
+     * @brief Keeps the process running when all jobs are finished, as needed when running as a service.
+     * @param idleTimeout Quit after this many milliseconds without jobs.
+     */
+    void setDaemonMode(int idleTimeout);
 
 private:
-    CopyManager copyManager;
-    void onCopyFinished();
-    void onCopyCanceled();
-    void onErrorOccurred(const QString& errorMessage);
+    JobQueue m_jobQueue;
+    JobsWindow* m_jobsWindow;
+    bool m_daemonMode = false;
+    QTimer m_idleTimer;
+    void onJobChanged(int id);
+    void onAllJobsFinished();
 
 };
 #endif // MAINWINDOW_H
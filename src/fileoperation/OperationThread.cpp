@@ -0,0 +1,35 @@
+#include "OperationThread.h"
+#include <QMutexLocker>
+
+OperationThread::OperationThread(ProgressTelemetry* telemetry, QObject* parent)
+        : QThread(parent), m_telemetry(telemetry) {
+
+}
+
+bool OperationThread::isPaused() const {
+    QMutexLocker locker(&m_pauseMutex);
+    return m_paused;
+}
+
+void OperationThread::setPaused(bool paused) {
+    QMutexLocker locker(&m_pauseMutex);
+    m_paused = paused;
+    if (!m_paused) {
+        m_resumed.wakeAll();
+    }
+}
+
+void OperationThread::cancel() {
+    requestInterruption();
+    // Wake up the worker in case it is paused so that it can notice the interruption
+    QMutexLocker locker(&m_pauseMutex);
+    m_resumed.wakeAll();
+}
+
+bool OperationThread::checkpoint() {
+    QMutexLocker locker(&m_pauseMutex);
+    while (m_paused && !isInterruptionRequested()) {
+        m_resumed.wait(&m_pauseMutex);
+    }
+    return !isInterruptionRequested();
+}
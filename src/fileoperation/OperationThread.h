@@ -0,0 +1,68 @@
+#ifndef OPERATIONTHREAD_H
+#define OPERATIONTHREAD_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include "ProgressTelemetry.h"
+
+/**
+ * @file OperationThread.h
+ * @class OperationThread
+ * @brief Base class for the worker threads that carry out file operations.
+ *
+ * Provides cooperative pausing and cancellation as well as the progress counters
+ * that are sampled by the user interface.
+ */
+class OperationThread : public QThread {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructs an OperationThread.
+     * @param telemetry The progress counters to update; must outlive the thread.
+     * @param parent The parent QObject.
+     */
+    explicit OperationThread(ProgressTelemetry* telemetry, QObject* parent = nullptr);
+
+    /**
+     * @brief Returns the progress counters of this operation.
+     */
+    const ProgressTelemetry* telemetry() const { return m_telemetry; }
+
+    /**
+     * @brief Returns whether the operation is currently paused.
+     */
+    bool isPaused() const;
+
+public slots:
+    /**
+     * @brief Pauses or resumes the operation at the next checkpoint.
+     */
+    void setPaused(bool paused);
+
+    /**
+     * @brief Requests the operation to stop at the next checkpoint.
+     */
+    void cancel();
+
+    signals:
+        void operationFinished();
+        void error(const QString& errorMessage);
+
+protected:
+    /**
+     * @brief Blocks while the operation is paused.
+     * @return false if the operation was canceled and the worker should stop, true otherwise.
+     */
+    bool checkpoint();
+
+    ProgressTelemetry* m_telemetry;
+
+private:
+    mutable QMutex m_pauseMutex;
+    QWaitCondition m_resumed;
+    bool m_paused = false;
+};
+
+#endif // OPERATIONTHREAD_H
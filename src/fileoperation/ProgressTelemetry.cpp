@@ -0,0 +1,112 @@
+#include "ProgressTelemetry.h"
+#include <cmath>
+
+ProgressTelemetry::ProgressTelemetry() : m_lastSampleTime(Clock::now().time_since_epoch().count()) {
+
+}
+
+void ProgressTelemetry::setPlan(const QStringList& files, qint64 totalBytes, int totalFiles) {
+    m_files = files;
+    m_totalBytes = totalBytes;
+    m_totalFiles = totalFiles < 0 ? files.size() : totalFiles;
+    m_lastSampleTime.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    m_hasPlan.store(true, std::memory_order_release);
+}
+
+void ProgressTelemetry::beginFile(int index) {
+    m_currentFile.store(index, std::memory_order_relaxed);
+}
+
+void ProgressTelemetry::addBytes(qint64 bytes) {
+    qint64 done = m_bytesDone.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+    // Only one of the copier threads gets to take a sample per interval
+    Clock::rep now = Clock::now().time_since_epoch().count();
+    Clock::rep last = m_lastSampleTime.load(std::memory_order_relaxed);
+    Clock::duration elapsed(now - last);
+    if (elapsed < SampleInterval) {
+        return;
+    }
+    if (!m_lastSampleTime.compare_exchange_strong(last, now, std::memory_order_relaxed)) {
+        return;
+    }
+
+    qint64 previousBytes = m_lastSampleBytes.exchange(done, std::memory_order_relaxed);
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    double sample = (done - previousBytes) / seconds;
+    double average = m_bytesPerSecond.load(std::memory_order_relaxed);
+    if (average <= 0.0) {
+        average = sample;
+    } else {
+        average = SmoothingFactor * sample + (1.0 - SmoothingFactor) * average;
+    }
+    m_bytesPerSecond.store(average, std::memory_order_relaxed);
+}
+
+void ProgressTelemetry::skipBytes(qint64 bytes) {
+    m_bytesDone.fetch_add(bytes, std::memory_order_relaxed);
+    m_lastSampleBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void ProgressTelemetry::finishFile() {
+    m_filesDone.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ProgressTelemetry::finish() {
+    m_currentFile.store(-1, std::memory_order_relaxed);
+    m_finished.store(true, std::memory_order_release);
+}
+
+QString ProgressTelemetry::currentFile() const {
+    int index = m_currentFile.load(std::memory_order_relaxed);
+    if (!hasPlan() || index < 0 || index >= m_files.size()) {
+        return QString();
+    }
+    return m_files.at(index);
+}
+
+double ProgressTelemetry::bytesPerSecond() const {
+    double average = m_bytesPerSecond.load(std::memory_order_relaxed);
+    if (average <= 0.0 || isFinished()) {
+        return average;
+    }
+    Clock::duration elapsed(Clock::now().time_since_epoch().count() - m_lastSampleTime.load(std::memory_order_relaxed));
+    if (elapsed < SampleInterval) {
+        return average;
+    }
+    // Apply the samples that a stalled copier could not take
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    double sample = (bytesDone() - m_lastSampleBytes.load(std::memory_order_relaxed)) / seconds;
+    double missedSamples = seconds / std::chrono::duration<double>(SampleInterval).count();
+    return sample + (average - sample) * std::pow(1.0 - SmoothingFactor, missedSamples);
+}
+
+qint64 ProgressTelemetry::secondsRemaining() const {
+    double rate = bytesPerSecond();
+    // A stalled operation has no meaningful estimate
+    if (rate < 1.0) {
+        return -1;
+    }
+    qint64 remaining = totalBytes() - bytesDone();
+    if (remaining < 0) {
+        remaining = 0;
+    }
+    return static_cast<qint64>(remaining / rate);
+}
+
+int ProgressTelemetry::percentage() const {
+    if (isFinished()) {
+        return 100;
+    }
+    if (!hasPlan()) {
+        return 0;
+    }
+    if (m_totalBytes <= 0) {
+        // Operations that do not move data, such as deletions, report progress by items
+        if (m_totalFiles <= 0) {
+            return 0;
+        }
+        return static_cast<int>((qint64(filesDone()) * 100) / m_totalFiles);
+    }
+    return static_cast<int>((bytesDone() * 100) / m_totalBytes);
+}
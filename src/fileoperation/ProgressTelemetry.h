@@ -0,0 +1,111 @@
+#ifndef PROGRESSTELEMETRY_H
+#define PROGRESSTELEMETRY_H
+
+#include <QStringList>
+#include <atomic>
+#include <chrono>
+
+/**
+ * @file ProgressTelemetry.h
+ * @class ProgressTelemetry
+ * @brief Shared progress counters for a file operation.
+ *
+ * Copier threads update the counters through lock-free atomics; the user interface samples
+ * them at a fixed rate instead of receiving one queued signal per chunk. This keeps the
+ * signal traffic independent of the size of the files being copied.
+ */
+class ProgressTelemetry {
+public:
+    ProgressTelemetry();
+
+    /**
+     * @brief Sets the list of files that the operation is going to process.
+     * @note Must be called exactly once, before any other counter is updated; the list is read-only afterwards.
+     * @param files The planned files.
+     * @param totalBytes The sum of the sizes of the planned files.
+     * @param totalFiles The number of files that finishFile() counts towards, if it differs from the
+     * number of planned files; e.g., a deletion plans its top-level items but counts every entry below them.
+     */
+    void setPlan(const QStringList& files, qint64 totalBytes, int totalFiles = -1);
+
+    /**
+     * @brief Marks the planned file with the given index as the one currently being processed.
+     * @param index Index into the planned files.
+     */
+    void beginFile(int index);
+
+    /**
+     * @brief Adds to the number of bytes processed and updates the throughput estimate.
+     * @param bytes The number of bytes processed since the last call.
+     */
+    void addBytes(qint64 bytes);
+
+    /**
+     * @brief Adds bytes that did not have to be processed, e.g., because a resumed copy had already copied them.
+     * @note Unlike addBytes(), this does not affect the throughput estimate.
+     */
+    void skipBytes(qint64 bytes);
+
+    /**
+     * @brief Adds to the number of files processed.
+     */
+    void finishFile();
+
+    /**
+     * @brief Marks the whole operation as finished.
+     */
+    void finish();
+
+    qint64 bytesDone() const { return m_bytesDone.load(std::memory_order_relaxed); }
+    qint64 totalBytes() const { return hasPlan() ? m_totalBytes : 0; }
+    int filesDone() const { return m_filesDone.load(std::memory_order_relaxed); }
+    int totalFiles() const { return hasPlan() ? m_totalFiles : 0; }
+    bool hasPlan() const { return m_hasPlan.load(std::memory_order_acquire); }
+    bool isFinished() const { return m_finished.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Returns the file currently being processed, or an empty string.
+     */
+    QString currentFile() const;
+
+    /**
+     * @brief Returns the exponentially weighted moving average of the throughput in bytes per second.
+     *
+     * Samples are taken as bytes are added; if none has been taken for longer than the sample
+     * interval, e.g., because the target has stopped responding, the average is decayed towards
+     * the throughput since the last sample as if samples had been taken all along.
+     */
+    double bytesPerSecond() const;
+
+    /**
+     * @brief Returns the estimated number of seconds until the operation is finished, or -1 if unknown.
+     */
+    qint64 secondsRemaining() const;
+
+    /**
+     * @brief Returns the progress in percent.
+     */
+    int percentage() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::chrono::milliseconds SampleInterval{250}; /**< Minimum time between throughput samples. */
+    static constexpr double SmoothingFactor = 0.3; /**< Weight of the newest throughput sample. */
+
+    QStringList m_files; /**< The planned files; immutable while copier threads are running. */
+    qint64 m_totalBytes = 0;
+    int m_totalFiles = 0;
+
+    std::atomic<qint64> m_bytesDone{0};
+    std::atomic<int> m_filesDone{0};
+    std::atomic<int> m_currentFile{-1};
+    std::atomic<bool> m_finished{false};
+    std::atomic<bool> m_hasPlan{false}; /**< Publishes m_files and m_totalBytes to the sampling thread. */
+
+    std::atomic<Clock::rep> m_lastSampleTime;
+    std::atomic<qint64> m_lastSampleBytes{0};
+    std::atomic<double> m_bytesPerSecond{0.0};
+};
+
+#endif // PROGRESSTELEMETRY_H
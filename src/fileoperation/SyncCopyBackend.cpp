@@ -0,0 +1,215 @@
+#include "SyncCopyBackend.h"
+#include "HashPipeline.h"
+#include "Vfs.h"
+#include <QFile>
+#include <QObject>
+#include <QDebug>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+
+bool SyncCopyBackend::copyFiles(const QVector<FileCopyRequest>& files, CopyObserver* observer) {
+    static_assert(BufferSize == HashPipeline::BlockSize, "Chunks must be hash blocks");
+    m_errorString.clear();
+    m_buffers = QByteArray(BufferCount * BufferSize, Qt::Uninitialized);
+
+    bool succeeded = true;
+    for (int i = 0; i < files.size() && succeeded; i++) {
+        if (!observer->shouldContinue()) {
+            succeeded = false;
+            break;
+        }
+        observer->fileStarted(i);
+        if (!copyFile(i, files.at(i), observer)) {
+            succeeded = false;
+        }
+    }
+
+    // The buffers must not go away while they are being hashed
+    if (m_hashPipeline) {
+        m_hashPipeline->clear();
+    }
+    return succeeded;
+}
+
+// Returns a buffer that the hash pipeline is done with
+char* SyncCopyBackend::nextBuffer(int& tag) {
+    tag = m_nextBuffer;
+    m_nextBuffer = (m_nextBuffer + 1) % BufferCount;
+    while (m_busy[tag]) {
+        for (int released : m_hashPipeline->takeReleased()) {
+            m_busy[released] = false;
+        }
+        if (m_busy[tag]) {
+            m_hashPipeline->waitForReleased();
+        }
+    }
+    return m_buffers.data() + tag * BufferSize;
+}
+
+bool SyncCopyBackend::copyFile(int index, const FileCopyRequest& file, CopyObserver* observer) {
+    QByteArray sourcePath = QFile::encodeName(file.sourcePath);
+    QByteArray targetPath = QFile::encodeName(file.targetPath);
+    Vfs* vfs = Vfs::instance();
+
+    vfs->account(Vfs::Open);
+    int sourceFd = ::open(sourcePath.constData(), O_RDONLY | O_CLOEXEC);
+    if (sourceFd < 0) {
+        m_errorString = QObject::tr("Cannot read %1: %2").arg(file.sourcePath, QString::fromLocal8Bit(strerror(errno)));
+        return false;
+    }
+    struct stat sourceStat;
+    if (::fstat(sourceFd, &sourceStat) != 0) {
+        m_errorString = QObject::tr("Cannot read %1: %2").arg(file.sourcePath, QString::fromLocal8Bit(strerror(errno)));
+        ::close(sourceFd);
+        return false;
+    }
+
+    // The hash covers the whole file, so a file that is hashed cannot be continued
+    qint64 resumeOffset = m_hashPipeline ? 0 : file.resumeOffset;
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+    if (resumeOffset == 0) {
+        flags |= O_TRUNC;
+    }
+    vfs->account(Vfs::Open);
+    int targetFd = ::open(targetPath.constData(), flags, sourceStat.st_mode & 07777);
+    if (targetFd < 0) {
+        m_errorString = QObject::tr("Cannot write %1: %2").arg(file.targetPath, QString::fromLocal8Bit(strerror(errno)));
+        ::close(sourceFd);
+        return false;
+    }
+
+    // Continue a partial target; whatever lies beyond the last synced offset may be garbage
+    qint64 offset = truncateForResume(targetFd, resumeOffset);
+    if (offset < 0) {
+        m_errorString = QObject::tr("Failed to write %1: %2").arg(file.targetPath, QString::fromLocal8Bit(strerror(errno)));
+        ::close(sourceFd);
+        ::close(targetFd);
+        return false;
+    }
+    if (offset > 0) {
+        observer->bytesSkipped(offset);
+    }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    ::posix_fadvise(sourceFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    // Holes are skipped in whole chunks and left unwritten, which recreates them in the target
+    bool sparse = isSparse(sourceStat.st_size, sourceStat.st_blocks);
+    qint64 dataEnd = 0;
+
+    bool succeeded = true;
+    qint64 unsyncedBytes = 0;
+    for (;;) {
+        if (sparse && offset >= dataEnd) {
+            qint64 dataStart = nextDataRange(sourceFd, offset, sourceStat.st_size, &dataEnd);
+            qint64 holeEnd = dataStart >= sourceStat.st_size ? sourceStat.st_size : dataStart - dataStart % BufferSize;
+            if (holeEnd > offset) {
+                skipHole(index, offset, holeEnd, observer);
+                offset = holeEnd;
+            }
+            if (offset >= sourceStat.st_size) {
+                break;
+            }
+        }
+
+        int tag;
+        char* buffer = nextBuffer(tag);
+
+        // Read whole chunks; the hash pipeline needs blocks that start at multiples of BufferSize
+        qint64 bytesRead = 0;
+        while (bytesRead < BufferSize) {
+            ssize_t result = ::pread(sourceFd, buffer + bytesRead, BufferSize - bytesRead, offset + bytesRead);
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (result < 0) {
+                m_errorString = QObject::tr("Failed to read %1: %2").arg(file.sourcePath, QString::fromLocal8Bit(strerror(errno)));
+                succeeded = false;
+            }
+            if (result <= 0) {
+                break;
+            }
+            bytesRead += result;
+        }
+        if (!succeeded || bytesRead == 0) {
+            break;
+        }
+        vfs->account(Vfs::Read, bytesRead);
+
+        if (m_hashPipeline) {
+            m_busy[tag] = true;
+            m_hashPipeline->submit(index, offset, buffer, bytesRead, tag);
+        }
+
+        qint64 written = 0;
+        while (written < bytesRead) {
+            ssize_t result = ::pwrite(targetFd, buffer + written, bytesRead - written, offset + written);
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (result < 0) {
+                m_errorString = QObject::tr("Failed to write %1: %2").arg(file.targetPath, QString::fromLocal8Bit(strerror(errno)));
+                succeeded = false;
+                break;
+            }
+            written += result;
+        }
+        if (!succeeded) {
+            break;
+        }
+        vfs->account(Vfs::Write, written);
+        observer->bytesCopied(bytesRead);
+        offset += bytesRead;
+
+        unsyncedBytes += bytesRead;
+        if (m_syncInterval > 0 && unsyncedBytes >= m_syncInterval) {
+            if (flushTarget(targetFd, offset)) {
+                observer->fileSynced(index, offset);
+            }
+            unsyncedBytes = 0;
+        }
+
+        if (!observer->shouldContinue()) {
+            qDebug() << "SyncCopyBackend: Interruption requested. Cleaning up and exiting...";
+            succeeded = false;
+            break;
+        }
+        if (bytesRead < BufferSize) {
+            break;
+        }
+    }
+
+    // A hole at the end of the source leaves the target short
+    if (succeeded && sparse && ::ftruncate(targetFd, sourceStat.st_size) != 0) {
+        m_errorString = QObject::tr("Failed to write %1: %2").arg(file.targetPath, QString::fromLocal8Bit(strerror(errno)));
+        succeeded = false;
+    }
+
+    // Set permissions; the mode passed to open() is subject to the umask
+    if (succeeded) {
+        ::fchmod(targetFd, sourceStat.st_mode & 07777);
+    }
+    if (succeeded && m_syncInterval > 0 && ::fdatasync(targetFd) != 0) {
+        m_errorString = QObject::tr("Failed to write %1: %2").arg(file.targetPath, QString::fromLocal8Bit(strerror(errno)));
+        succeeded = false;
+    }
+
+    ::close(sourceFd);
+    if (::close(targetFd) != 0 && succeeded) {
+        m_errorString = QObject::tr("Failed to write %1: %2").arg(file.targetPath, QString::fromLocal8Bit(strerror(errno)));
+        succeeded = false;
+    }
+    if (!succeeded) {
+        if (!m_keepPartialFiles) {
+            ::unlink(targetPath.constData());
+        }
+        return false;
+    }
+
+    observer->fileFinished(index, m_hashPipeline ? m_hashPipeline->result(index) : QByteArray());
+    return true;
+}
@@ -0,0 +1,32 @@
+#ifndef SYNCCOPYBACKEND_H
+#define SYNCCOPYBACKEND_H
+
+#include "CopyBackend.h"
+#include <QByteArray>
+
+/**
+ * @file SyncCopyBackend.h
+ * @class SyncCopyBackend
+ * @brief Copies one file after another with a synchronous read/write loop.
+ *
+ * When hashing, the buffers rotate so that the next block can be read and written
+ * while the hash pipeline is still busy with the previous ones.
+ */
+class SyncCopyBackend : public CopyBackend {
+public:
+    QString name() const override { return QStringLiteral("sync"); }
+    bool copyFiles(const QVector<FileCopyRequest>& files, CopyObserver* observer) override;
+
+private:
+    static const int BufferCount = 4;
+    static const qint64 BufferSize = 256 * 1024;
+
+    bool copyFile(int index, const FileCopyRequest& file, CopyObserver* observer);
+    char* nextBuffer(int& tag);
+
+    QByteArray m_buffers;
+    bool m_busy[BufferCount] = {}; /**< Whether the hash pipeline still reads from the buffer. */
+    int m_nextBuffer = 0;
+};
+
+#endif // SYNCCOPYBACKEND_H
@@ -0,0 +1,527 @@
+#include "UringCopyBackend.h"
+#include "HashPipeline.h"
+
+#ifdef HAVE_LIBURING
+
+#include <QFile>
+#include <QObject>
+#include <QDebug>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/uio.h>
+
+UringCopyBackend::UringCopyBackend() {
+    if (io_uring_queue_init(QueueDepth, &m_ring, 0) != 0) {
+        qDebug() << "UringCopyBackend: Cannot set up the ring";
+        return;
+    }
+
+    m_buffers = QByteArray(BufferCount * BufferSize, Qt::Uninitialized);
+    QVector<struct iovec> iovecs(BufferCount);
+    for (int i = 0; i < BufferCount; i++) {
+        iovecs[i].iov_base = m_buffers.data() + static_cast<size_t>(i) * BufferSize;
+        iovecs[i].iov_len = BufferSize;
+    }
+    // Registering pins the buffers; this can fail if the locked memory limit is low
+    int result = io_uring_register_buffers(&m_ring, iovecs.constData(), iovecs.size());
+    if (result != 0) {
+        qDebug() << "UringCopyBackend: Cannot register buffers:" << strerror(-result);
+        io_uring_queue_exit(&m_ring);
+        return;
+    }
+    m_chunks.resize(BufferCount);
+    m_valid = true;
+}
+
+UringCopyBackend::~UringCopyBackend() {
+    if (m_valid) {
+        io_uring_unregister_buffers(&m_ring);
+        io_uring_queue_exit(&m_ring);
+    }
+}
+
+bool UringCopyBackend::isSupported() {
+    static const bool supported = []() {
+        struct io_uring_probe* probe = io_uring_get_probe();
+        if (!probe) {
+            return false;
+        }
+        bool result = io_uring_opcode_supported(probe, IORING_OP_OPENAT)
+                      && io_uring_opcode_supported(probe, IORING_OP_STATX)
+                      && io_uring_opcode_supported(probe, IORING_OP_READ_FIXED)
+                      && io_uring_opcode_supported(probe, IORING_OP_WRITE_FIXED);
+        io_uring_free_probe(probe);
+        return result;
+    }();
+    return supported;
+}
+
+bool UringCopyBackend::copyFiles(const QVector<FileCopyRequest>& files, CopyObserver* observer) {
+    static_assert(BufferSize == HashPipeline::BlockSize, "Chunks must be hash blocks");
+    m_errorString.clear();
+    m_stopping = false;
+    m_finishedFiles = 0;
+    m_openFiles.clear();
+    m_freeBuffers.clear();
+    for (int i = BufferCount - 1; i >= 0; i--) {
+        m_freeBuffers.append(i);
+    }
+
+    // Sized once; the ring refers to the states by address while they are in flight
+    m_files = QVector<FileState>(files.size());
+    for (int i = 0; i < files.size(); i++) {
+        m_files[i].index = i;
+        m_files[i].sourcePath = QFile::encodeName(files.at(i).sourcePath);
+        m_files[i].targetPath = QFile::encodeName(files.at(i).targetPath);
+        // The hash covers the whole file, so a file that is hashed cannot be continued
+        m_files[i].resumeOffset = m_hashPipeline ? 0 : files.at(i).resumeOffset;
+    }
+
+    int nextFile = 0;
+    while (m_finishedFiles < m_files.size()) {
+        if (!observer->shouldContinue()) {
+            qDebug() << "UringCopyBackend: Interruption requested. Cleaning up and exiting...";
+            m_stopping = true;
+            break;
+        }
+        if (m_hashPipeline) {
+            m_freeBuffers += m_hashPipeline->takeReleased();
+        }
+
+        while (m_openFiles.size() < MaxOpenFiles && nextFile < m_files.size()) {
+            FileState* file = &m_files[nextFile++];
+            m_openFiles.append(file);
+            submitOpenSource(file);
+        }
+        submitChunks(observer);
+        if (!m_errorString.isEmpty()) {
+            break;
+        }
+        bool hashing = m_hashPipeline && m_hashPipeline->isBusy();
+        if (m_inFlight == 0) {
+            if (hashing) {
+                m_hashPipeline->waitForReleased();
+                continue;
+            }
+            // The hash worker may have released the last buffers after they were taken above
+            if (m_hashPipeline && m_freeBuffers.isEmpty()) {
+                m_freeBuffers += m_hashPipeline->takeReleased();
+                if (!m_freeBuffers.isEmpty()) {
+                    continue;
+                }
+            }
+            if (m_finishedFiles < m_files.size()) {
+                m_errorString = QObject::tr("Failed to copy: %1 files were left unfinished").arg(m_files.size() - m_finishedFiles);
+            }
+            break;
+        }
+
+        int result;
+        if (hashing && m_freeBuffers.isEmpty()) {
+            // Buffers come back from the hash pipeline as well, so do not sleep on the ring for long
+            io_uring_submit(&m_ring);
+            struct __kernel_timespec timeout = {0, 1000000};
+            struct io_uring_cqe* cqe;
+            result = io_uring_wait_cqe_timeout(&m_ring, &cqe, &timeout);
+            if (result == -ETIME) {
+                result = 0;
+            }
+        } else {
+            result = io_uring_submit_and_wait(&m_ring, 1);
+        }
+        if (result < 0 && result != -EINTR) {
+            m_errorString = QObject::tr("Failed to copy: %1").arg(QString::fromLocal8Bit(strerror(-result)));
+            break;
+        }
+        reapCompletions(observer);
+        if (m_stopping || !m_errorString.isEmpty()) {
+            break;
+        }
+    }
+
+    // Wait for everything that is still in flight before closing the files it refers to
+    while (m_inFlight > 0) {
+        int result = io_uring_submit_and_wait(&m_ring, 1);
+        if (result < 0 && result != -EINTR) {
+            break;
+        }
+        reapCompletions(observer);
+    }
+    for (FileState* file : m_openFiles) {
+        abandonFile(file);
+    }
+    // The buffers must not be reused while they are being hashed
+    if (m_hashPipeline) {
+        m_hashPipeline->clear();
+    }
+    bool finished = m_finishedFiles == m_files.size();
+    m_openFiles.clear();
+    m_files.clear();
+
+    return finished && !m_stopping && m_errorString.isEmpty();
+}
+
+// Makes room for entries that must end up in the same submission, e.g., the two halves of a link
+bool UringCopyBackend::reserveSqes(unsigned count) {
+    if (io_uring_sq_space_left(&m_ring) >= count) {
+        return true;
+    }
+    int result = io_uring_submit(&m_ring);
+    if (io_uring_sq_space_left(&m_ring) >= count) {
+        return true;
+    }
+    m_errorString = QObject::tr("Failed to copy: %1").arg(QString::fromLocal8Bit(strerror(result < 0 ? -result : EBUSY)));
+    return false;
+}
+
+// Returns nullptr and fails the copy if the ring is full; callers reserve their entries first
+struct io_uring_sqe* UringCopyBackend::nextSqe() {
+    struct io_uring_sqe* sqe = io_uring_get_sqe(&m_ring);
+    if (!sqe) {
+        m_errorString = QObject::tr("Failed to copy: %1").arg(QString::fromLocal8Bit(strerror(EBUSY)));
+        return nullptr;
+    }
+    m_inFlight++;
+    return sqe;
+}
+
+void UringCopyBackend::submitOpenSource(FileState* file) {
+    struct io_uring_sqe* sqe = reserveSqes(2) ? nextSqe() : nullptr;
+    if (!sqe) {
+        return;
+    }
+    io_uring_prep_openat(sqe, AT_FDCWD, file->sourcePath.constData(), O_RDONLY | O_CLOEXEC, 0);
+    setUserData(sqe, OpenSource, file->index);
+
+    sqe = nextSqe();
+    io_uring_prep_statx(sqe, AT_FDCWD, file->sourcePath.constData(), 0, STATX_MODE | STATX_SIZE | STATX_BLOCKS, &file->sourceStat);
+    setUserData(sqe, StatSource, file->index);
+
+    file->pendingOperations += 2;
+}
+
+void UringCopyBackend::submitOpenTarget(FileState* file) {
+    int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+    if (file->resumeOffset == 0) {
+        flags |= O_TRUNC;
+    }
+    struct io_uring_sqe* sqe = reserveSqes(1) ? nextSqe() : nullptr;
+    if (!sqe) {
+        return;
+    }
+    io_uring_prep_openat(sqe, AT_FDCWD, file->targetPath.constData(), flags, file->sourceStat.stx_mode & 07777);
+    setUserData(sqe, OpenTarget, file->index);
+    file->pendingOperations++;
+}
+
+// Hands out the free buffers to the open files in plan order, one linked read→write pair per chunk
+void UringCopyBackend::submitChunks(CopyObserver* observer) {
+    // Iterate over a copy; files that turn out to end in a hole are finished right here
+    const QVector<FileState*> openFiles = m_openFiles;
+    for (FileState* file : openFiles) {
+        if (file->stage != Copying) {
+            continue;
+        }
+        while (file->nextOffset < file->size && !m_freeBuffers.isEmpty()) {
+            // Holes are skipped in whole chunks and left unwritten, which recreates them in the target
+            if (file->sparse && file->nextOffset >= file->dataEnd) {
+                qint64 dataStart = nextDataRange(file->sourceFd, file->nextOffset, file->size, &file->dataEnd);
+                qint64 holeEnd = dataStart >= file->size ? file->size : dataStart - dataStart % BufferSize;
+                if (holeEnd > file->nextOffset) {
+                    skipHole(file->index, file->nextOffset, holeEnd, observer);
+                    file->nextOffset = holeEnd;
+                }
+                if (file->nextOffset >= file->size) {
+                    break;
+                }
+            }
+
+            // The two halves of a link must end up in the same submission
+            if (!reserveSqes(2)) {
+                return;
+            }
+
+            int buffer = m_freeBuffers.takeLast();
+            Chunk& chunk = m_chunks[buffer];
+            chunk.file = file;
+            chunk.offset = file->nextOffset;
+            chunk.length = static_cast<unsigned>(qMin<qint64>(BufferSize, file->size - file->nextOffset));
+            chunk.readResult = 0;
+            chunk.active = true;
+            char* data = bufferData(buffer);
+
+            struct io_uring_sqe* sqe = nextSqe();
+            io_uring_prep_read_fixed(sqe, file->sourceFd, data, chunk.length, chunk.offset, buffer);
+            sqe->flags |= IOSQE_IO_LINK;
+            setUserData(sqe, Read, buffer);
+
+            sqe = nextSqe();
+            io_uring_prep_write_fixed(sqe, file->targetFd, data, chunk.length, chunk.offset, buffer);
+            setUserData(sqe, Write, buffer);
+
+            file->nextOffset += chunk.length;
+            file->pendingOperations += 2;
+        }
+        if (file->nextOffset >= file->size && file->pendingOperations == 0) {
+            finishFile(file, observer);
+        }
+        if (m_freeBuffers.isEmpty()) {
+            break;
+        }
+    }
+}
+
+void UringCopyBackend::reapCompletions(CopyObserver* observer) {
+    struct io_uring_cqe* cqe;
+    unsigned head;
+    unsigned count = 0;
+    io_uring_for_each_cqe(&m_ring, head, cqe) {
+        count++;
+        handleCompletion(cqe->user_data, cqe->res, observer);
+    }
+    io_uring_cq_advance(&m_ring, count);
+}
+
+void UringCopyBackend::handleCompletion(quint64 userData, int result, CopyObserver* observer) {
+    Operation operation = static_cast<Operation>(userData >> 32);
+    int index = static_cast<int>(userData & 0xffffffff);
+    m_inFlight--;
+
+    // Bookkeeping that must happen even while stopping, so that nothing leaks
+    FileState* file = (operation == Read || operation == Write) ? m_chunks.at(index).file : &m_files[index];
+    file->pendingOperations--;
+    switch (operation) {
+    case OpenSource:
+        if (result >= 0) {
+            file->sourceFd = result;
+        }
+        break;
+    case OpenTarget:
+        if (result >= 0) {
+            file->targetFd = result;
+        }
+        break;
+    case Write:
+        m_chunks[index].active = false;
+        break;
+    default:
+        break;
+    }
+
+    if (m_stopping || !m_errorString.isEmpty()) {
+        if (operation == Write) {
+            m_freeBuffers.append(index);
+        }
+        return;
+    }
+
+    switch (operation) {
+    case OpenSource:
+        if (result < 0) {
+            fail(QObject::tr("Cannot read %1: %2"), file->sourcePath, -result);
+        } else if (file->sourceStatDone) {
+            submitOpenTarget(file);
+        }
+        break;
+    case StatSource:
+        if (result < 0) {
+            fail(QObject::tr("Cannot read %1: %2"), file->sourcePath, -result);
+            break;
+        }
+        // The file may have changed since the plan was made; copy what is there now
+        file->sourceStatDone = true;
+        file->size = static_cast<qint64>(file->sourceStat.stx_size);
+        file->sparse = isSparse(file->size, static_cast<qint64>(file->sourceStat.stx_blocks));
+        if (file->sourceFd >= 0) {
+            submitOpenTarget(file);
+        }
+        break;
+    case OpenTarget:
+        if (result < 0) {
+            fail(QObject::tr("Cannot write %1: %2"), file->targetPath, -result);
+            break;
+        }
+        file->stage = Copying;
+        observer->fileStarted(file->index);
+        if (file->resumeOffset > 0) {
+            // Continue a partial target; whatever lies beyond the last synced offset may be garbage
+            file->nextOffset = truncateForResume(file->targetFd, file->resumeOffset);
+            if (file->nextOffset < 0) {
+                fail(QObject::tr("Failed to write %1: %2"), file->targetPath, errno);
+                break;
+            }
+            if (file->nextOffset > 0) {
+                observer->bytesSkipped(file->nextOffset);
+            }
+        }
+        // Sparse files are checked for holes before their first chunk is submitted
+        if (file->nextOffset >= file->size && !file->sparse) {
+            finishFile(file, observer);
+        }
+        break;
+    case Read:
+        m_chunks[index].readResult = result;
+        if (result < 0) {
+            fail(QObject::tr("Failed to read %1: %2"), file->sourcePath, -result);
+        }
+        break;
+    case Write:
+        // The chunk is settled without submitting anything, so the buffer can be reused right away
+        // unless it is still to be hashed
+        if (!finishChunk(index, result, observer)) {
+            m_freeBuffers.append(index);
+        }
+        break;
+    }
+}
+
+// Returns true if the buffer was handed to the hash pipeline, which releases it later
+bool UringCopyBackend::finishChunk(int buffer, int writeResult, CopyObserver* observer) {
+    const Chunk& chunk = m_chunks.at(buffer);
+    FileState* file = chunk.file;
+    qint64 copied = writeResult;
+
+    if (writeResult == -ECANCELED && chunk.readResult >= 0) {
+        // A short read breaks the link; finish the chunk synchronously
+        copied = copyRemainder(buffer, 0);
+    } else if (writeResult < 0) {
+        fail(QObject::tr("Failed to write %1: %2"), file->targetPath, -writeResult);
+        return false;
+    } else if (static_cast<unsigned>(writeResult) < chunk.length) {
+        copied = copyRemainder(buffer, writeResult);
+    }
+    if (copied < 0) {
+        return false;
+    }
+
+    // Chunks start at multiples of the block size as long as files are not continued
+    if (m_hashPipeline) {
+        m_hashPipeline->submit(file->index, chunk.offset, bufferData(buffer), copied, buffer);
+    }
+
+    observer->bytesCopied(copied);
+    file->unsyncedBytes += copied;
+    if (m_syncInterval > 0 && file->unsyncedBytes >= m_syncInterval) {
+        syncFile(file, observer);
+    }
+    if (file->nextOffset >= file->size && file->pendingOperations == 0) {
+        finishFile(file, observer);
+    }
+    return m_hashPipeline != nullptr;
+}
+
+// Chunks complete out of order, so only the part of the target below the first chunk
+// that is still in flight is known to be complete
+void UringCopyBackend::syncFile(FileState* file, CopyObserver* observer) {
+    qint64 completeUpTo = file->nextOffset;
+    for (const Chunk& chunk : qAsConst(m_chunks)) {
+        if (chunk.active && chunk.file == file) {
+            completeUpTo = qMin(completeUpTo, chunk.offset);
+        }
+    }
+    if (flushTarget(file->targetFd, completeUpTo)) {
+        observer->fileSynced(file->index, completeUpTo);
+    }
+    file->unsyncedBytes = 0;
+}
+
+// Copies the part of a chunk that io_uring did not, starting at the given number of bytes into it.
+// Returns the number of bytes of the chunk that ended up in the target, or -1 on error.
+qint64 UringCopyBackend::copyRemainder(int buffer, qint64 done) {
+    const Chunk& chunk = m_chunks.at(buffer);
+    char* data = bufferData(buffer);
+    qint64 available = qMax(chunk.readResult, 0);
+
+    while (done < chunk.length) {
+        if (done >= available) {
+            ssize_t bytesRead = ::pread(chunk.file->sourceFd, data + available,
+                                        chunk.length - available, chunk.offset + available);
+            if (bytesRead < 0 && errno == EINTR) {
+                continue;
+            }
+            if (bytesRead < 0) {
+                fail(QObject::tr("Failed to read %1: %2"), chunk.file->sourcePath, errno);
+                return -1;
+            }
+            if (bytesRead == 0) {
+                // The source shrank while we were copying it
+                break;
+            }
+            available += bytesRead;
+        }
+        ssize_t written = ::pwrite(chunk.file->targetFd, data + done, available - done, chunk.offset + done);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0) {
+            fail(QObject::tr("Failed to write %1: %2"), chunk.file->targetPath, errno);
+            return -1;
+        }
+        done += written;
+    }
+    return done;
+}
+
+void UringCopyBackend::finishFile(FileState* file, CopyObserver* observer) {
+    // A hole at the end of the source leaves the target short
+    if (file->sparse && ::ftruncate(file->targetFd, file->size) != 0) {
+        fail(QObject::tr("Failed to write %1: %2"), file->targetPath, errno);
+        return;
+    }
+
+    // Set permissions; the mode passed to openat is subject to the umask
+    ::fchmod(file->targetFd, file->sourceStat.stx_mode & 07777);
+    if (m_syncInterval > 0 && ::fdatasync(file->targetFd) != 0) {
+        fail(QObject::tr("Failed to write %1: %2"), file->targetPath, errno);
+        return;
+    }
+    ::close(file->sourceFd);
+    file->sourceFd = -1;
+    int result = ::close(file->targetFd);
+    file->targetFd = -1;
+    if (result != 0) {
+        fail(QObject::tr("Failed to write %1: %2"), file->targetPath, errno);
+        if (!m_keepPartialFiles) {
+            ::unlink(file->targetPath.constData());
+        }
+        return;
+    }
+
+    file->stage = Done;
+    m_openFiles.removeOne(file);
+    m_finishedFiles++;
+    observer->fileFinished(file->index, m_hashPipeline ? m_hashPipeline->result(file->index) : QByteArray());
+}
+
+// Closes a file that was not copied completely and removes the partial target unless it is to be kept
+void UringCopyBackend::abandonFile(FileState* file) {
+    if (file->sourceFd >= 0) {
+        ::close(file->sourceFd);
+        file->sourceFd = -1;
+    }
+    if (file->targetFd >= 0) {
+        ::close(file->targetFd);
+        file->targetFd = -1;
+        if (!m_keepPartialFiles) {
+            ::unlink(file->targetPath.constData());
+        }
+    }
+}
+
+void UringCopyBackend::fail(const QString& message, const QByteArray& path, int error) {
+    if (m_errorString.isEmpty()) {
+        m_errorString = message.arg(QFile::decodeName(path), QString::fromLocal8Bit(strerror(error)));
+    }
+}
+
+char* UringCopyBackend::bufferData(int buffer) {
+    return m_buffers.data() + static_cast<size_t>(buffer) * BufferSize;
+}
+
+void UringCopyBackend::setUserData(struct io_uring_sqe* sqe, Operation operation, int index) {
+    sqe->user_data = (static_cast<quint64>(operation) << 32) | static_cast<quint32>(index);
+}
+
+#endif // HAVE_LIBURING
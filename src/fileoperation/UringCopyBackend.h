@@ -0,0 +1,108 @@
+#ifndef URINGCOPYBACKEND_H
+#define URINGCOPYBACKEND_H
+
+#include "CopyBackend.h"
+
+#ifdef HAVE_LIBURING
+
+#include <QByteArray>
+#include <QVector>
+#include <liburing.h>
+#include <sys/stat.h>
+
+/**
+ * @file UringCopyBackend.h
+ * @class UringCopyBackend
+ * @brief Copies files through io_uring, keeping many reads and writes in flight.
+ *
+ * Several files are open at the same time. Each chunk is read into one of a set of registered
+ * buffers and written from it by a read→write pair of linked submissions, so the data never has to
+ * be handed back to this thread in between. Files are opened and examined with IORING_OP_OPENAT and
+ * IORING_OP_STATX so that small files do not serialize on metadata system calls.
+ */
+class UringCopyBackend : public CopyBackend {
+public:
+    UringCopyBackend();
+    ~UringCopyBackend() override;
+
+    /**
+     * @brief Returns whether the running kernel supports all operations this backend needs.
+     */
+    static bool isSupported();
+
+    /**
+     * @brief Returns whether the ring and the buffers were set up successfully.
+     */
+    bool isValid() const { return m_valid; }
+
+    QString name() const override { return QStringLiteral("io_uring"); }
+    bool copyFiles(const QVector<FileCopyRequest>& files, CopyObserver* observer) override;
+
+private:
+    enum Operation { OpenSource, StatSource, OpenTarget, Read, Write };
+
+    enum Stage { Opening, Copying, Done };
+
+    struct FileState {
+        int index;
+        Stage stage = Opening;
+        QByteArray sourcePath;
+        QByteArray targetPath;
+        int sourceFd = -1;
+        int targetFd = -1;
+        struct statx sourceStat;
+        bool sourceStatDone = false;
+        qint64 size = 0;
+        qint64 nextOffset = 0; /**< Offset of the next chunk to be submitted. */
+        qint64 resumeOffset = 0;
+        qint64 unsyncedBytes = 0;
+        bool sparse = false;
+        qint64 dataEnd = 0; /**< End of the range of the source that holds data, if sparse. */
+        int pendingOperations = 0; /**< Submissions whose completions have not been reaped yet. */
+    };
+
+    struct Chunk {
+        FileState* file;
+        qint64 offset;
+        unsigned length;
+        int readResult;
+        bool active = false; /**< Whether the chunk is in flight. */
+    };
+
+    static const int QueueDepth = 128;
+    static const int BufferCount = 32;
+    static const unsigned BufferSize = 256 * 1024; /**< Equal to HashPipeline::BlockSize. */
+    static const int MaxOpenFiles = 16;
+
+    bool reserveSqes(unsigned count);
+    struct io_uring_sqe* nextSqe();
+    void submitOpenSource(FileState* file);
+    void submitOpenTarget(FileState* file);
+    void submitChunks(CopyObserver* observer);
+    void reapCompletions(CopyObserver* observer);
+    void handleCompletion(quint64 userData, int result, CopyObserver* observer);
+    bool finishChunk(int buffer, int writeResult, CopyObserver* observer);
+    void syncFile(FileState* file, CopyObserver* observer);
+    qint64 copyRemainder(int buffer, qint64 done);
+    void finishFile(FileState* file, CopyObserver* observer);
+    void abandonFile(FileState* file);
+    void fail(const QString& message, const QByteArray& path, int error);
+    char* bufferData(int buffer);
+
+    static void setUserData(struct io_uring_sqe* sqe, Operation operation, int index);
+
+    struct io_uring m_ring;
+    bool m_valid = false;
+    QByteArray m_buffers;
+    QVector<int> m_freeBuffers;
+    QVector<Chunk> m_chunks; /**< Indexed by buffer. */
+    QVector<FileState*> m_openFiles; /**< Files that are being opened or copied, in plan order. */
+    QVector<FileState> m_files;
+    int m_inFlight = 0; /**< Submissions whose completions have not been reaped yet. */
+    int m_finishedFiles = 0;
+    bool m_stopping = false; /**< Set when the observer asked to stop. */
+};
+
+#endif // HAVE_LIBURING
+
+#endif // URINGCOPYBACKEND_H
@@ -5,64 +5,83 @@
 #include <QDesktopWidget>
 #include <QTranslator>
 #include "MainWindow.h"
-#include <QMessageBox>
-#include <QFile>
-#include <QDir>
+#include "JobsWindow.h"
+#include "FileOperationService.h"
+#include "Trace.h"
+#include <QFileInfo>
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
     QApplication::setApplicationName("fileoperation");
 
+    // Write the trace spans at exit next to the trace of Filer, which sets FILER_TRACE for both
+    if (qEnvironmentVariableIsSet("FILER_TRACE")) {
+        QFileInfo filerTrace(QString::fromLocal8Bit(qgetenv("FILER_TRACE")));
+        QString tracePath = filerTrace.absolutePath() + "/" + filerTrace.completeBaseName() + "-fileoperation.json";
+        QObject::connect(&a, &QCoreApplication::aboutToQuit, [tracePath]() {
+            Trace::writeChromeTrace(tracePath);
+        });
+    }
+
     QDesktopWidget desktop;
 
     QCommandLineParser parser;
-    parser.setApplicationDescription("A command line tool for copying and moving files with a graphical progress dialog.");
+    parser.setApplicationDescription("A command line tool for copying, moving and deleting files with a graphical progress window.");
     parser.addHelpOption();
     parser.addVersionOption();
 
     // Define custom options
     QCommandLineOption copyOption("copy", "Copy files.");
     QCommandLineOption moveOption("move", "Move files.");
+    QCommandLineOption deleteOption("delete", "Permanently delete files.");
+    QCommandLineOption daemonOption("daemon", "Keep running and accept jobs over D-Bus.");
+    QCommandLineOption resumeOption("resume", "Resume an interrupted copy or move from its journal.", "journal");
+    QCommandLineOption verifyOption("verify", "Check copied files against hashes of their sources by reading them back; moves always do this.");
+    QCommandLineOption verifyCompletedOption("verify-completed", "When resuming, compare the contents of files that were already copied instead of their size and modification time.");
     parser.addOption(copyOption);
     parser.addOption(moveOption);
+    parser.addOption(deleteOption);
+    parser.addOption(daemonOption);
+    parser.addOption(resumeOption);
+    parser.addOption(verifyOption);
+    parser.addOption(verifyCompletedOption);
 
     // Process the command line arguments
     parser.process(a); // Use 'a' instead of 'app'
 
-    if (parser.isSet("copy")) {
-        qDebug() << "Copying files...";
-        QStringList args = parser.positionalArguments();
-        if (args.size() < 2) {
-            qWarning() << "Usage: --copy <source path> [<source path> ...] <target path>";
+    QStringList args = parser.positionalArguments();
+    MainWindow w;
+    w.jobQueue()->setVerifyCopies(parser.isSet("verify"));
+
+    // When running as a service, Filer submits jobs over D-Bus instead of starting
+    // a new fileoperation process for each of them
+    FileOperationService service(w.jobQueue());
+    if (parser.isSet("daemon")) {
+        if (!service.registerService()) {
             return 1;
         }
-        QString targetPath = args.last();
-        args.removeLast(); // Remove the target path from the list
-        qDebug() << "Source paths:" << args;
-        qDebug() << "Target path:" << targetPath;
-
-        // Perform the copy operation
-        MainWindow w;
-        w.startCopyWithProgress(args, targetPath);
-
-        // Center the main window on the screen
-        w.setGeometry(
-                QStyle::alignedRect(
-                        Qt::LeftToRight,
-                        Qt::AlignCenter,
-                        w.size(),
-                        desktop.availableGeometry() // Get screen geometry
-                )
-        );
+        a.setQuitOnLastWindowClosed(false);
+        // Quit after 10 minutes without jobs; Filer starts the service again when needed
+        w.setDaemonMode(10 * 60 * 1000);
+    }
 
-        return a.exec();
+    if (parser.isSet("daemon") && !parser.isSet("copy") && !parser.isSet("move") && !parser.isSet("delete")
+        && !parser.isSet("resume")) {
+        qDebug() << "Waiting for jobs...";
     }
-    else if (parser.isSet("move")) {
-        qDebug() << "Moving files...";
-        QStringList args = parser.positionalArguments();
+    else if (parser.isSet("resume")) {
+        qDebug() << "Resuming from" << parser.value("resume");
+        if (!w.resumeJob(parser.value("resume"), parser.isSet("verify-completed"))) {
+            qWarning() << "Cannot resume from" << parser.value("resume");
+            return 1;
+        }
+    }
+    else if (parser.isSet("copy") || parser.isSet("move")) {
+        bool move = parser.isSet("move");
+        qDebug() << (move ? "Moving files..." : "Copying files...");
         if (args.size() < 2) {
-            qWarning() << "Usage: --move <source path> [<source path> ...] <target path>";
+            qWarning() << QString("Usage: --%1 <source path> [<source path> ...] <target path>").arg(move ? "move" : "copy");
             return 1;
         }
         QString targetPath = args.last();
@@ -70,45 +89,32 @@ int main(int argc, char *argv[])
         qDebug() << "Source paths:" << args;
         qDebug() << "Target path:" << targetPath;
 
-        // Perform the move operation
-        MainWindow w;
-        w.startCopyWithProgress(args, targetPath);
-        // Get the result of the operation
-        int result = a.exec();
-        qDebug() << "Result:" << result;
-        // If the result is 0, then the operation was successful
-        // TODO: We could do more checks here, e.g., if the target path exists,
-        // if its size matches the size of the source files, etc.
-        if (result == 0) {
-            QMessageBox::StandardButton reply = QMessageBox::question(
-                    nullptr,
-                    "Delete source files?",
-                    "Do you want to delete the following?\n\n" + args.join("\n"),
-                    QMessageBox::Yes | QMessageBox::No
-            );
-            if (reply == QMessageBox::Yes) {
-                qDebug() << "Deleting source files...";
-                // Recursively delete the source files
-                for (const QString &path : args) {
-                    QDir dir(path);
-                    if (dir.exists()) {
-                        dir.removeRecursively();
-                    }
-                    else {
-                        QFile file(path);
-                        if (file.exists()) {
-                            file.remove();
-                        }
-                    }
-                    if (QFile::exists(path)) {
-                        qWarning() << "Failed to delete" << path;
-                    }
-                }
-            }
+        w.startJob(move ? JobQueue::Move : JobQueue::Copy, args, targetPath);
+    }
+    else if (parser.isSet("delete")) {
+        qDebug() << "Deleting files...";
+        if (args.isEmpty()) {
+            qWarning() << "Usage: --delete <path> [<path> ...]";
+            return 1;
         }
+        qDebug() << "Paths:" << args;
+
+        w.startJob(JobQueue::Delete, args);
     }
     else {
-        qWarning() << "Please specify either --copy or --move.";
+        qWarning() << "Please specify either --copy, --move, --delete, --resume or --daemon.";
         return 1;
     }
+
+    // Center the jobs window on the screen
+    w.jobsWindow()->setGeometry(
+            QStyle::alignedRect(
+                    Qt::LeftToRight,
+                    Qt::AlignCenter,
+                    w.jobsWindow()->size(),
+                    desktop.availableGeometry() // Get screen geometry
+            )
+    );
+
+    return a.exec();
 }
@@ -1,24 +1,606 @@
-#include <sys/types.h>
+/**
+ * @file libfiler.c
+ * @brief Counts and times the system calls of Filer per thread and per trace span.
+ *
+ * Preload it to find out how many calls an operation like opening a folder takes:
+ *
+ *     LD_PRELOAD=/path/to/libfiler.so FILER_SYSCALLS=/tmp/syscalls.tsv Filer
+ *
+ * Filer reports its active trace span (see Trace.h) to the library when it finds it
+ * preloaded, so that calls are attributed to, e.g., "load-directory" or "icon". At exit,
+ * a summary is written as tab-separated values to the file named by FILER_SYSCALLS, or
+ * else to standard error: one line per thread, span and call, then the totals per span
+ * and per call. filer_syscalls_count() reads the totals while Filer runs.
+ *
+ * Processes started by Filer are not traced themselves; their execve() is counted for the
+ * thread and span that started them, because the counters live in memory that forked
+ * children share with Filer.
+ *
+ * Only calls that go through the dynamic symbols of libc are seen; calls that libc makes
+ * internally, e.g., the getdents() of readdir(), are not. readdir() is therefore counted
+ * on its own.
+ */
+
+// The fortified inline wrappers of the headers would clash with the definitions below
+#undef _FORTIFY_SOURCE
+#define _GNU_SOURCE
+
 #include <dirent.h>
-#include <stdio.h>
 #include <dlfcn.h>
-#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/xattr.h>
+#endif
+
+#ifdef __FreeBSD__
+#include <pthread_np.h>
+#include <sys/extattr.h>
+#endif
+
+#define EXPORT __attribute__((visibility("default")))
+#define THREAD_LOCAL __thread __attribute__((tls_model("initial-exec")))
+
+enum Call {
+    CallStat,
+    CallLstat,
+    CallStatx,
+    CallOpen,
+    CallGetdents,
+    CallReaddir,
+    CallGetxattr,
+    CallFork,
+    CallSpawn,
+    CallExecve,
+    CallCount
+};
+
+static const char* const callNames[CallCount] = {
+    "stat", "lstat", "statx", "open", "getdents", "readdir", "getxattr", "fork", "spawn", "execve"
+};
+
+#define MAX_ROWS 4096      /* Distinct pairs of thread and span in the whole process */
+#define THREAD_SLOTS 128   /* Distinct spans per thread */
+#define NO_ROOM (-1)
+
+struct Counter {
+    _Atomic uint64_t calls;
+    _Atomic uint64_t nanoseconds;
+};
+
+/* The calls of one thread while one span was active */
+struct Row {
+    pid_t thread;
+    const char* span;
+    char threadName[16];
+    _Atomic int ready;
+    struct Counter counters[CallCount];
+};
+
+struct Table {
+    _Atomic int rowCount;
+    _Atomic int droppedCalls;
+    struct Row rows[MAX_ROWS];
+};
+
+/* Maps the spans of a thread to their rows; row is the index plus one, 0 if the slot is free */
+struct Slot {
+    const char* span;
+    int row;
+};
+
+static struct Table* table = NULL;
+static pid_t tracedProcess = 0;
+static const char* (*_Atomic spanSource)(void) = NULL;
+
+static THREAD_LOCAL struct Slot threadSlots[THREAD_SLOTS];
+static THREAD_LOCAL int threadBusy; /* Set while the library itself makes calls, so that they are not counted */
+
+/**
+ * @brief Called by Filer with a function that returns the active span of the calling thread.
+ */
+EXPORT void filer_syscalls_set_span_source(const char* (*source)(void)) {
+    atomic_store_explicit(&spanSource, source, memory_order_release);
+}
+
+/**
+ * @brief Called by Filer, e.g., by its benchmarks, to read the counters while it runs.
+ * @param name A call as named in the summary, e.g., "stat" or "getdents".
+ * @return The number of such calls so far, of all threads and spans.
+ */
+EXPORT uint64_t filer_syscalls_count(const char* name) {
+    if (!table) {
+        return 0;
+    }
+    int rowCount = atomic_load(&table->rowCount);
+    if (rowCount > MAX_ROWS) {
+        rowCount = MAX_ROWS;
+    }
+    uint64_t calls = 0;
+    for (int call = 0; call < CallCount; call++) {
+        if (strcmp(callNames[call], name) != 0) {
+            continue;
+        }
+        for (int i = 0; i < rowCount; i++) {
+            struct Row* row = &table->rows[i];
+            if (atomic_load_explicit(&row->ready, memory_order_acquire)) {
+                calls += atomic_load(&row->counters[call].calls);
+            }
+        }
+    }
+    return calls;
+}
+
+static uint64_t nowNanoseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+static pid_t currentThread(void) {
+#if defined(__linux__)
+    return (pid_t)syscall(SYS_gettid);
+#elif defined(__FreeBSD__)
+    return (pid_t)pthread_getthreadid_np();
+#else
+    return getpid();
+#endif
+}
+
+static void currentThreadName(char name[16]) {
+    memset(name, 0, 16);
+#if defined(__linux__)
+    prctl(PR_GET_NAME, name, 0, 0, 0);
+#elif defined(__FreeBSD__)
+    pthread_get_name_np(pthread_self(), name, 16);
+#endif
+}
+
+static struct Row* rowForSpan(const char* span) {
+    uintptr_t first = ((uintptr_t)span >> 3) % THREAD_SLOTS;
+    for (int i = 0; i < THREAD_SLOTS; i++) {
+        struct Slot* slot = &threadSlots[(first + i) % THREAD_SLOTS];
+        if (slot->row != 0 && slot->span == span) {
+            return slot->row == NO_ROOM ? NULL : &table->rows[slot->row - 1];
+        }
+        if (slot->row == 0) {
+            int index = atomic_fetch_add_explicit(&table->rowCount, 1, memory_order_relaxed);
+            slot->span = span;
+            if (index >= MAX_ROWS) {
+                slot->row = NO_ROOM;
+                return NULL;
+            }
+            struct Row* row = &table->rows[index];
+            row->thread = currentThread();
+            row->span = span;
+            currentThreadName(row->threadName);
+            atomic_store_explicit(&row->ready, 1, memory_order_release);
+            slot->row = index + 1;
+            return row;
+        }
+    }
+    return NULL;
+}
+
+struct Measurement {
+    struct Row* row;
+    enum Call call;
+    uint64_t start;
+};
+
+static struct Measurement begin(enum Call call) {
+    struct Measurement measurement = {NULL, call, 0};
+    if (!table || threadBusy) {
+        return measurement;
+    }
+    threadBusy = 1;
+    const char* (*source)(void) = atomic_load_explicit(&spanSource, memory_order_acquire);
+    measurement.row = rowForSpan(source ? source() : NULL);
+    threadBusy = 0;
+    if (!measurement.row) {
+        atomic_fetch_add_explicit(&table->droppedCalls, 1, memory_order_relaxed);
+    }
+    measurement.start = nowNanoseconds();
+    return measurement;
+}
+
+static void end(struct Measurement measurement) {
+    if (!measurement.row) {
+        return;
+    }
+    struct Counter* counter = &measurement.row->counters[measurement.call];
+    atomic_fetch_add_explicit(&counter->calls, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counter->nanoseconds, nowNanoseconds() - measurement.start, memory_order_relaxed);
+}
+
+static void* resolve(const char* name) {
+    void* function = dlsym(RTLD_NEXT, name);
+    if (!function) {
+        errno = ENOSYS;
+    }
+    return function;
+}
+
+/*
+ * Defines a wrapper that counts and times the call, then calls the next definition of the function.
+ * The last arguments are the parameter list, the argument list and the value returned if the
+ * next definition cannot be found.
+ */
+#define INTERPOSE(returnType, name, call, parameters, arguments, failure) \
+    EXPORT returnType name parameters { \
+        static returnType (*real) parameters = NULL; \
+        if (!real && !(real = (returnType (*) parameters)resolve(#name))) { \
+            return failure; \
+        } \
+        struct Measurement measurement = begin(call); \
+        int savedErrno; \
+        returnType result = real arguments; \
+        savedErrno = errno; \
+        end(measurement); \
+        errno = savedErrno; \
+        return result; \
+    }
+
+/* stat and lstat */
+
+INTERPOSE(int, stat, CallStat, (const char* path, struct stat* buffer), (path, buffer), -1)
+INTERPOSE(int, lstat, CallLstat, (const char* path, struct stat* buffer), (path, buffer), -1)
+
+EXPORT int fstatat(int directory, const char* path, struct stat* buffer, int flags) {
+    static int (*real)(int, const char*, struct stat*, int) = NULL;
+    if (!real && !(real = (int (*)(int, const char*, struct stat*, int))resolve("fstatat"))) {
+        return -1;
+    }
+    struct Measurement measurement = begin((flags & AT_SYMLINK_NOFOLLOW) ? CallLstat : CallStat);
+    int result = real(directory, path, buffer, flags);
+    int savedErrno = errno;
+    end(measurement);
+    errno = savedErrno;
+    return result;
+}
+
+#ifdef __GLIBC__
+INTERPOSE(int, stat64, CallStat, (const char* path, struct stat64* buffer), (path, buffer), -1)
+INTERPOSE(int, lstat64, CallLstat, (const char* path, struct stat64* buffer), (path, buffer), -1)
+
+EXPORT int fstatat64(int directory, const char* path, struct stat64* buffer, int flags) {
+    static int (*real)(int, const char*, struct stat64*, int) = NULL;
+    if (!real && !(real = (int (*)(int, const char*, struct stat64*, int))resolve("fstatat64"))) {
+        return -1;
+    }
+    struct Measurement measurement = begin((flags & AT_SYMLINK_NOFOLLOW) ? CallLstat : CallStat);
+    int result = real(directory, path, buffer, flags);
+    int savedErrno = errno;
+    end(measurement);
+    errno = savedErrno;
+    return result;
+}
+
+/* Before glibc 2.33, stat() and lstat() were inline wrappers around these */
+int __xstat(int version, const char* path, struct stat* buffer);
+int __lxstat(int version, const char* path, struct stat* buffer);
+int __xstat64(int version, const char* path, struct stat64* buffer);
+int __lxstat64(int version, const char* path, struct stat64* buffer);
+
+INTERPOSE(int, __xstat, CallStat, (int version, const char* path, struct stat* buffer), (version, path, buffer), -1)
+INTERPOSE(int, __lxstat, CallLstat, (int version, const char* path, struct stat* buffer), (version, path, buffer), -1)
+INTERPOSE(int, __xstat64, CallStat, (int version, const char* path, struct stat64* buffer), (version, path, buffer), -1)
+INTERPOSE(int, __lxstat64, CallLstat, (int version, const char* path, struct stat64* buffer), (version, path, buffer), -1)
+#endif
+
+#if defined(__linux__) && defined(STATX_BASIC_STATS)
+INTERPOSE(int, statx, CallStatx,
+          (int directory, const char* path, int flags, unsigned int mask, struct statx* buffer),
+          (directory, path, flags, mask, buffer), -1)
+#endif
+
+/* open */
+
+// The mode is only passed when a file may be created
+static int takesMode(int flags) {
+#ifdef O_TMPFILE
+    if ((flags & O_TMPFILE) == O_TMPFILE) {
+        return 1;
+    }
+#endif
+    return (flags & O_CREAT) != 0;
+}
+
+#define INTERPOSE_OPEN(name) \
+    EXPORT int name(const char* path, int flags, ...) { \
+        static int (*real)(const char*, int, ...) = NULL; \
+        if (!real && !(real = (int (*)(const char*, int, ...))resolve(#name))) { \
+            return -1; \
+        } \
+        mode_t mode = 0; \
+        if (takesMode(flags)) { \
+            va_list arguments; \
+            va_start(arguments, flags); \
+            mode = (mode_t)va_arg(arguments, int); \
+            va_end(arguments); \
+        } \
+        struct Measurement measurement = begin(CallOpen); \
+        int result = real(path, flags, mode); \
+        int savedErrno = errno; \
+        end(measurement); \
+        errno = savedErrno; \
+        return result; \
+    }
+
+#define INTERPOSE_OPENAT(name) \
+    EXPORT int name(int directory, const char* path, int flags, ...) { \
+        static int (*real)(int, const char*, int, ...) = NULL; \
+        if (!real && !(real = (int (*)(int, const char*, int, ...))resolve(#name))) { \
+            return -1; \
+        } \
+        mode_t mode = 0; \
+        if (takesMode(flags)) { \
+            va_list arguments; \
+            va_start(arguments, flags); \
+            mode = (mode_t)va_arg(arguments, int); \
+            va_end(arguments); \
+        } \
+        struct Measurement measurement = begin(CallOpen); \
+        int result = real(directory, path, flags, mode); \
+        int savedErrno = errno; \
+        end(measurement); \
+        errno = savedErrno; \
+        return result; \
+    }
+
+INTERPOSE_OPEN(open)
+INTERPOSE_OPENAT(openat)
+#ifdef __GLIBC__
+INTERPOSE_OPEN(open64)
+INTERPOSE_OPENAT(openat64)
+#endif
+
+/* Directory listings */
+
+INTERPOSE(struct dirent*, readdir, CallReaddir, (DIR* directory), (directory), NULL)
+#ifdef __GLIBC__
+INTERPOSE(struct dirent64*, readdir64, CallReaddir, (DIR* directory), (directory), NULL)
+#if __GLIBC_PREREQ(2, 30)
+INTERPOSE(ssize_t, getdents64, CallGetdents, (int fd, void* buffer, size_t length), (fd, buffer, length), -1)
+#endif
+#endif
+
+/* Extended attributes */
+
+#ifdef __linux__
+INTERPOSE(ssize_t, getxattr, CallGetxattr,
+          (const char* path, const char* name, void* value, size_t size), (path, name, value, size), -1)
+INTERPOSE(ssize_t, lgetxattr, CallGetxattr,
+          (const char* path, const char* name, void* value, size_t size), (path, name, value, size), -1)
+INTERPOSE(ssize_t, fgetxattr, CallGetxattr,
+          (int fd, const char* name, void* value, size_t size), (fd, name, value, size), -1)
+#endif
+
+#ifdef __FreeBSD__
+INTERPOSE(ssize_t, extattr_get_file, CallGetxattr,
+          (const char* path, int attributeNamespace, const char* name, void* data, size_t size),
+          (path, attributeNamespace, name, data, size), -1)
+INTERPOSE(ssize_t, extattr_get_link, CallGetxattr,
+          (const char* path, int attributeNamespace, const char* name, void* data, size_t size),
+          (path, attributeNamespace, name, data, size), -1)
+INTERPOSE(ssize_t, extattr_get_fd, CallGetxattr,
+          (int fd, int attributeNamespace, const char* name, void* data, size_t size),
+          (fd, attributeNamespace, name, data, size), -1)
+#endif
+
+/* Processes; vfork() cannot be wrapped because the child would return through the stack of the parent */
+
+EXPORT pid_t fork(void) {
+    static pid_t (*real)(void) = NULL;
+    if (!real && !(real = (pid_t (*)(void))resolve("fork"))) {
+        return -1;
+    }
+    struct Measurement measurement = begin(CallFork);
+    pid_t result = real();
+    int savedErrno = errno;
+    // The child shares the counters and must not count the call a second time
+    if (result != 0) {
+        end(measurement);
+    }
+    errno = savedErrno;
+    return result;
+}
+
+INTERPOSE(int, posix_spawn, CallSpawn,
+          (pid_t* pid, const char* path, const posix_spawn_file_actions_t* actions,
+           const posix_spawnattr_t* attributes, char* const arguments[], char* const environment[]),
+          (pid, path, actions, attributes, arguments, environment), ENOSYS)
+INTERPOSE(int, posix_spawnp, CallSpawn,
+          (pid_t* pid, const char* file, const posix_spawn_file_actions_t* actions,
+           const posix_spawnattr_t* attributes, char* const arguments[], char* const environment[]),
+          (pid, file, actions, attributes, arguments, environment), ENOSYS)
+
+/*
+ * A successful exec does not return, so the call is counted before it is made and its time is
+ * not measured
+ */
+#define INTERPOSE_EXEC(name, parameters, arguments) \
+    EXPORT int name parameters { \
+        static int (*real) parameters = NULL; \
+        if (!real && !(real = (int (*) parameters)resolve(#name))) { \
+            return -1; \
+        } \
+        end(begin(CallExecve)); \
+        return real arguments; \
+    }
+
+INTERPOSE_EXEC(execve, (const char* path, char* const arguments[], char* const environment[]),
+               (path, arguments, environment))
+INTERPOSE_EXEC(execv, (const char* path, char* const arguments[]), (path, arguments))
+INTERPOSE_EXEC(execvp, (const char* file, char* const arguments[]), (file, arguments))
+#ifdef __GLIBC__
+INTERPOSE_EXEC(execvpe, (const char* file, char* const arguments[], char* const environment[]),
+               (file, arguments, environment))
+#endif
+
+/* Setup and summary */
+
+// Removes this library from LD_PRELOAD, so that the processes that Filer starts are not traced
+static void removeFromPreload(void) {
+    const char* preload = getenv("LD_PRELOAD");
+    if (!preload) {
+        return;
+    }
+    char* remaining = malloc(strlen(preload) + 1);
+    if (!remaining) {
+        return;
+    }
+    remaining[0] = '\0';
+    const char* entry = preload;
+    while (*entry) {
+        size_t length = strcspn(entry, ": ");
+        int isThisLibrary = length >= 11 && strncmp(entry + length - 11, "libfiler.so", 11) == 0;
+        if (length > 0 && !isThisLibrary) {
+            if (remaining[0]) {
+                strcat(remaining, ":");
+            }
+            strncat(remaining, entry, length);
+        }
+        entry += length;
+        if (*entry) {
+            entry++;
+        }
+    }
+    if (remaining[0]) {
+        setenv("LD_PRELOAD", remaining, 1);
+    } else {
+        unsetenv("LD_PRELOAD");
+    }
+    free(remaining);
+}
+
+__attribute__((constructor)) static void initialize(void) {
+    threadBusy = 1;
+    // Shared with forked children, so that their calls before exec are counted too
+    void* memory = mmap(NULL, sizeof(struct Table), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        fprintf(stderr, "libfiler: cannot allocate the counters: %s\n", strerror(errno));
+    } else {
+        table = memory;
+        tracedProcess = getpid();
+    }
+    removeFromPreload();
+    threadBusy = 0;
+}
+
+static const char* spanName(const char* span) {
+    return span ? span : "-";
+}
+
+static int sameSpan(const char* span1, const char* span2) {
+    // The same name may be stored at different addresses in different translation units
+    return span1 == span2 || (span1 && span2 && strcmp(span1, span2) == 0);
+}
+
+static double microseconds(uint64_t nanoseconds) {
+    return (double)nanoseconds / 1000.0;
+}
+
+__attribute__((destructor)) static void summarize(void) {
+    // Forked children that exit without exec must not write a summary of their own
+    if (!table || getpid() != tracedProcess) {
+        return;
+    }
+    threadBusy = 1;
+
+    FILE* output = stderr;
+    const char* path = getenv("FILER_SYSCALLS");
+    if (path && *path) {
+        output = fopen(path, "w");
+        if (!output) {
+            fprintf(stderr, "libfiler: cannot write %s: %s\n", path, strerror(errno));
+            output = stderr;
+        }
+    }
+
+    int rowCount = atomic_load(&table->rowCount);
+    if (rowCount > MAX_ROWS) {
+        rowCount = MAX_ROWS;
+    }
+
+    fprintf(output, "# System calls of process %d\n", (int)tracedProcess);
+    fprintf(output, "thread\tthread_name\tspan\tcall\tcalls\tmicroseconds\n");
+    for (int i = 0; i < rowCount; i++) {
+        struct Row* row = &table->rows[i];
+        if (!atomic_load_explicit(&row->ready, memory_order_acquire)) {
+            continue;
+        }
+        for (int call = 0; call < CallCount; call++) {
+            uint64_t calls = atomic_load(&row->counters[call].calls);
+            if (calls > 0) {
+                fprintf(output, "%d\t%s\t%s\t%s\t%llu\t%.1f\n", (int)row->thread, row->threadName,
+                        spanName(row->span), callNames[call], (unsigned long long)calls,
+                        microseconds(atomic_load(&row->counters[call].nanoseconds)));
+            }
+        }
+    }
+
+    fprintf(output, "\n# Per span\nspan\tcall\tcalls\tmicroseconds\n");
+    for (int i = 0; i < rowCount; i++) {
+        struct Row* row = &table->rows[i];
+        if (!atomic_load_explicit(&row->ready, memory_order_acquire)) {
+            continue;
+        }
+        int seen = 0;
+        for (int j = 0; j < i && !seen; j++) {
+            seen = atomic_load(&table->rows[j].ready) && sameSpan(table->rows[j].span, row->span);
+        }
+        if (seen) {
+            continue;
+        }
+        for (int call = 0; call < CallCount; call++) {
+            uint64_t calls = 0;
+            uint64_t nanoseconds = 0;
+            for (int j = i; j < rowCount; j++) {
+                if (atomic_load(&table->rows[j].ready) && sameSpan(table->rows[j].span, row->span)) {
+                    calls += atomic_load(&table->rows[j].counters[call].calls);
+                    nanoseconds += atomic_load(&table->rows[j].counters[call].nanoseconds);
+                }
+            }
+            if (calls > 0) {
+                fprintf(output, "%s\t%s\t%llu\t%.1f\n", spanName(row->span), callNames[call],
+                        (unsigned long long)calls, microseconds(nanoseconds));
+            }
+        }
+    }
+
+    fprintf(output, "\n# Total\ncall\tcalls\tmicroseconds\n");
+    for (int call = 0; call < CallCount; call++) {
+        uint64_t calls = 0;
+        uint64_t nanoseconds = 0;
+        for (int i = 0; i < rowCount; i++) {
+            calls += atomic_load(&table->rows[i].counters[call].calls);
+            nanoseconds += atomic_load(&table->rows[i].counters[call].nanoseconds);
+        }
+        fprintf(output, "%s\t%llu\t%.1f\n", callNames[call], (unsigned long long)calls, microseconds(nanoseconds));
+    }
+
+    int dropped = atomic_load(&table->droppedCalls);
+    if (dropped > 0) {
+        fprintf(output, "\n# %d calls were not counted because there were too many threads and spans\n", dropped);
+    }
 
-typedef struct _dirdesc {
-    int dd_fd;
-    long dd_loc;
-    long dd_size;
-    char *dd_buf;
-    int dd_len;
-    off_t dd_seek;
-    void *dd_lock;
-    int dd_magic;
-} DIRDESC;
-
-typedef struct my_dirent {
-    ino_t d_ino;
-    off_t d_off;
-    unsigned short d_reclen;
-    unsigned char d_type;
-    char
+    if (output != stderr) {
+        fclose(output);
+    }
+}
@@ -41,6 +41,7 @@
 #include <QLabel>
 #include <QVBoxLayout>
 #include "FileManagerMainWindow.h"
+#include "WindowPool.h"
 #include "DBusInterface.h"
 #include "ElfSizeCalculator.h"
 #include "SqshArchiveReader.h"
@@ -50,48 +51,120 @@
 #include <QDBusInterface>
 #include <QDeadlineTimer>
 #include "TrashHandler.h"
+#include "TrashIndex.h"
+#include "MountMonitor.h"
 #include "AppGlobals.h"
 #include <QScreen>
+#include <QTimer>
+#include <QWindow>
+#include <functional>
+#include <memory>
+#include "Trace.h"
+#include "TaskRuntime.h"
+#include "StallWatchdog.h"
 #include <QPainter>
 
+/**
+ * @brief Runs work on the task runtime and then continues on the main thread.
+ */
+static void runInBackground(TaskRuntime::Lane lane, const std::function<void()>& work, const std::function<void()>& then) {
+    TaskRuntime::instance()->run(lane, qApp, [work](const CancellationToken&) { work(); }, then);
+}
+
+/**
+ * @brief Calls a function once the window has been painted for the first time.
+ */
+class FirstPaintFilter : public QObject {
+public:
+    FirstPaintFilter(QWindow* window, const std::function<void()>& then) : QObject(window), m_then(then) {
+        window->installEventFilter(this);
+    }
+
+    bool eventFilter(QObject* watched, QEvent* event) override {
+        if (event->type() == QEvent::Expose && static_cast<QWindow*>(watched)->isExposed()) {
+            watched->removeEventFilter(this);
+            // The window paints while handling the expose event, so continue right afterwards
+            std::function<void()> then = m_then;
+            QTimer::singleShot(0, qApp, [then]() {
+                Trace::mark("first-paint");
+                then();
+            });
+            deleteLater();
+        }
+        return false;
+    }
+
+private:
+    std::function<void()> m_then;
+};
+
 void displayPicturesOnAllScreens(QApplication &app) {
 
     if (!QFileInfo(AppGlobals::desktopPicturePath).exists()) {
         return;
     }
 
-    QList<QScreen*> screens = app.screens();
-
-    for (QScreen *screen : screens) {
-        QRect screenGeometry = screen->geometry();
-        QPixmap desktopPixmap = QPixmap(AppGlobals::desktopPicturePath);
-        // Create a QLabel to display the picture
-        QLabel *label = new QLabel;
-        label->setPixmap(desktopPixmap.scaled(screenGeometry.size(), Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation));
-        // Create a top-level window for each screen
-        QWidget *window = new QWidget;
-        QVBoxLayout *layout = new QVBoxLayout;
-        layout->addWidget(label);
-        layout->setContentsMargins(0, 0, 0, 0);
-        layout->setSpacing(0);
-        window->setContentsMargins(0, 0, 0, 0);
-        window->setLayout(layout);
-        window->setGeometry(screenGeometry);
-        window->show();
-        window->setFixedSize(screenGeometry.size());
-        window->setAttribute(Qt::WA_X11NetWmWindowTypeDesktop, true);
-        // Make invisible to the taskbar = Menu
-        window->setAttribute(Qt::WA_X11DoNotAcceptFocus, true);
-        // No window decorations = will not show up in Menu as a window
-        window->setWindowFlags(Qt::FramelessWindowHint);
-        // Make it an auxiliary window, not a top-level window
-        window->setWindowFlags(Qt::Tool);
+    // Decode and scale the picture in the background; only the pixmaps and windows
+    // have to be created on the main thread
+    QList<QRect> screenGeometries;
+    for (QScreen *screen : app.screens()) {
+        screenGeometries << screen->geometry();
     }
+    std::shared_ptr<QList<QImage>> pictures = std::make_shared<QList<QImage>>();
+
+    runInBackground(TaskRuntime::Interactive, [screenGeometries, pictures]() {
+        QImage desktopPicture(AppGlobals::desktopPicturePath);
+        for (const QRect &screenGeometry : screenGeometries) {
+            pictures->append(desktopPicture.scaled(screenGeometry.size(), Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation));
+        }
+        Trace::mark("desktop-picture-decoded");
+    }, [screenGeometries, pictures]() {
+        for (int i = 0; i < screenGeometries.size() && i < pictures->size(); i++) {
+            QRect screenGeometry = screenGeometries.at(i);
+            // Create a QLabel to display the picture
+            QLabel *label = new QLabel;
+            label->setPixmap(QPixmap::fromImage(pictures->at(i)));
+            // Create a top-level window for each screen
+            QWidget *window = new QWidget;
+            QVBoxLayout *layout = new QVBoxLayout;
+            layout->addWidget(label);
+            layout->setContentsMargins(0, 0, 0, 0);
+            layout->setSpacing(0);
+            window->setContentsMargins(0, 0, 0, 0);
+            window->setLayout(layout);
+            window->setGeometry(screenGeometry);
+            window->show();
+            window->setFixedSize(screenGeometry.size());
+            window->setAttribute(Qt::WA_X11NetWmWindowTypeDesktop, true);
+            // Make invisible to the taskbar = Menu
+            window->setAttribute(Qt::WA_X11DoNotAcceptFocus, true);
+            // No window decorations = will not show up in Menu as a window
+            window->setWindowFlags(Qt::FramelessWindowHint);
+            // Make it an auxiliary window, not a top-level window
+            window->setWindowFlags(Qt::Tool);
+        }
+        Trace::mark("desktop-picture-shown");
+    });
 }
 
 int main(int argc, char *argv[])
 {
+    // Record the stages of the startup, so that regressions in the time to the first paint can be measured
+    Trace::begin(Trace::defaultPath());
+
     QApplication app(argc, argv);
+    Trace::mark("application-created");
+
+    // Log where the GUI thread gets stuck if FILER_STALL_WATCHDOG is set
+    StallWatchdog::startFromEnvironment();
+
+    // Write the trace spans for Perfetto or chrome://tracing at exit if FILER_TRACE is set
+    if (qEnvironmentVariableIsSet("FILER_TRACE")) {
+        QString tracePath = QString::fromLocal8Bit(qgetenv("FILER_TRACE"));
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, [tracePath]() {
+            Trace::writeChromeTrace(tracePath);
+        });
+    }
 
     QDBusConnection connection = QDBusConnection::sessionBus();
 
@@ -154,9 +227,6 @@ int main(int argc, char *argv[])
     } else {
         // No arguments were passed to the application
 
-        // On all screens, draw the desktop picture
-        displayPicturesOnAllScreens(app);
-
         // Check whether another instance of a file manager is already running
         // by checking whether the D-Bus ""org.freedesktop.FileManager1" service is available
         if (! connection.interface()->isServiceRegistered("org.freedesktop.FileManager1")) {
@@ -166,6 +236,9 @@ int main(int argc, char *argv[])
                                   QObject::tr("Another file manager is already running.\nPlease quit it first."));
             return 0;
         }
+
+        // On all screens, draw the desktop picture once it is decoded
+        displayPicturesOnAllScreens(app);
     }
 
     // On systems that are supposed to have a global menu bar, wait for the
@@ -221,43 +294,109 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    // The icon provider asks these from the thread that QFileSystemModel gathers file information on,
+    // so they must exist before the first window does
+    MountMonitor::create();
+    TrashIndex::create();
+    Trace::mark("indexes-created");
+
+    // Run the external probes in the background while the Desktop window comes up;
+    // until they have finished, the results of the previous run are used
+    struct VolumeProbes {
+        QString mediaPath;
+        QString rootDiskName;
+        int pending = 2; // Only counted on the GUI thread
+    };
+    std::shared_ptr<VolumeProbes> volumeProbes = std::make_shared<VolumeProbes>();
+    auto volumeProbeFinished = [volumeProbes, &app]() {
+        if (--volumeProbes->pending > 0) {
+            return;
+        }
+        // Show volumes on the Desktop
+        // FIXME: Replace this by a QProxyModel or something more appropriate
+
+        // Symlink volumes that are mounted in the media path to ~/Desktop, and remove
+        // the symlinks again when they are unmounted
+        new VolumeWatcher(volumeProbes->rootDiskName, &app);
+        Trace::mark("volume-watcher-ready");
+    };
+    runInBackground(TaskRuntime::Prefetch, [volumeProbes]() {
+        volumeProbes->mediaPath = VolumeWatcher::getMediaPath();
+        Trace::mark("media-path-probed");
+    }, [volumeProbes, volumeProbeFinished]() {
+        // The media path is remembered for the next start
+        AppGlobals::setMediaPath(volumeProbes->mediaPath);
+        volumeProbeFinished();
+    });
+    runInBackground(TaskRuntime::Prefetch, [volumeProbes]() {
+        volumeProbes->rootDiskName = VolumeWatcher::probeRootDiskName();
+        Trace::mark("root-disk-name-probed");
+    }, [volumeProbes, volumeProbeFinished]() {
+        AppGlobals::setRootDiskName(volumeProbes->rootDiskName);
+        volumeProbeFinished();
+    });
+
     // Run "open" without arguments and get its output; check
     // whether it is our version of open and not e.g., xdg-open.
     // Running the "open" command without arguments also populates
     // the launch "database", which is needed for the "launch"
     // command to work and for Filer to be able to draw proper document icons.
-    QProcess openProcess;
-    openProcess.setProcessChannelMode(QProcess::MergedChannels);
-    openProcess.start("open");
-    openProcess.waitForFinished();
-    QString openOutput = openProcess.readAllStandardOutput();
-    if (openOutput.contains("pen <document to be opened>")) {
-        // Found
-    } else {
-        // Not found
-        QMessageBox::critical(0, "Filer", QString("The 'open' command is not the one from https://github.com/helloSystem/launch/. Please install it."));
-        return 1;
-    }
-
-    // Make FileManager1 available on D-Bus
-    DBusInterface dbusInterface;
+    std::shared_ptr<QString> openOutput = std::make_shared<QString>();
+    runInBackground(TaskRuntime::Prefetch, [openOutput]() {
+        QProcess openProcess;
+        openProcess.setProcessChannelMode(QProcess::MergedChannels);
+        openProcess.start("open");
+        openProcess.waitForFinished();
+        *openOutput = openProcess.readAllStandardOutput();
+        Trace::mark("open-probed");
+    }, [openOutput, &app]() {
+        if (openOutput->contains("pen <document to be opened>")) {
+            // Found
+        } else {
+            // Not found
+            QMessageBox::critical(0, "Filer", QString("The 'open' command is not the one from https://github.com/helloSystem/launch/. Please install it."));
+            app.exit(1);
+        }
+    });
 
     // Create a FileManagerTreeView instance at ~/Desktop
     FileManagerMainWindow mainWindow;
+    Trace::mark("desktop-window-created");
 
     // Show the main window
     mainWindow.show();
+    Trace::mark("desktop-window-shown");
 
-    // Show volumes on the Desktop
-    // FIXME: Replace this by a QProxyModel or something more appropriate
-
-    // Install a QFileSystemWatcher on /media, and whenever a new directory appears, symlink it to ~/Desktop
-    // when a directory disappears, remove the symlink
-    VolumeWatcher watcher;
-
-    // Tell the application to reload the desktop whenever
-    // something changes in the trash directory
-    TrashHandler trashHandler;
+    // Everything else is set up once the Desktop has been painted
+    bool deferredStarted = false;
+    auto startDeferred = [&app, &deferredStarted]() {
+        if (deferredStarted) {
+            return;
+        }
+        deferredStarted = true;
+
+        // Make FileManager1 available on D-Bus
+        DBusInterface *dbusInterface = new DBusInterface();
+        dbusInterface->setParent(&app);
+        Trace::mark("dbus-registered");
+
+        // Start the file operation service now so that it is ready by the time
+        // the user first copies or moves something
+        FileOperationManager::startService();
+
+        // Tell the application to reload the desktop whenever
+        // something changes in the trash directory
+        new TrashHandler();
+
+        // Have folder windows ready before the user opens the first folder
+        WindowPool::instance()->refill();
+        Trace::mark("deferred-initialization-finished");
+    };
+    if (mainWindow.windowHandle()) {
+        new FirstPaintFilter(mainWindow.windowHandle(), startDeferred);
+    }
+    // In case the window is never exposed, e.g., because it is on a hidden workspace
+    QTimer::singleShot(1000, &app, startDeferred);
 
     return app.exec();
 }
\ No newline at end of file